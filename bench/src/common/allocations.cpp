@@ -0,0 +1,37 @@
+#include <common/allocations.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<uint64_t> allocations{0};
+
+}  // namespace
+
+namespace monkey::bench {
+
+uint64_t allocation_count() {
+  return allocations.load(std::memory_order_relaxed);
+}
+
+}  // namespace monkey::bench
+
+// The array and nothrow forms default to these two, and the aligned forms
+// are not used by the front end.
+void* operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (auto* memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept {
+  std::free(memory);
+}
@@ -0,0 +1,15 @@
+#ifndef MONKEY_BENCH_ALLOCATIONS_H_
+#define MONKEY_BENCH_ALLOCATIONS_H_
+
+#include <cstdint>
+
+namespace monkey::bench {
+
+// Number of calls to the global operator new so far in this process. Every
+// benchmark binary links allocations.cpp, which replaces the allocation
+// functions to keep the count.
+uint64_t allocation_count();
+
+}  // namespace monkey::bench
+
+#endif  // MONKEY_BENCH_ALLOCATIONS_H_
@@ -0,0 +1,173 @@
+#ifndef MONKEY_BENCH_CORPUS_H_
+#define MONKEY_BENCH_CORPUS_H_
+
+#include <fmt/core.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace monkey::bench {
+
+// Programs with a given bias, for measuring how the front end scales with
+// each kind of construct.
+enum class Shape {
+  // A blend of bindings, functions, conditionals and literals.
+  kMixed,
+  // Expressions nested dozens of levels deep.
+  kDeepNesting,
+  // Kilobyte-long string literals.
+  kLongStrings,
+  // Arrays and hashes with thousands of elements.
+  kLargeLiterals,
+  // Many small function definitions and calls.
+  kManyFunctions,
+};
+
+// splitmix64. The standard engines are portable but their distributions are
+// not, and the corpus must be byte-identical everywhere for results to be
+// comparable across machines.
+class Random {
+ public:
+  explicit Random(uint64_t seed) : state_(seed) {}
+
+  uint64_t next() {
+    auto z = (state_ += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+  // Uniform enough in [0, bound) for bounds this small.
+  size_t below(size_t bound) { return next() % bound; }
+
+ private:
+  uint64_t state_;
+};
+
+// Identifiers may only contain letters and underscores, so spell the index
+// out in base 26.
+inline std::string make_name(std::string_view prefix, size_t index) {
+  auto name = std::string(prefix);
+  do {
+    name += static_cast<char>('a' + index % 26);
+    index /= 26;
+  } while (index != 0);
+  return name;
+}
+
+namespace detail {
+
+inline void append_nested(std::string& out, Random& random, size_t depth) {
+  if (depth == 0) {
+    out += random.below(2) == 0 ? "x" : fmt::format("{}", random.below(1000));
+    return;
+  }
+  switch (random.below(6)) {
+    case 0:
+      out += fmt::format("if (x < {}) {{ ", random.below(100));
+      append_nested(out, random, depth - 1);
+      out += " } else { x }";
+      break;
+    case 1:
+      out += "fn(x) { ";
+      append_nested(out, random, depth - 1);
+      out += " }(x)";
+      break;
+    case 2:
+      out += "[";
+      append_nested(out, random, depth - 1);
+      out += ", x][0]";
+      break;
+    case 3:
+      out += "{\"k\": ";
+      append_nested(out, random, depth - 1);
+      out += "}[\"k\"]";
+      break;
+    case 4:
+      out += "-(";
+      append_nested(out, random, depth - 1);
+      out += ")";
+      break;
+    default:
+      out += "(x * ";
+      append_nested(out, random, depth - 1);
+      out += fmt::format(" + {})", random.below(10));
+      break;
+  }
+}
+
+inline void append_statement(std::string& out, Shape shape, Random& random,
+                             size_t i) {
+  switch (shape) {
+    case Shape::kMixed:
+      out += fmt::format(
+          "let {0} = fn(x, y) {{ if (x < y) {{ return x * {1} + y; }} "
+          "else {{ x - y / 2 }} }};\n"
+          "let {2} = {{\"key\": [1, 2, {1}], \"flag\": !true}};\n"
+          "{0}({2}[\"key\"][2], -{1}) == \"{1}\";\n",
+          make_name("f_", i), random.below(1000), make_name("t_", i));
+      break;
+    case Shape::kDeepNesting:
+      out += fmt::format("let {} = fn(x) {{ ", make_name("deep_", i));
+      append_nested(out, random, 32 + random.below(32));
+      out += " };\n";
+      break;
+    case Shape::kLongStrings: {
+      const auto size = 1024 + random.below(15 * 1024);
+      out += fmt::format("let {} = \"", make_name("text_", i));
+      for (size_t j = 0; j < size; ++j) {
+        const auto c = random.below(27);
+        out += c == 26 ? ' ' : static_cast<char>('a' + c);
+      }
+      out += "\";\n";
+      break;
+    }
+    case Shape::kLargeLiterals: {
+      const auto size = 1024 + random.below(4096);
+      if (i % 2 == 0) {
+        out += fmt::format("let {} = [", make_name("array_", i));
+        for (size_t j = 0; j < size; ++j) {
+          out += fmt::format("{}{}", j == 0 ? "" : ", ", random.next() >> 33);
+        }
+        out += "];\n";
+      } else {
+        out += fmt::format("let {} = {{", make_name("hash_", i));
+        for (size_t j = 0; j < size / 4; ++j) {
+          out += fmt::format("{}\"{}\": {}", j == 0 ? "" : ", ",
+                             make_name("", random.next() >> 40), j);
+        }
+        out += "};\n";
+      }
+      break;
+    }
+    case Shape::kManyFunctions: {
+      const auto name = make_name("fun_", i);
+      out += fmt::format(
+          "let {0} = fn(a, b, c) {{ let t = a * b; return t + c; }};\n"
+          "{0}({1}, {2}, {0}(1, 2, 3));\n",
+          name, random.below(100), random.below(100));
+      break;
+    }
+  }
+}
+
+}  // namespace detail
+
+// Generates a syntactically valid program of at least `target_size` bytes.
+// The output depends only on the arguments.
+inline std::string generate(Shape shape, size_t target_size,
+                            uint64_t seed = 1) {
+  auto random = Random(seed);
+  std::string out;
+  out.reserve(target_size + 64 * 1024);
+  for (size_t i = 0; out.size() < target_size; ++i) {
+    detail::append_statement(out, shape, random, i);
+  }
+  return out;
+}
+
+}  // namespace monkey::bench
+
+#endif  // MONKEY_BENCH_CORPUS_H_
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+#include <common/allocations.h>
+#include <monkey/ast/ast.h>
+#include <monkey/eval/compiled.h>
+#include <monkey/eval/eval.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+#include <monkey/parser/parser.h>
+#include <monkey/vm/vm.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Runs the same scripts on the tree-walking evaluator, the bytecode machine
+// and the closure compiler. Parsing happens once, outside the timed loop;
+// compiling is part of every vm and closure run, as it is when the driver
+// runs a script.
+
+namespace monkey::bench {
+
+enum class Engine { kAst, kVm, kClosure };
+
+// Calls all the way down: frames, arguments and returns.
+constexpr auto kRecursion = R"(
+let fib = fn(n) { if (n < 2) { return n; } fib(n - 1) + fib(n - 2) };
+fib(20);
+)";
+
+// Integer arithmetic on locals, with a call per step since Monkey has no
+// loops.
+constexpr auto kArithmetic = R"(
+let score = fn(a, b, c) {
+  let base = a * 3 + b * 2 - c;
+  let bonus = if (base > 100) { base / 4 } else { 0 };
+  let penalty = (a - b) * (a - b) / (c + 1);
+  base + bonus - penalty + (a * b - c * 2) * 7 / 3
+};
+let loop = fn(i, acc) {
+  if (i == 0) { return acc; }
+  loop(i - 1, acc + score(i, i * 2 + 1, i / 3 + 5) - score(i / 2, i, 7))
+};
+loop(2000, 0);
+)";
+
+// Closures reading captured values and frames.
+constexpr auto kClosures = R"(
+let make = fn(a) {
+  let b = a + 1;
+  fn(c) {
+    let loop = fn(i, acc) {
+      if (i == 0) { acc } else { loop(i - 1, acc + a + b + c) }
+    };
+    loop(2000, 0)
+  }
+};
+make(1)(2);
+)";
+
+static void BM_Engine(benchmark::State& state, const char* script,
+                      Engine engine) {
+  auto lexer = lexer::Lexer(std::string(script));
+  const auto program = parser::Parser(lexer).parse_program();
+  uint64_t allocations = 0;
+  for (auto _ : state) {
+    auto env = std::make_shared<object::Env>();
+    const auto before = allocation_count();
+    std::shared_ptr<object::Object> result;
+    switch (engine) {
+      case Engine::kAst:
+        result = eval::eval(*program, env);
+        break;
+      case Engine::kVm:
+        result = vm::run(*program, env);
+        break;
+      case Engine::kClosure:
+        result = eval::evalCompiled(*program, env);
+        break;
+    }
+    allocations += allocation_count() - before;
+    benchmark::DoNotOptimize(result.get());
+  }
+  state.counters["allocs"] = static_cast<double>(allocations) /
+                             static_cast<double>(state.iterations());
+}
+
+#define MONKEY_ENGINE_BENCHMARKS(name, script)                             \
+  BENCHMARK_CAPTURE(BM_Engine, name##_ast, script, Engine::kAst)           \
+      ->Unit(benchmark::kMillisecond);                                     \
+  BENCHMARK_CAPTURE(BM_Engine, name##_vm, script, Engine::kVm)             \
+      ->Unit(benchmark::kMillisecond);                                     \
+  BENCHMARK_CAPTURE(BM_Engine, name##_closure, script, Engine::kClosure)   \
+      ->Unit(benchmark::kMillisecond)
+
+MONKEY_ENGINE_BENCHMARKS(recursion, kRecursion);
+MONKEY_ENGINE_BENCHMARKS(arithmetic, kArithmetic);
+MONKEY_ENGINE_BENCHMARKS(closures, kClosures);
+
+}  // namespace monkey::bench
+
+BENCHMARK_MAIN();
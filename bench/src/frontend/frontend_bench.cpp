@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+#include <common/allocations.h>
+#include <common/corpus.h>
+#include <monkey/ast/arena.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/lexer/token.h>
+#include <monkey/parser/parser.h>
+#include <monkey/parser/reader.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Front-end throughput over generated corpora, one benchmark per stage and
+// shape. Each reports bytes/s, tokens/s and allocations per token, and the
+// parser nodes/s as well. Run with --benchmark_format=json, or build the
+// bench-json target, to get results that can be diffed across commits.
+
+namespace monkey::bench {
+
+constexpr int64_t kCorpusSize = int64_t{1} << 22;
+
+// Totals over the timed part of every iteration.
+struct Totals {
+  int64_t bytes = 0;
+  int64_t tokens = 0;
+  int64_t nodes = 0;
+  uint64_t allocations = 0;
+};
+
+void report(benchmark::State& state, const Totals& totals) {
+  state.SetBytesProcessed(totals.bytes);
+  state.counters["tokens"] = benchmark::Counter(
+      static_cast<double>(totals.tokens), benchmark::Counter::kIsRate);
+  if (totals.nodes != 0) {
+    state.counters["nodes"] = benchmark::Counter(
+        static_cast<double>(totals.nodes), benchmark::Counter::kIsRate);
+  }
+  state.counters["allocs_per_token"] =
+      static_cast<double>(totals.allocations) /
+      static_cast<double>(totals.tokens);
+}
+
+static void BM_Lexer(benchmark::State& state, Shape shape) {
+  const auto source = generate(shape, static_cast<size_t>(state.range(0)));
+  const auto lexer = lexer::Lexer(source);
+  Totals totals;
+  for (auto _ : state) {
+    const auto before = allocation_count();
+    auto tokens = lexer.tokenize();
+    totals.allocations += allocation_count() - before;
+    totals.tokens += static_cast<int64_t>(tokens.size());
+    totals.bytes += static_cast<int64_t>(source.size());
+    benchmark::DoNotOptimize(tokens.data());
+  }
+  report(state, totals);
+}
+
+// Walks the token buffer the way the parser does, without building nodes.
+static void BM_Reader(benchmark::State& state, Shape shape) {
+  const auto source = generate(shape, static_cast<size_t>(state.range(0)));
+  // Tokens view the lexer's copy of the source, so it must stay alive.
+  const auto lexer = lexer::Lexer(source);
+  const auto tokens = lexer.tokenize();
+  Totals totals;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = tokens;
+    state.ResumeTiming();
+    const auto before = allocation_count();
+    auto reader = parser::Reader(std::move(copy));
+    while (!reader.current_token_is(lexer::TokenType::kEOF)) {
+      benchmark::DoNotOptimize(reader.peek_token());
+      reader.next_token();
+    }
+    totals.allocations += allocation_count() - before;
+    totals.tokens += static_cast<int64_t>(tokens.size());
+    totals.bytes += static_cast<int64_t>(source.size());
+  }
+  report(state, totals);
+}
+
+// Parses an already lexed buffer, so the lexer is measured on its own above.
+// Freeing the tree is part of the cost.
+static void BM_Parser(benchmark::State& state, Shape shape) {
+  const auto source = generate(shape, static_cast<size_t>(state.range(0)));
+  // Tokens view the lexer's copy of the source, so it must stay alive.
+  const auto lexer = lexer::Lexer(source);
+  const auto tokens = lexer.tokenize();
+  Totals totals;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = tokens;
+    state.ResumeTiming();
+    const auto before = allocation_count();
+    auto program = parser::Parser(std::move(copy)).parse_program();
+    totals.allocations += allocation_count() - before;
+    totals.nodes += static_cast<int64_t>(program->arena()->node_count());
+    totals.tokens += static_cast<int64_t>(tokens.size());
+    totals.bytes += static_cast<int64_t>(source.size());
+    benchmark::DoNotOptimize(program.get());
+  }
+  report(state, totals);
+}
+
+#define MONKEY_FRONTEND_BENCHMARKS(stage)                                   \
+  BENCHMARK_CAPTURE(stage, mixed, Shape::kMixed)                            \
+      ->Arg(kCorpusSize)                                                    \
+      ->Unit(benchmark::kMillisecond);                                      \
+  BENCHMARK_CAPTURE(stage, deep_nesting, Shape::kDeepNesting)               \
+      ->Arg(kCorpusSize)                                                    \
+      ->Unit(benchmark::kMillisecond);                                      \
+  BENCHMARK_CAPTURE(stage, long_strings, Shape::kLongStrings)               \
+      ->Arg(kCorpusSize)                                                    \
+      ->Unit(benchmark::kMillisecond);                                      \
+  BENCHMARK_CAPTURE(stage, large_literals, Shape::kLargeLiterals)           \
+      ->Arg(kCorpusSize)                                                    \
+      ->Unit(benchmark::kMillisecond);                                      \
+  BENCHMARK_CAPTURE(stage, many_functions, Shape::kManyFunctions)           \
+      ->Arg(kCorpusSize)                                                    \
+      ->Unit(benchmark::kMillisecond)
+
+MONKEY_FRONTEND_BENCHMARKS(BM_Lexer);
+MONKEY_FRONTEND_BENCHMARKS(BM_Reader);
+MONKEY_FRONTEND_BENCHMARKS(BM_Parser);
+
+}  // namespace monkey::bench
+
+BENCHMARK_MAIN();
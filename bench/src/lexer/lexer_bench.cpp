@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/lexer/token.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace monkey::lexer {
+
+enum class Corpus { kMixed, kIdentifiers, kIntegers, kStrings, kIndented };
+
+std::string generate_corpus(Corpus corpus, size_t target_size) {
+  std::string source;
+  source.reserve(target_size + 256);
+  for (size_t i = 0; source.size() < target_size; ++i) {
+    switch (corpus) {
+      case Corpus::kMixed:
+        source += fmt::format(
+            "let result = if (left < {0}) {{ add(left, right) }} else {{ "
+            "[\"item\", {0}, true][1] }};\n",
+            i);
+        break;
+      case Corpus::kIdentifiers:
+        source +=
+            "let accumulated_total = previous_total + current_value_of_item;\n";
+        break;
+      case Corpus::kIntegers:
+        source += fmt::format("[{}, {}, {}];\n", i * 7919, i * 104729,
+                              i * 1299709);
+        break;
+      case Corpus::kStrings:
+        source +=
+            "puts(\"the quick brown fox jumps over the lazy dog, twice\");\n";
+        break;
+      case Corpus::kIndented:
+        source += "                if (flag) {\n                    return "
+                  "value;\n                }\n";
+        break;
+    }
+  }
+  return source;
+}
+
+static void BM_Tokenize(benchmark::State& state, Corpus corpus) {
+  const auto source =
+      generate_corpus(corpus, static_cast<size_t>(state.range(0)));
+  const auto lexer = Lexer(source);
+  int64_t tokens = 0;
+  for (auto _ : state) {
+    auto buffer = lexer.tokenize();
+    tokens += static_cast<int64_t>(buffer.size());
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(source.size()));
+  state.counters["tokens"] = benchmark::Counter(static_cast<double>(tokens),
+                                                benchmark::Counter::kIsRate);
+}
+
+BENCHMARK_CAPTURE(BM_Tokenize, mixed, Corpus::kMixed)
+    ->Arg(1 << 24)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Tokenize, identifiers, Corpus::kIdentifiers)
+    ->Arg(1 << 24)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Tokenize, integers, Corpus::kIntegers)
+    ->Arg(1 << 24)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Tokenize, strings, Corpus::kStrings)
+    ->Arg(1 << 24)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Tokenize, indented, Corpus::kIndented)
+    ->Arg(1 << 24)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace monkey::lexer
+
+BENCHMARK_MAIN();
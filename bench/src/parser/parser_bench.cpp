@@ -0,0 +1,101 @@
+#include <benchmark/benchmark.h>
+#include <fmt/core.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/lexer/token.h>
+#include <monkey/parser/parser.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace monkey::parser {
+
+// Identifiers may only contain letters and underscores, so spell the index
+// out in base 26.
+std::string make_name(size_t index) {
+  std::string name;
+  do {
+    name += static_cast<char>('a' + index % 26);
+    index /= 26;
+  } while (index != 0);
+  return name;
+}
+
+std::string generate_script(size_t target_size) {
+  std::string script;
+  script.reserve(target_size + 256);
+  for (size_t i = 0; script.size() < target_size; ++i) {
+    script += fmt::format(
+        "let value_{0} = fn(x, y) {{ if (x < y) {{ return x * {1} + y; }} "
+        "else {{ x - y / 2 }} }};\n"
+        "let table_{0} = {{\"key_{0}\": [1, 2, {1}], \"flag\": !true}};\n"
+        "value_{0}(table_{0}[\"key_{0}\"][2], -{1}) == {1};\n",
+        make_name(i), i);
+  }
+  return script;
+}
+
+int64_t count_tokens(const lexer::Lexer& lexer) {
+  int64_t tokens = 0;
+  for (auto it = lexer.begin(); it != lexer.end(); ++it) {
+    ++tokens;
+  }
+  return tokens;
+}
+
+static void BM_LexerIterate(benchmark::State& state) {
+  const auto script = generate_script(static_cast<size_t>(state.range(0)));
+  const auto lexer = lexer::Lexer(script);
+  int64_t tokens = 0;
+  for (auto _ : state) {
+    for (const auto& token : lexer) {
+      benchmark::DoNotOptimize(token);
+      ++tokens;
+    }
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+  state.counters["tokens"] =
+      benchmark::Counter(static_cast<double>(tokens),
+                         benchmark::Counter::kIsRate);
+}
+
+static void BM_LexerTokenize(benchmark::State& state) {
+  const auto script = generate_script(static_cast<size_t>(state.range(0)));
+  const auto lexer = lexer::Lexer(script);
+  int64_t tokens = 0;
+  for (auto _ : state) {
+    auto buffer = lexer.tokenize();
+    tokens += static_cast<int64_t>(buffer.size());
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+  state.counters["tokens"] =
+      benchmark::Counter(static_cast<double>(tokens),
+                         benchmark::Counter::kIsRate);
+}
+
+static void BM_ParseProgram(benchmark::State& state) {
+  const auto script = generate_script(static_cast<size_t>(state.range(0)));
+  const auto lexer = lexer::Lexer(script);
+  const auto tokens_per_iteration = count_tokens(lexer);
+  for (auto _ : state) {
+    auto program = Parser(lexer).parse_program();
+    benchmark::DoNotOptimize(program.get());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(script.size()));
+  state.counters["tokens"] = benchmark::Counter(
+      static_cast<double>(tokens_per_iteration *
+                          state.iterations()),
+      benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(BM_LexerIterate)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LexerTokenize)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseProgram)->Arg(1 << 22)->Unit(benchmark::kMillisecond);
+
+}  // namespace monkey::parser
+
+BENCHMARK_MAIN();
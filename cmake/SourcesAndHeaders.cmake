@@ -1,18 +1,36 @@
 set(sources
     lib/lexer/lexer.cpp
+    lib/lexer/location.cpp
+    lib/lexer/source.cpp
+    lib/lexer/stream.cpp
     lib/lexer/token.cpp
+    lib/ast/arena.cpp
     lib/ast/ast.cpp
+    lib/ast/binary.cpp
     lib/ast/expr.cpp
+    lib/ast/flat.cpp
+    lib/ast/resolver.cpp
     lib/ast/stmt.cpp
+    lib/ast/symbol.cpp
+    lib/parser/cache.cpp
     lib/parser/error.cpp
     lib/parser/expr.cpp
+    lib/parser/incremental.cpp
+    lib/parser/parallel.cpp
     lib/parser/parser.cpp
     lib/parser/reader.cpp
     lib/parser/stmt.cpp
     lib/object/object.cpp
     lib/object/env.cpp
+    lib/object/memo.cpp
     lib/eval/eval.cpp
     lib/eval/builtin.cpp
+    lib/eval/flat.cpp
+    lib/eval/compiled.cpp
+    lib/opt/optimizer.cpp
+    lib/compiler/bytecode.cpp
+    lib/compiler/compiler.cpp
+    lib/vm/vm.cpp
 )
 
 set(exe_sources
@@ -22,23 +40,56 @@ set(exe_sources
 
 set(headers
     include/monkey/lexer/lexer.h
+    include/monkey/lexer/location.h
+    include/monkey/lexer/source.h
+    include/monkey/lexer/stream.h
     include/monkey/lexer/token.h
+    include/monkey/ast/arena.h
     include/monkey/ast/ast.h
+    include/monkey/ast/binary.h
     include/monkey/ast/expr.h
+    include/monkey/ast/flat.h
+    include/monkey/ast/resolver.h
     include/monkey/ast/stmt.h
+    include/monkey/ast/symbol.h
+    include/monkey/parser/cache.h
     include/monkey/parser/error.h
     include/monkey/parser/expr.h
+    include/monkey/parser/incremental.h
+    include/monkey/parser/parallel.h
     include/monkey/parser/parser.h
     include/monkey/parser/reader.h
     include/monkey/parser/stmt.h
     include/monkey/object/object.h
     include/monkey/object/env.h
+    include/monkey/object/memo.h
     include/monkey/eval/eval.h
     include/monkey/eval/builtin.h
+    include/monkey/eval/flat.h
+    include/monkey/eval/value.h
+    include/monkey/eval/compiled.h
+    include/monkey/opt/optimizer.h
+    include/monkey/compiler/bytecode.h
+    include/monkey/compiler/compiler.h
+    include/monkey/vm/vm.h
 )
 
 set(test_sources
   src/lexer/lexer_test.cpp
   src/parser/parser_test.cpp
   src/eval/eval_test.cpp
+  src/opt/opt_test.cpp
+  src/compiler/compiler_test.cpp
+)
+
+set(bench_sources
+  src/lexer/lexer_bench.cpp
+  src/parser/parser_bench.cpp
+  src/frontend/frontend_bench.cpp
+  src/eval/engine_bench.cpp
+)
+
+# Compiled into every benchmark binary.
+set(bench_common_sources
+  src/common/allocations.cpp
 )
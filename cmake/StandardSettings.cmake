@@ -32,6 +32,13 @@ option(${PROJECT_NAME}_USE_GOOGLE_MOCK "Use the GoogleMock project for extending
 
 option(${PROJECT_NAME}_USE_CATCH2 "Use the Catch2 project for creating unit tests." OFF)
 
+#
+# Benchmarking
+#
+# Currently supporting: Google Benchmark.
+
+option(${PROJECT_NAME}_ENABLE_BENCHMARKING "Enable benchmarks for the project (from the `bench` subfolder)." OFF)
+
 #
 # Static analyzers
 #
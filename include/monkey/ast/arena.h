@@ -0,0 +1,79 @@
+#ifndef MONKEY_AST_ARENA_H
+#define MONKEY_AST_ARENA_H
+
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace monkey::ast {
+
+// Bump-pointer storage for the nodes of one parsed program. Nodes are placed
+// back to back in large blocks and destroyed together with the arena.
+//
+// make() hands out non-owning shared_ptrs: they carry no control block, so
+// linking nodes to each other costs neither an allocation nor refcount
+// traffic. Whoever needs a node to outlive the parse must keep the arena
+// alive instead, which ast::Program does for the tree it roots and every
+// function value for the literal it was made from, see
+// FunctionLiteral::arena(). Arenas must be made with std::make_shared.
+class AstArena : public std::enable_shared_from_this<AstArena> {
+ public:
+  static constexpr size_t kBlockSize = size_t{64} * 1024;
+
+  AstArena() = default;
+  AstArena(const AstArena&) = delete;
+  AstArena(AstArena&&) = delete;
+  AstArena& operator=(const AstArena&) = delete;
+  AstArena& operator=(AstArena&&) = delete;
+  ~AstArena();
+
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(Args&&... args) {
+    static_assert(std::is_base_of_v<Node, T>);
+    auto* node = ::new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+    nodes_.push_back(node);
+    if constexpr (std::is_same_v<T, FunctionLiteral>) {
+      node->set_arena(weak_from_this());
+    }
+    return std::shared_ptr<T>(std::shared_ptr<T>(), node);
+  }
+
+  // Keeps another arena's nodes alive for as long as this one, so that a
+  // program assembled from separately parsed pieces has a single owner.
+  void adopt(std::shared_ptr<const AstArena> other);
+
+  [[nodiscard]] size_t node_count() const;
+  [[nodiscard]] size_t bytes_reserved() const;
+
+ private:
+  void* allocate(size_t size, size_t alignment) {
+    const auto padding =
+        (alignment - reinterpret_cast<uintptr_t>(cursor_) % alignment) %
+        alignment;
+    if (static_cast<size_t>(limit_ - cursor_) < padding + size) {
+      return allocate_block(size);
+    }
+    auto* memory = cursor_ + padding;
+    cursor_ = memory + size;
+    return memory;
+  }
+  void* allocate_block(size_t size);
+
+  std::vector<std::unique_ptr<std::byte[]>> blocks_;
+  std::byte* cursor_ = nullptr;
+  std::byte* limit_ = nullptr;
+  std::vector<Node*> nodes_;
+  std::vector<std::shared_ptr<const AstArena>> adopted_;
+};
+
+}  // namespace monkey::ast
+
+#endif  // MONKEY_AST_ARENA_H
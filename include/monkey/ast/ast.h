@@ -1,13 +1,15 @@
 #ifndef MONKEY_AST_AST_H
 #define MONKEY_AST_AST_H
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 namespace monkey::ast {
 
-enum class NodeType {
+enum class NodeType : uint8_t {
   kProgram,
 
   kLetStatement,
@@ -45,12 +47,73 @@ class Node {
 
   [[nodiscard]] virtual std::string to_string() const = 0;
 
+  // Structural: where the nodes came from does not matter.
   virtual bool operator==(const Node& other) const = 0;
   virtual bool operator!=(const Node& other) const = 0;
 
+  // Byte offset in the source file of the token the node was parsed at: the
+  // operator of an infix, call or index expression and the first token of
+  // anything else. A statement an incremental reparse moved keeps the
+  // offsets it was parsed at, so a node under a Program is located with
+  // Program::offset() instead.
+  [[nodiscard]] uint32_t offset() const { return offset_; }
+  void set_offset(uint32_t offset) { offset_ = offset; }
+
   friend std::string to_string(const Node& node);
+
+ private:
+  uint32_t offset_ = 0;
+};
+
+// Where ast::resolve() bound a name. A frame holds the parameters and
+// locals of one function call, or the locals of a block at the top level;
+// a closure reaches the locals of enclosing frames through its captures.
+// Names bound in no frame are global and looked up by symbol.
+struct Address {
+  enum class Kind : uint8_t {
+    kGlobal,
+    // Slot `index` of the frame being evaluated.
+    kLocal,
+    // Value `index` captured by the function being run.
+    kCapture,
+    // Slot `slot` of frame `index` captured by the function being run, for a
+    // local that could still change or be unset when the closure was made.
+    kFrame,
+  };
+
+  Kind kind = Kind::kGlobal;
+  uint32_t index = 0;
+  uint32_t slot = 0;
+
+  [[nodiscard]] bool global() const { return kind == Kind::kGlobal; }
+
+  bool operator==(const Address& rhs) const = default;
+};
+
+// Where a closure takes one of its captures from when it is made.
+struct Capture {
+  enum class Source : uint8_t {
+    // Slot `index` of the frame making the closure.
+    kSlot,
+    // Value `index` captured by the function making the closure.
+    kCapture,
+    // The frame making the closure itself.
+    kFrame,
+    // Frame `index` captured by the function making the closure.
+    kCapturedFrame,
+  };
+
+  Source source = Source::kSlot;
+  uint32_t index = 0;
+
+  bool operator==(const Capture& rhs) const = default;
 };
 
+// What every successful evaluation of an expression yields, as proven by
+// ast::resolve(). An evaluation that fails yields an error instead, so `-x`
+// is an integer whatever `x` is.
+enum class StaticType : uint8_t { kUnknown, kInteger, kBoolean };
+
 class Statement;
 class LetStatement;
 class ReturnStatement;
@@ -71,15 +134,41 @@ class FunctionLiteral;
 class CallExpression;
 class IndexExpression;
 
+class AstArena;
+
 class Program : public Node {
  public:
   explicit Program(std::vector<std::shared_ptr<Statement>> statements);
+  // Takes ownership of the arena the statements were allocated from.
+  Program(std::vector<std::shared_ptr<Statement>> statements,
+          std::shared_ptr<const AstArena> arena);
+  // As above, with the amount to add to the offsets of the nodes under each
+  // statement, for statements that were moved in the text after they were
+  // parsed.
+  Program(std::vector<std::shared_ptr<Statement>> statements,
+          std::shared_ptr<const AstArena> arena,
+          std::vector<uint32_t> offset_shifts);
 
   [[nodiscard]] NodeType type() const override { return NodeType::kProgram; }
   [[nodiscard]] const std::vector<std::shared_ptr<Statement>>& statements()
       const {
     return statements_;
   }
+  [[nodiscard]] const std::shared_ptr<const AstArena>& arena() const {
+    return arena_;
+  }
+  using Node::offset;
+  // Where a node under the given top-level statement now is in the text.
+  // Resolve it with lexer::LineTable.
+  [[nodiscard]] uint32_t offset(const Node& node, size_t statement) const {
+    return node.offset() + offset_shift(statement);
+  }
+  // What offset() adds for the statement, for a program rebuilt from this
+  // one to carry over. Wraps around for statements that moved towards the
+  // start of the text.
+  [[nodiscard]] uint32_t offset_shift(size_t statement) const {
+    return offset_shifts_.empty() ? 0 : offset_shifts_[statement];
+  }
 
   [[nodiscard]] std::string to_string() const override;
 
@@ -87,7 +176,10 @@ class Program : public Node {
   bool operator!=(const Node& other) const override;
 
  private:
+  std::shared_ptr<const AstArena> arena_;
   std::vector<std::shared_ptr<Statement>> statements_;
+  // Empty when no statement has moved.
+  std::vector<uint32_t> offset_shifts_;
 };
 
 }  // namespace monkey::ast
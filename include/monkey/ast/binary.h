@@ -0,0 +1,67 @@
+#ifndef MONKEY_AST_BINARY_H
+#define MONKEY_AST_BINARY_H
+
+#include <monkey/ast/ast.h>
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace monkey::ast {
+
+class FormatError : public std::exception {
+ public:
+  explicit FormatError(std::string message);
+
+  [[nodiscard]] const char* what() const noexcept override {
+    return message_.c_str();
+  }
+
+ private:
+  std::string message_;
+};
+
+// The .mkc binary encoding of a Program:
+//
+//   header      "MKC\n", u32 version, u64 source hash, u64 source size
+//   names       varint count, then each name as varint length + bytes
+//   statements  varint count, then each statement
+//
+// Nodes are written in prefix order as a NodeType byte, the node's source
+// offset as a zigzag varint delta from the previous node's, then their
+// fields: children in declaration order, identifiers as varint indices into
+// the name table, integers zigzag varints, operators a TokenType byte, lists
+// a varint count and a missing else branch the byte kNoNodeTag. Let names
+// and parameters carry an offset delta before their index. Symbol ids
+// are per-process, which is why names are stored by text.
+//
+// Integers in the header are little-endian. Readers reject any version but
+// their own, so bump kBinaryVersion whenever the encoding changes.
+inline constexpr uint32_t kBinaryVersion = 2;
+inline constexpr uint8_t kNoNodeTag = 0xff;
+
+// Identifies the source a program was parsed from, so a stale encoding can
+// be told apart from a current one.
+struct SourceKey {
+  uint64_t hash = 0;
+  uint64_t size = 0;
+
+  bool operator==(const SourceKey& rhs) const = default;
+};
+
+// Hashes a source text. Fast enough to run on every start before deciding
+// whether to parse, but not meant to resist deliberate collisions.
+SourceKey source_key(std::string_view text);
+
+std::string encode(const Program& program, const SourceKey& key);
+
+// Rebuilds a program, allocating its nodes from a fresh arena. Throws
+// FormatError on a truncated or malformed encoding, or one whose header does
+// not match `key`.
+std::shared_ptr<Program> decode(std::string_view bytes, const SourceKey& key);
+
+}  // namespace monkey::ast
+
+#endif  // MONKEY_AST_BINARY_H
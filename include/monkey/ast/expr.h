@@ -2,24 +2,49 @@
 #define MONKEY_AST_EXPR_H
 
 #include <monkey/ast/ast.h>
+#include <monkey/ast/symbol.h>
 #include <monkey/lexer/token.h>
 
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace monkey::ast {
 
-class Expression : public Node {};
+class Expression : public Node {
+ public:
+  // Set by ast::resolve().
+  [[nodiscard]] StaticType static_type() const { return static_type_; }
+  void set_static_type(StaticType type) { static_type_ = type; }
+
+ private:
+  StaticType static_type_ = StaticType::kUnknown;
+};
 
 class Identifier : public Expression {
  public:
-  explicit Identifier(std::string name);
+  explicit Identifier(Symbol symbol);
+  explicit Identifier(std::string_view name);
 
   [[nodiscard]] NodeType type() const override { return NodeType::kIdentifier; }
-  [[nodiscard]] std::string name() const { return name_; }
+  [[nodiscard]] Symbol symbol() const { return symbol_; }
+  [[nodiscard]] const std::string& name() const { return symbol_.name(); }
+
+  // Set by ast::resolve(). The binding is the first of address() and then
+  // fallbacks() that is set, or the global of that name if none is.
+  // Fallbacks are only needed when a closure refers to a local that may not
+  // have been declared yet by the time it is called.
+  [[nodiscard]] Address address() const { return address_; }
+  [[nodiscard]] const std::vector<Address>& fallbacks() const {
+    return fallbacks_;
+  }
+  void set_address(Address address, std::vector<Address> fallbacks = {});
 
   [[nodiscard]] std::string to_string() const override;
 
@@ -27,7 +52,9 @@ class Identifier : public Expression {
   bool operator!=(const Node& other) const override;
 
  private:
-  std::string name_;
+  Symbol symbol_;
+  Address address_;
+  std::vector<Address> fallbacks_;
 };
 
 class IntegerLiteral : public Expression {
@@ -82,6 +109,43 @@ class FunctionLiteral : public Expression {
     return body_;
   }
 
+  // Slots in a call's frame, parameters first. Set by ast::resolve().
+  [[nodiscard]] uint32_t frame_size() const { return frame_size_; }
+  void set_frame_size(uint32_t size) { frame_size_ = size; }
+  // Whether a closure made during a call can keep the call's frame, so that
+  // it must outlive the call. Set by ast::resolve().
+  [[nodiscard]] bool frame_escapes() const { return frame_escapes_; }
+  void set_frame_escapes(bool escapes) { frame_escapes_ = escapes; }
+
+  // What a closure made from the literal copies, in Address::kCapture and
+  // Address::kFrame order: only the free variables its body refers to.
+  // Set by ast::resolve().
+  [[nodiscard]] const std::vector<Capture>& captures() const {
+    return captures_;
+  }
+  [[nodiscard]] const std::vector<Capture>& captured_frames() const {
+    return captured_frames_;
+  }
+  void set_captures(std::vector<Capture> captures,
+                    std::vector<Capture> captured_frames);
+
+  // Whether a call can only depend on its arguments, the values it copied
+  // and the globals: a frame kept whole could have a slot set between two
+  // calls. Side effects are only known once the call runs, see
+  // object::record_effect().
+  [[nodiscard]] bool pure() const { return captured_frames_.empty(); }
+
+  // The arena the literal was made in, which the functions made from it
+  // keep alive since they point into it; null for a literal made outside
+  // any arena. Set by AstArena::make(); the arena is only referred to
+  // weakly, as the literal lives inside it.
+  [[nodiscard]] std::shared_ptr<const AstArena> arena() const {
+    return arena_.lock();
+  }
+  void set_arena(std::weak_ptr<const AstArena> arena) {
+    arena_ = std::move(arena);
+  }
+
   [[nodiscard]] std::string to_string() const override;
 
   bool operator==(const Node& other) const override;
@@ -90,6 +154,11 @@ class FunctionLiteral : public Expression {
  private:
   std::vector<std::shared_ptr<Identifier>> parameters_;
   std::shared_ptr<BlockStatement> body_;
+  std::weak_ptr<const AstArena> arena_;
+  uint32_t frame_size_ = 0;
+  bool frame_escapes_ = false;
+  std::vector<Capture> captures_;
+  std::vector<Capture> captured_frames_;
 };
 
 class StringLiteral : public Expression {
@@ -180,6 +249,29 @@ class PrefixExpression : public Expression {
 
 class InfixExpression : public Expression {
  public:
+  // What the tree-walker runs the node as, picked from the operands it has
+  // seen: each stands for a node specialized to one operator on one type of
+  // operand, guarded by a check of that type.
+  enum class Specialization : uint8_t {
+    // Not evaluated yet.
+    kUninitialized,
+    kIntegerAdd,
+    kIntegerSubtract,
+    kIntegerMultiply,
+    kIntegerDivide,
+    kIntegerLessThan,
+    kIntegerGreaterThan,
+    kIntegerEqual,
+    kIntegerNotEqual,
+    kBooleanEqual,
+    kBooleanNotEqual,
+    kStringConcat,
+    // Operands of no single type above, or of more than one as a guard found.
+    kGeneric,
+  };
+  static constexpr size_t kSpecializations =
+      static_cast<size_t>(Specialization::kGeneric) + 1;
+
   InfixExpression(std::shared_ptr<Expression> left, lexer::TokenType op,
                   std::shared_ptr<Expression> right);
 
@@ -194,6 +286,17 @@ class InfixExpression : public Expression {
     return right_;
   }
 
+  // Rewritten by the evaluator as the program runs, so even a const node
+  // can be specialized. Threads evaluating the same node may race to
+  // rewrite it, which is safe: every specialization checks its operands'
+  // types before it relies on them.
+  [[nodiscard]] Specialization specialization() const {
+    return specialization_.load(std::memory_order_relaxed);
+  }
+  void specialize(Specialization specialization) const {
+    specialization_.store(specialization, std::memory_order_relaxed);
+  }
+
   [[nodiscard]] std::string to_string() const override;
 
   bool operator==(const Node& other) const override;
@@ -203,10 +306,17 @@ class InfixExpression : public Expression {
   std::shared_ptr<Expression> left_;
   lexer::TokenType op_;
   std::shared_ptr<Expression> right_;
+  mutable std::atomic<Specialization> specialization_ =
+      Specialization::kUninitialized;
 };
 
+std::string to_string(InfixExpression::Specialization specialization);
+
 class IndexExpression : public Expression {
  public:
+  // The receiver the evaluator found last, which it checks for first.
+  enum class Receiver : uint8_t { kUnknown, kArray, kHash };
+
   IndexExpression(std::shared_ptr<Expression> left,
                   std::shared_ptr<Expression> index);
 
@@ -220,6 +330,16 @@ class IndexExpression : public Expression {
     return index_;
   }
 
+  // An inline cache the evaluator updates as the program runs. Threads
+  // evaluating the same node may race to update it, which is safe: the
+  // evaluator checks the receiver it expects before relying on it.
+  [[nodiscard]] Receiver receiver() const {
+    return receiver_.load(std::memory_order_relaxed);
+  }
+  void expect(Receiver receiver) const {
+    receiver_.store(receiver, std::memory_order_relaxed);
+  }
+
   [[nodiscard]] std::string to_string() const override;
 
   bool operator==(const Node& other) const override;
@@ -228,6 +348,7 @@ class IndexExpression : public Expression {
  private:
   std::shared_ptr<Expression> left_;
   std::shared_ptr<Expression> index_;
+  mutable std::atomic<Receiver> receiver_ = Receiver::kUnknown;
 };
 
 class IfExpression : public Expression {
@@ -262,6 +383,19 @@ class IfExpression : public Expression {
 
 class CallExpression : public Expression {
  public:
+  // What the callee the evaluator found last can be called as without
+  // checking it again: a function taking as many arguments as the call
+  // passes, or a builtin. Anything else takes the generic path.
+  enum class Target : uint8_t { kUnknown, kFunction, kBuiltin };
+
+  // Keeps only the callee's identity, so a closure is not kept alive by
+  // the sites that called it. Never changed once published; a new callee
+  // replaces the whole entry.
+  struct InlineCache {
+    std::weak_ptr<const void> callee;
+    Target target = Target::kUnknown;
+  };
+
   CallExpression(std::shared_ptr<Expression> function,
                  std::vector<std::shared_ptr<Expression>> arguments);
 
@@ -276,6 +410,21 @@ class CallExpression : public Expression {
     return arguments_;
   }
 
+  // Set by ast::resolve() when the function the call is in returns its
+  // value as is, so the call can be made once the function has returned.
+  [[nodiscard]] bool tail() const { return tail_; }
+  void set_tail(bool tail) { tail_ = tail; }
+
+  // Updated by the evaluator as the program runs, null until the first
+  // call. Threads evaluating the same node may race to replace the entry,
+  // which is safe: each sees a callee and target that belong together.
+  [[nodiscard]] std::shared_ptr<const InlineCache> cache() const {
+    return cache_.load(std::memory_order_acquire);
+  }
+  void set_cache(std::shared_ptr<const InlineCache> cache) const {
+    cache_.store(std::move(cache), std::memory_order_release);
+  }
+
   [[nodiscard]] std::string to_string() const override;
 
   bool operator==(const Node& other) const override;
@@ -284,6 +433,8 @@ class CallExpression : public Expression {
  private:
   std::shared_ptr<Expression> function_;
   std::vector<std::shared_ptr<Expression>> arguments_;
+  bool tail_ = false;
+  mutable std::atomic<std::shared_ptr<const InlineCache>> cache_;
 };
 
 }  // namespace monkey::ast
@@ -0,0 +1,112 @@
+#ifndef MONKEY_AST_FLAT_H
+#define MONKEY_AST_FLAT_H
+
+#include <monkey/ast/ast.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/lexer/token.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace monkey::ast {
+
+class FlatBuilder;
+
+using NodeIndex = uint32_t;
+
+inline constexpr NodeIndex kNoNode = std::numeric_limits<NodeIndex>::max();
+
+// One node of a FlatProgram. The operands a, b and c are indices whose
+// meaning depends on the node type; "range" means a (first, count) pair into
+// FlatProgram::children() and "name", "integer" and "string" index the
+// matching side table.
+//
+//   kIdentifier           a: name
+//   kIntegerLiteral       a: integer
+//   kBooleanLiteral       a: 0 or 1
+//   kStringLiteral        a: string
+//   kArrayLiteral         a, b: range of elements
+//   kHashLiteral          a, b: range of keys and values, interleaved
+//   kFunctionLiteral      a, b: range of parameter identifiers, c: body block
+//   kPrefixExpression     op, a: right
+//   kInfixExpression      op, a: left, b: right
+//   kIfExpression         a: condition, b: consequence, c: alternative or
+//                         kNoNode
+//   kCallExpression       a: function, b, c: range of arguments
+//   kIndexExpression      a: left, b: index
+//   kLetStatement         a: name, b: value
+//   kReturnStatement      a: value
+//   kExpressionStatement  a: expression
+//   kBlockStatement       a, b: range of statements
+struct FlatNode {
+  NodeType type;
+  lexer::TokenType op = lexer::TokenType::kIllegal;
+  NodeIndex a = kNoNode;
+  NodeIndex b = kNoNode;
+  NodeIndex c = kNoNode;
+};
+
+static_assert(sizeof(FlatNode) == 16);
+
+// A program stored as one contiguous node array. Children are referenced by
+// 32-bit index instead of pointer, identifiers are interned once per program
+// and literals live in side tables, so a loaded program is a handful of
+// allocations however large it is.
+class FlatProgram {
+ public:
+  [[nodiscard]] const FlatNode& node(NodeIndex index) const {
+    return nodes_[index];
+  }
+  // Byte offset of the node's source token, as in Node::offset().
+  [[nodiscard]] uint32_t offset(NodeIndex index) const {
+    return offsets_[index];
+  }
+  [[nodiscard]] std::span<const NodeIndex> children(NodeIndex first,
+                                                    NodeIndex count) const {
+    return {children_.data() + first, count};
+  }
+  [[nodiscard]] std::span<const NodeIndex> statements() const {
+    return children(statements_first_, statements_count_);
+  }
+
+  [[nodiscard]] Symbol symbol(NodeIndex index) const { return names_[index]; }
+  [[nodiscard]] const std::string& name(NodeIndex index) const {
+    return names_[index].name();
+  }
+  [[nodiscard]] int64_t integer(NodeIndex index) const {
+    return integers_[index];
+  }
+  [[nodiscard]] const std::string& string(NodeIndex index) const {
+    return strings_[index];
+  }
+
+  [[nodiscard]] size_t node_count() const { return nodes_.size(); }
+  [[nodiscard]] size_t memory_usage() const;
+
+  [[nodiscard]] std::string to_string() const;
+  // Renders a node the way the equivalent ast::Node::to_string() would.
+  [[nodiscard]] std::string to_string(NodeIndex index) const;
+
+  friend class FlatBuilder;
+
+ private:
+  std::vector<FlatNode> nodes_;
+  std::vector<uint32_t> offsets_;
+  std::vector<NodeIndex> children_;
+  std::vector<Symbol> names_;
+  std::vector<int64_t> integers_;
+  std::vector<std::string> strings_;
+  NodeIndex statements_first_ = 0;
+  NodeIndex statements_count_ = 0;
+};
+
+std::shared_ptr<const FlatProgram> flatten(const Program& program);
+
+}  // namespace monkey::ast
+
+#endif  // MONKEY_AST_FLAT_H
@@ -0,0 +1,27 @@
+#ifndef MONKEY_AST_RESOLVER_H
+#define MONKEY_AST_RESOLVER_H
+
+#include <monkey/ast/ast.h>
+
+namespace monkey::ast {
+
+// Binds every identifier in the program to a frame slot or a capture, see
+// Address, sizes the frames of its function literals and top-level blocks,
+// marks those a closure can keep and lists the free variables each function
+// literal captures. It also infers which expressions always yield an integer
+// or a boolean, see StaticType. Names declared at the top level stay global,
+// so that a REPL can keep adding to them between programs.
+//
+// The bindings find the same value as looking the name up through nested
+// scopes at run time would. A let is visible from the statement after it,
+// and from any closure that runs once it has executed.
+//
+// Resolution annotates the nodes, once per top-level statement: top-level
+// names being global, a statement resolves the same in any program, so
+// programs sharing it can be run on several threads at once. The
+// annotations are visible to any thread once this returns.
+void resolve(const Program& program);
+
+}  // namespace monkey::ast
+
+#endif  // MONKEY_AST_RESOLVER_H
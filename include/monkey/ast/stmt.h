@@ -3,13 +3,38 @@
 
 #include <monkey/ast/ast.h>
 
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace monkey::ast {
 
-class Statement : public Node {};
+class Statement : public Node {
+ public:
+  Statement() = default;
+  // A copy has its own resolution to run, see resolved().
+  Statement(const Statement& other) : Node(other) {}
+  Statement(Statement&& other) noexcept : Node(std::move(other)) {}
+  Statement& operator=(const Statement& other) {
+    Node::operator=(other);
+    return *this;
+  }
+  Statement& operator=(Statement&& other) noexcept {
+    Node::operator=(std::move(other));
+    return *this;
+  }
+  ~Statement() override = default;
+
+  // Guards the resolution of a top-level statement, which ast::resolve()
+  // runs only once whichever programs share the statement.
+  [[nodiscard]] std::once_flag& resolved() const { return resolved_; }
+
+ private:
+  mutable std::once_flag resolved_;
+};
 
 class LetStatement : public Statement {
  public:
@@ -88,6 +113,16 @@ class BlockStatement : public Statement {
     return statements_;
   }
 
+  // Non-zero for a block at the top level that declares locals, which it
+  // keeps in a frame of its own. Other blocks use the enclosing function's
+  // frame. Set by ast::resolve().
+  [[nodiscard]] uint32_t frame_size() const { return frame_size_; }
+  void set_frame_size(uint32_t size) { frame_size_ = size; }
+  // Whether a closure can keep that frame, so that it must outlive the
+  // block. Set by ast::resolve().
+  [[nodiscard]] bool frame_escapes() const { return frame_escapes_; }
+  void set_frame_escapes(bool escapes) { frame_escapes_ = escapes; }
+
   [[nodiscard]] std::string to_string() const override;
 
   bool operator==(const Node& other) const override;
@@ -95,6 +130,8 @@ class BlockStatement : public Statement {
 
  private:
   std::vector<std::shared_ptr<Statement>> statements_;
+  uint32_t frame_size_ = 0;
+  bool frame_escapes_ = false;
 };
 
 }  // namespace monkey::ast
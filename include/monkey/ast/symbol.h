@@ -0,0 +1,43 @@
+#ifndef MONKEY_AST_SYMBOL_H
+#define MONKEY_AST_SYMBOL_H
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace monkey::ast {
+
+// An identifier name interned into the process-wide symbol table. Equal names
+// always get the same 32-bit id, so symbols compare and hash as integers and
+// the name itself is only needed for printing. Interning is thread-safe.
+class Symbol {
+ public:
+  // The empty name.
+  constexpr Symbol() = default;
+
+  static Symbol intern(std::string_view name);
+
+  [[nodiscard]] constexpr uint32_t id() const { return id_; }
+  [[nodiscard]] const std::string& name() const;
+
+  constexpr auto operator<=>(const Symbol& rhs) const = default;
+
+ private:
+  constexpr explicit Symbol(uint32_t id) : id_(id) {}
+
+  uint32_t id_ = 0;
+};
+
+}  // namespace monkey::ast
+
+template <>
+struct std::hash<monkey::ast::Symbol> {
+  size_t operator()(monkey::ast::Symbol symbol) const noexcept {
+    return symbol.id();
+  }
+};
+
+#endif  // MONKEY_AST_SYMBOL_H
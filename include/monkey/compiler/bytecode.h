@@ -0,0 +1,118 @@
+#ifndef MONKEY_COMPILER_BYTECODE_H_
+#define MONKEY_COMPILER_BYTECODE_H_
+
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/object/object.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace monkey::compiler {
+
+// An instruction is an opcode byte, followed by a u32 operand in native byte
+// order for those that take one. Operands are popped off the value stack and
+// the result pushed back; setters leave the value they store on the stack,
+// since a let has a value too.
+enum class Opcode : uint8_t {
+  // Integer `operand` of the pool.
+  kInteger,
+  // Object `operand` of the pool.
+  kConstant,
+  kTrue,
+  kFalse,
+  kNull,
+  kPop,
+  // Slot `operand` of a call's frame kept on the value stack, for functions
+  // whose frame does not escape, see ast::FunctionLiteral::frame_escapes().
+  kGetLocal,
+  kSetLocal,
+  // Slot `operand` of a frame allocated on its own: that of a call whose
+  // frame escapes, or that of a top-level block.
+  kGetSlot,
+  kSetSlot,
+  // Value `operand` captured by the closure being run.
+  kGetCapture,
+  // Name `operand`, always global.
+  kGetGlobal,
+  kSetGlobal,
+  // Name `operand`, looked up through its addresses and then the globals.
+  kGetName,
+  kMinus,
+  kBang,
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kDivide,
+  kLessThan,
+  kGreaterThan,
+  kEqual,
+  kNotEqual,
+  // Jumps to offset `operand` of the function's code; kJumpIfFalse pops the
+  // condition first.
+  kJump,
+  kJumpIfFalse,
+  // Builds an array of the top `operand` values, or a hash of the top
+  // `operand` key and value pairs.
+  kArray,
+  kHash,
+  kIndex,
+  // Calls the function below the top `operand` arguments.
+  kCall,
+  // Ends the call, or at the top level the program, with the top value.
+  kReturn,
+  // Makes a closure of function `operand` of the module.
+  kClosure,
+  // Opens and closes the frame of a top-level block with `operand` slots.
+  kEnterBlock,
+  kLeaveBlock,
+};
+
+[[nodiscard]] bool has_operand(Opcode opcode);
+[[nodiscard]] std::string_view to_string(Opcode opcode);
+
+// A function literal, or the top level of a program, compiled.
+struct CompiledFunction {
+  std::vector<uint8_t> code;
+  // As in ast::FunctionLiteral, which resolution may rebind to another
+  // program later, so they are copied.
+  uint32_t frame_size = 0;
+  bool frame_escapes = false;
+  std::vector<ast::Capture> captures;
+  std::vector<ast::Capture> captured_frames;
+  // Kept for printing the function; empty at the top level.
+  std::vector<std::shared_ptr<ast::Identifier>> parameters;
+  std::shared_ptr<ast::BlockStatement> body;
+};
+
+// A name and where to look for it, see ast::Identifier::address().
+// Addresses are empty for a global.
+struct Name {
+  ast::Symbol symbol;
+  std::vector<ast::Address> addresses;
+};
+
+// Everything a program compiles to. Closures keep the module alive, since
+// their code refers to its pools and functions by index.
+struct Module {
+  // The top level is function 0.
+  std::vector<CompiledFunction> functions;
+  std::vector<int64_t> integers;
+  std::vector<std::shared_ptr<object::Object>> constants;
+  std::vector<Name> names;
+  // Owns the nodes the functions' parameters and body point to, unless it
+  // is null.
+  std::shared_ptr<const ast::AstArena> arena;
+};
+
+// One instruction per line, each function after a header naming it.
+std::string disassemble(const Module& module);
+
+}  // namespace monkey::compiler
+
+#endif  // MONKEY_COMPILER_BYTECODE_H_
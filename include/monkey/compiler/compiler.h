@@ -0,0 +1,19 @@
+#ifndef MONKEY_COMPILER_COMPILER_H_
+#define MONKEY_COMPILER_COMPILER_H_
+
+#include <monkey/ast/ast.h>
+#include <monkey/compiler/bytecode.h>
+
+#include <memory>
+
+namespace monkey::compiler {
+
+// Resolves the program, see ast::resolve(), and compiles it for vm::run().
+// Locals become slot numbers and each function literal a function of the
+// module; a function's code only ever jumps forward, since Monkey has no
+// loops.
+std::shared_ptr<const Module> compile(const ast::Program& program);
+
+}  // namespace monkey::compiler
+
+#endif  // MONKEY_COMPILER_COMPILER_H_
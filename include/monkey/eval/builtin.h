@@ -30,6 +30,16 @@ std::shared_ptr<object::Object> push(
 std::shared_ptr<object::Object> puts(
     const std::vector<std::shared_ptr<object::Object>>& args);
 
+// memo(fn) or memo(fn, capacity): a copy of a pure function that caches its
+// results, see object::MemoTable.
+std::shared_ptr<object::Object> memo(
+    const std::vector<std::shared_ptr<object::Object>>& args);
+
+// The hits, misses, size and capacity of a function's cache, or null if it
+// has none.
+std::shared_ptr<object::Object> memo_stats(
+    const std::vector<std::shared_ptr<object::Object>>& args);
+
 }  // namespace builtin
 
 namespace error {
@@ -39,6 +49,10 @@ std::shared_ptr<object::Object> unknown_identifier(const std::string& name);
 std::shared_ptr<object::Object> wrong_number_of_arguments(
     const std::string& name, size_t expected, size_t got);
 
+// For a builtin taking from `min` to `max` arguments.
+std::shared_ptr<object::Object> wrong_number_of_arguments(
+    const std::string& name, size_t min, size_t max, size_t got);
+
 std::shared_ptr<object::Object> wrong_argument_type(const std::string& name,
                                                     object::ObjectType expected,
                                                     object::ObjectType got);
@@ -55,9 +69,16 @@ std::shared_ptr<object::Object> wrong_infix_operands(
 std::shared_ptr<object::Object> wrong_index_operands(object::ObjectType left,
                                                      object::ObjectType right);
 
+std::shared_ptr<object::Object> impure_function(const std::string& name);
+
+// For a builtin that needs what only the tree-walking evaluator knows.
+std::shared_ptr<object::Object> unsupported_builtin(const std::string& name);
+
 std::shared_ptr<object::Object> wrong_call_operand(const std::string& name,
                                                    object::ObjectType type);
 
+std::shared_ptr<object::Object> call_depth_exceeded();
+
 }  // namespace error
 
 }  // namespace monkey::eval
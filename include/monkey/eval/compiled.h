@@ -0,0 +1,66 @@
+#ifndef MONKEY_EVAL_COMPILED_H_
+#define MONKEY_EVAL_COMPILED_H_
+
+#include <monkey/ast/ast.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace monkey::eval {
+
+// A function literal turned into closures by evalCompiled().
+struct Prototype;
+
+// A function made by a program run with evalCompiled(): object::Function
+// with its body already compiled. Programs run that way make no other kind
+// of function, so a call can tell it apart by type() alone.
+class BoundFunction : public object::Object {
+ public:
+  BoundFunction(std::shared_ptr<const Prototype> prototype,
+                std::shared_ptr<object::Env> env,
+                std::vector<std::shared_ptr<object::Object>> captures,
+                std::vector<std::shared_ptr<object::Env>> frames);
+
+  [[nodiscard]] object::ObjectType type() const override {
+    return object::ObjectType::kFunction;
+  }
+
+  [[nodiscard]] std::string to_string() const override;
+
+  // Functions are equal if they were made from the same function literal.
+  bool operator==(const Object& other) const override;
+  bool operator!=(const Object& other) const override;
+
+  [[nodiscard]] const Prototype& prototype() const { return *prototype_; }
+  [[nodiscard]] const std::shared_ptr<object::Env>& env() const {
+    return env_;
+  }
+  [[nodiscard]] const std::vector<std::shared_ptr<object::Object>>& captures()
+      const {
+    return captures_;
+  }
+  [[nodiscard]] const std::vector<std::shared_ptr<object::Env>>& frames()
+      const {
+    return frames_;
+  }
+
+ private:
+  std::shared_ptr<const Prototype> prototype_;
+  std::shared_ptr<object::Env> env_;
+  std::vector<std::shared_ptr<object::Object>> captures_;
+  std::vector<std::shared_ptr<object::Env>> frames_;
+};
+
+// Evaluates a program with the same semantics as eval(), after turning
+// every node into a closure that calls those of its children directly,
+// with operators and bindings picked while compiling. Running it takes no
+// switch over node types and no dynamic_cast.
+std::shared_ptr<object::Object> evalCompiled(const ast::Program& program,
+                                             std::shared_ptr<object::Env>& env);
+
+}  // namespace monkey::eval
+
+#endif  // MONKEY_EVAL_COMPILED_H_
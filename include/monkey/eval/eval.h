@@ -2,9 +2,14 @@
 #define MONKEY_EVAL_EVAL_H_
 
 #include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/lexer/token.h>
 #include <monkey/object/object.h>
 
+#include <array>
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 namespace monkey::eval {
 
@@ -68,6 +73,39 @@ std::shared_ptr<object::Object> evalIndexExpression(
     const ast::IndexExpression& index_expression,
     std::shared_ptr<object::Env>&);
 
+// Semantics shared by every evaluation strategy. Operands are already
+// evaluated and are never errors.
+
+std::shared_ptr<object::Object> evalPrefixOperator(
+    lexer::TokenType op, const std::shared_ptr<object::Object>& right);
+
+std::shared_ptr<object::Object> evalInfixOperator(
+    lexer::TokenType op, const std::shared_ptr<object::Object>& left,
+    const std::shared_ptr<object::Object>& right);
+
+std::shared_ptr<object::Object> evalIndexOperator(
+    const std::shared_ptr<object::Object>& left,
+    const std::shared_ptr<object::Object>& index);
+
+std::shared_ptr<object::Object> applyFunction(
+    const std::shared_ptr<object::Object>& function,
+    const std::vector<std::shared_ptr<object::Object>>& args);
+
+bool isTruthy(const object::Object& condition);
+
+// How the tree-walker has specialized infix expressions, summed over every
+// evaluation in the process, on any thread.
+struct QuickeningStats {
+  // Expressions that took each specialization, indexed by it. A site that
+  // falls back to kGeneric is counted under both.
+  std::array<size_t, ast::InfixExpression::kSpecializations> sites{};
+  // Guards that failed, each turning a specialized site generic.
+  size_t deoptimizations = 0;
+};
+
+// A snapshot: evaluations still running keep counting after it is taken.
+QuickeningStats quickening_stats();
+
 }  // namespace monkey::eval
 
 #endif  // MONKEY_EVAL_EVAL_H_
@@ -0,0 +1,29 @@
+#ifndef MONKEY_EVAL_FLAT_H_
+#define MONKEY_EVAL_FLAT_H_
+
+#include <monkey/ast/flat.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+
+#include <memory>
+#include <vector>
+
+namespace monkey::eval {
+
+// Evaluates an ast::FlatProgram with the same semantics as eval() on the
+// tree it was flattened from. Functions it creates keep the program alive.
+std::shared_ptr<object::Object> evalFlatProgram(
+    const std::shared_ptr<const ast::FlatProgram>& program,
+    std::shared_ptr<object::Env>& env);
+
+std::shared_ptr<object::Object> evalFlatNode(
+    const std::shared_ptr<const ast::FlatProgram>& program,
+    ast::NodeIndex index, std::shared_ptr<object::Env>& env);
+
+std::shared_ptr<object::Object> applyFlatFunction(
+    const object::FlatFunction& function,
+    const std::vector<std::shared_ptr<object::Object>>& args);
+
+}  // namespace monkey::eval
+
+#endif  // MONKEY_EVAL_FLAT_H_
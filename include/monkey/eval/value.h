@@ -0,0 +1,86 @@
+#ifndef MONKEY_EVAL_VALUE_H_
+#define MONKEY_EVAL_VALUE_H_
+
+#include <monkey/lexer/token.h>
+#include <monkey/object/object.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace monkey::eval {
+
+// An integer or boolean that is not boxed, or any other object, errors
+// included. Engines pass these between the parts of an expression and box
+// only what they store or hand out. Unset stands for a slot that has not
+// been assigned yet.
+struct Value {
+  enum class Kind : uint8_t { kUnset, kInteger, kBoolean, kObject };
+
+  Kind kind = Kind::kUnset;
+  bool boolean = false;
+  int64_t integer = 0;
+  std::shared_ptr<object::Object> object;
+};
+
+inline Value integer(int64_t value) {
+  return {.kind = Value::Kind::kInteger,
+          .boolean = false,
+          .integer = value,
+          .object = nullptr};
+}
+
+inline Value boolean(bool value) {
+  return {.kind = Value::Kind::kBoolean,
+          .boolean = value,
+          .integer = 0,
+          .object = nullptr};
+}
+
+// Any object as it is, even an integer or a boolean.
+inline Value wrap(std::shared_ptr<object::Object> object) {
+  return {.kind = Value::Kind::kObject,
+          .boolean = false,
+          .integer = 0,
+          .object = std::move(object)};
+}
+
+// type() is enough to tell which object it is, without a dynamic_cast.
+inline Value unbox(std::shared_ptr<object::Object> object) {
+  switch (object->type()) {
+    case object::ObjectType::kInteger:
+      return integer(static_cast<const object::Integer&>(*object).value());
+    case object::ObjectType::kBoolean:
+      return boolean(static_cast<const object::Boolean&>(*object).value());
+    default:
+      return wrap(std::move(object));
+  }
+}
+
+// Null for an unset value.
+inline std::shared_ptr<object::Object> box(Value value) {
+  switch (value.kind) {
+    case Value::Kind::kInteger:
+      return std::make_shared<object::Integer>(value.integer);
+    case Value::Kind::kBoolean:
+      return std::make_shared<object::Boolean>(value.boolean);
+    default:
+      return std::move(value.object);
+  }
+}
+
+inline bool failed(const Value& value) {
+  return value.kind == Value::Kind::kObject &&
+         value.object->type() == object::ObjectType::kError;
+}
+
+bool isTruthy(const Value& condition);
+
+// The operators of eval.h on values. Operands that are not plain integers
+// or booleans take the boxed path, which also words the errors.
+Value evalPrefixOperator(lexer::TokenType op, Value right);
+Value evalInfixOperator(lexer::TokenType op, Value left, Value right);
+
+}  // namespace monkey::eval
+
+#endif  // MONKEY_EVAL_VALUE_H_
@@ -1,17 +1,25 @@
 #ifndef MONKEY_LEXER_LEXER_H_
 #define MONKEY_LEXER_LEXER_H_
 
+#include <monkey/lexer/source.h>
 #include <monkey/lexer/token.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace monkey::lexer {
 
 class Lexer {
  public:
+  // Tokens view into the source text, which the Lexer keeps alive; tokens
+  // must not outlive the Lexer (or another owner of its source).
   explicit Lexer(std::string input);
+  explicit Lexer(std::shared_ptr<const Source> source);
 
   class Iterator;
 
@@ -20,15 +28,26 @@ class Lexer {
   [[nodiscard]] Iterator cbegin() const;
   [[nodiscard]] Iterator cend() const;
 
+  // Lexes the whole input in a single pass into a contiguous buffer. The
+  // buffer always ends with a kEOF token.
+  [[nodiscard]] std::vector<Token> tokenize() const;
+
+  [[nodiscard]] const std::shared_ptr<const Source>& source() const {
+    return source_;
+  }
+
  private:
-  std::string input_;
+  std::shared_ptr<const Source> source_;
+  std::string_view input_;
+  size_t base_;
 };
 
 class Lexer::Iterator : public std::iterator<std::forward_iterator_tag, Token> {
  public:
   Iterator() = default;
-  Iterator(std::string::const_iterator start_location,
-           std::string::const_iterator end_location);
+  // Tokens are given offsets counting from `base` at start_location.
+  Iterator(const char* start_location, const char* end_location,
+           size_t base = 0);
   Iterator(const Iterator& other);
   Iterator(Iterator&& other) noexcept = default;
   Iterator& operator=(const Iterator& other);
@@ -46,6 +65,8 @@ class Lexer::Iterator : public std::iterator<std::forward_iterator_tag, Token> {
   Token operator->() const;
 
  private:
+  friend class Lexer;
+
   class IteratorImpl;
 
   std::shared_ptr<IteratorImpl> impl_;
@@ -54,8 +75,8 @@ class Lexer::Iterator : public std::iterator<std::forward_iterator_tag, Token> {
 class Lexer::Iterator::IteratorImpl {
  public:
   IteratorImpl() = default;
-  IteratorImpl(std::string::const_iterator start_location,
-               std::string::const_iterator end_location);
+  IteratorImpl(const char* start_location, const char* end_location,
+               size_t base);
   IteratorImpl(const IteratorImpl& other) = default;
   IteratorImpl(IteratorImpl&& other) noexcept = default;
   IteratorImpl& operator=(const IteratorImpl& other) = default;
@@ -68,9 +89,12 @@ class Lexer::Iterator::IteratorImpl {
   Token next_token();
 
  private:
-  std::string::const_iterator current_location_;
-  std::string::const_iterator peek_location_;
-  std::string::const_iterator end_location_;
+  const char* current_location_ = nullptr;
+  const char* end_location_ = nullptr;
+  const char* start_location_ = nullptr;
+  size_t base_ = 0;
+
+  [[nodiscard]] uint32_t offset(const char* location) const;
 
   [[nodiscard]] char current_char() const;
   [[nodiscard]] char peek_char() const;
@@ -78,9 +102,11 @@ class Lexer::Iterator::IteratorImpl {
   void read_char();
   void skip_whitespace();
 
-  std::string read_identifier();
-  std::string read_integer();
-  std::string read_string();
+  [[nodiscard]] std::string_view slice(const char* start) const;
+
+  std::string_view read_identifier();
+  std::string_view read_integer();
+  std::string_view read_string();
 };
 
 }  // namespace monkey::lexer
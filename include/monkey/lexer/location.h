@@ -0,0 +1,47 @@
+#ifndef MONKEY_LEXER_LOCATION_H_
+#define MONKEY_LEXER_LOCATION_H_
+
+#include <monkey/lexer/source.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace monkey::lexer {
+
+// A 1-based line and a 1-based column counted in bytes.
+struct Location {
+  uint32_t line = 1;
+  uint32_t column = 1;
+
+  bool operator==(const Location& rhs) const = default;
+};
+
+// Resolves the byte offsets carried by tokens and AST nodes to lines and
+// columns. The line starts of the source are only found on the first lookup,
+// so keeping a table per file costs nothing until a location is needed.
+// Lookups are thread-safe.
+class LineTable {
+ public:
+  explicit LineTable(std::shared_ptr<const Source> source);
+
+  // Offsets count from the start of the file, as in Source::offset(); ones
+  // past the end of the source resolve to its end.
+  [[nodiscard]] Location locate(uint32_t offset) const;
+
+  [[nodiscard]] size_t line_count() const;
+
+ private:
+  void build() const;
+
+  std::shared_ptr<const Source> source_;
+  mutable std::once_flag built_;
+  // Offset into the source text of the first byte of each line.
+  mutable std::vector<uint32_t> line_starts_;
+};
+
+}  // namespace monkey::lexer
+
+#endif  // MONKEY_LEXER_LOCATION_H_
@@ -0,0 +1,89 @@
+#ifndef MONKEY_LEXER_SOURCE_H_
+#define MONKEY_LEXER_SOURCE_H_
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace monkey::lexer {
+
+class SourceError : public std::exception {
+ public:
+  explicit SourceError(std::string message);
+
+  [[nodiscard]] const char* what() const noexcept override {
+    return message_.c_str();
+  }
+
+ private:
+  std::string message_;
+};
+
+// Read-only text scanned by a Lexer. Tokens view into it, so a source must
+// outlive every token lexed from it.
+class Source {
+ public:
+  Source() = default;
+  Source(const Source&) = delete;
+  Source(Source&&) = delete;
+  Source& operator=(const Source&) = delete;
+  Source& operator=(Source&&) = delete;
+  virtual ~Source() = default;
+
+  [[nodiscard]] virtual std::string_view text() const = 0;
+  // Where text() starts in the file it was taken from, so that token
+  // offsets are file positions even when only part of a file is lexed.
+  [[nodiscard]] virtual size_t offset() const { return 0; }
+};
+
+class StringSource : public Source {
+ public:
+  explicit StringSource(std::string text, size_t offset = 0);
+
+  [[nodiscard]] std::string_view text() const override { return text_; }
+  [[nodiscard]] size_t offset() const override { return offset_; }
+
+ private:
+  std::string text_;
+  size_t offset_;
+};
+
+// A window into another source, which it keeps alive.
+class SourceSlice : public Source {
+ public:
+  SourceSlice(std::shared_ptr<const Source> parent, std::string_view text);
+
+  [[nodiscard]] std::string_view text() const override { return text_; }
+  [[nodiscard]] size_t offset() const override { return offset_; }
+
+ private:
+  std::shared_ptr<const Source> parent_;
+  std::string_view text_;
+  size_t offset_;
+};
+
+// Maps a file read-only into memory so it can be lexed without being copied.
+class MappedFileSource : public Source {
+ public:
+  explicit MappedFileSource(const std::string& path);
+  MappedFileSource(const MappedFileSource&) = delete;
+  MappedFileSource(MappedFileSource&&) = delete;
+  MappedFileSource& operator=(const MappedFileSource&) = delete;
+  MappedFileSource& operator=(MappedFileSource&&) = delete;
+  ~MappedFileSource() override;
+
+  [[nodiscard]] std::string_view text() const override {
+    return {data_, size_};
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  std::string fallback_;
+};
+
+}  // namespace monkey::lexer
+
+#endif  // MONKEY_LEXER_SOURCE_H_
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef MONKEY_LEXER_STREAM_H_
+#define MONKEY_LEXER_STREAM_H_
+
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/token.h>
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace monkey::lexer {
+
+// Finds the ends of top-level statements by tracking bracket nesting and
+// string literals, without lexing. State carries over between calls, so the
+// input may be split anywhere.
+class StatementScanner {
+ public:
+  // Scans text that continues where the previous call stopped. Returns the
+  // offset just past the last top-level ';' in text, or 0 if there is none.
+  size_t scan(std::string_view text);
+  // Like scan(), but stops after the first top-level ';' in text.
+  size_t scan_one(std::string_view text);
+
+ private:
+  // Advances over one character, returning whether it ends a statement.
+  bool step(char ch);
+
+  size_t depth_ = 0;
+  bool in_string_ = false;
+};
+
+// Splits text into runs of complete top-level statements of roughly
+// chunk_size bytes each, or longer where one statement spans more. Only the
+// bracket and string state is tracked, which is far cheaper than lexing.
+class StatementSplitter {
+ public:
+  StatementSplitter(std::string_view text, size_t chunk_size);
+
+  std::optional<std::string_view> next();
+
+ private:
+  std::string_view text_;
+  size_t chunk_size_;
+  StatementScanner scanner_;
+  size_t start_ = 0;
+  size_t scanned_ = 0;
+};
+
+// A run of complete top-level statements. The tokens end with kEOF and view
+// into source, which the batch keeps alive.
+struct TokenBatch {
+  std::shared_ptr<const Source> source;
+  std::vector<Token> tokens;
+};
+
+// Lexes input that arrives in chunks, such as stdin or a pipe. Text is only
+// buffered until the top-level statements it belongs to are complete, so a
+// token split across chunks is lexed once its remainder arrives.
+class ChunkedLexer {
+ public:
+  void feed(std::string_view chunk);
+  // Flushes whatever text is left, complete or not, as a final batch.
+  void finish();
+
+  std::optional<TokenBatch> next_batch();
+
+ private:
+  void emit(size_t length);
+
+  StatementScanner scanner_;
+  std::string pending_;
+  // Bytes emitted so far, the file offset of pending_.
+  size_t consumed_ = 0;
+  std::deque<TokenBatch> batches_;
+};
+
+// Lexes a complete source a run of top-level statements at a time. Batches
+// view into the source rather than copying it, so statements can be handled
+// before the rest of a large (e.g. memory-mapped) file has been touched.
+class BatchedLexer {
+ public:
+  explicit BatchedLexer(std::shared_ptr<const Source> source,
+                        size_t batch_size = kDefaultBatchSize);
+
+  std::optional<TokenBatch> next_batch();
+
+  static constexpr size_t kDefaultBatchSize = 1 << 16;
+
+ private:
+  std::shared_ptr<const Source> source_;
+  StatementSplitter splitter_;
+};
+
+}  // namespace monkey::lexer
+
+#endif  // MONKEY_LEXER_STREAM_H_
\ No newline at end of file
@@ -1,12 +1,16 @@
 #ifndef MONKEY_LEXER_TOKEN_H_
 #define MONKEY_LEXER_TOKEN_H_
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 namespace monkey::lexer {
 
-enum class TokenType {
+enum class TokenType : uint8_t {
   kIllegal,
   kEOF,
 
@@ -54,40 +58,82 @@ std::string to_string(TokenType type);
 
 std::string to_operator(TokenType type);
 
+// Byte offsets are 32-bit; positions past 4 GiB saturate to this.
+inline constexpr uint32_t kMaxOffset = std::numeric_limits<uint32_t>::max();
+
+// A token does not own its literal: it views into the source text handed to
+// the Lexer, which must outlive every token produced from it.
 class Token {
  public:
-  Token(TokenType type, std::string literal);
+  Token(TokenType type, std::string_view literal, uint32_t offset = 0);
 
+  // Compares type and literal only, not where the token was found.
   bool operator==(const Token& rhs) const;
   bool operator!=(const Token& rhs) const;
 
   [[nodiscard]] TokenType type() const { return type_; }
-  [[nodiscard]] std::string literal() const { return literal_; }
+  [[nodiscard]] std::string_view literal() const { return literal_; }
+  // Byte offset of the token's first character (a string's opening quote)
+  // in the file it was lexed from; see Source::offset().
+  [[nodiscard]] uint32_t offset() const { return offset_; }
 
   friend std::string to_string(const Token& token);
 
  private:
   TokenType type_;
-  std::string literal_;
+  uint32_t offset_;
+  std::string_view literal_;
 };  // class Token
 
-const std::unordered_map<std::string, TokenType> kKeywords = {
-    {"fn", TokenType::kFunction},   {"let", TokenType::kLet},
-    {"true", TokenType::kTrue},     {"false", TokenType::kFalse},
-    {"if", TokenType::kIf},         {"else", TokenType::kElse},
-    {"return", TokenType::kReturn},
+// The offset sits in what used to be padding after the type.
+static_assert(sizeof(Token) == sizeof(std::string_view) + sizeof(uint64_t));
+
+inline constexpr size_t kTokenTypeCount =
+    static_cast<size_t>(TokenType::kReturn) + 1;
+
+constexpr size_t to_index(TokenType type) { return static_cast<size_t>(type); }
+
+struct Keyword {
+  std::string_view word;
+  TokenType type = TokenType::kIdentifer;
 };
 
-const std::unordered_map<char, TokenType> kSingleCharTokens = {
-    {'=', TokenType::kAssign},       {'+', TokenType::kPlus},
-    {'-', TokenType::kMinus},        {'!', TokenType::kBang},
-    {'*', TokenType::kAsterisk},     {'/', TokenType::kSlash},
-    {'<', TokenType::kLessThan},     {'>', TokenType::kGreaterThan},
-    {',', TokenType::kComma},        {';', TokenType::kSemicolon},
-    {':', TokenType::kColon},        {'(', TokenType::kLeftParen},
-    {')', TokenType::kRightParen},   {'{', TokenType::kLeftBrace},
-    {'}', TokenType::kRightBrace},   {'[', TokenType::kLeftBracket},
-    {']', TokenType::kRightBracket}, {'\0', TokenType::kEOF}};
+inline constexpr std::array<Keyword, 7> kKeywords = {{
+    {"fn", TokenType::kFunction},
+    {"let", TokenType::kLet},
+    {"true", TokenType::kTrue},
+    {"false", TokenType::kFalse},
+    {"if", TokenType::kIf},
+    {"else", TokenType::kElse},
+    {"return", TokenType::kReturn},
+}};
+
+// Indexed by the byte value; every byte that does not start a single
+// character token maps to kIllegal.
+inline constexpr std::array<TokenType, 256> kSingleCharTokens = [] {
+  std::array<TokenType, 256> tokens{};
+  tokens.fill(TokenType::kIllegal);
+  tokens['='] = TokenType::kAssign;
+  tokens['+'] = TokenType::kPlus;
+  tokens['-'] = TokenType::kMinus;
+  tokens['!'] = TokenType::kBang;
+  tokens['*'] = TokenType::kAsterisk;
+  tokens['/'] = TokenType::kSlash;
+  tokens['<'] = TokenType::kLessThan;
+  tokens['>'] = TokenType::kGreaterThan;
+  tokens[','] = TokenType::kComma;
+  tokens[';'] = TokenType::kSemicolon;
+  tokens[':'] = TokenType::kColon;
+  tokens['('] = TokenType::kLeftParen;
+  tokens[')'] = TokenType::kRightParen;
+  tokens['{'] = TokenType::kLeftBrace;
+  tokens['}'] = TokenType::kRightBrace;
+  tokens['['] = TokenType::kLeftBracket;
+  tokens[']'] = TokenType::kRightBracket;
+  tokens['\0'] = TokenType::kEOF;
+  return tokens;
+}();
+
 }  // namespace monkey::lexer
 
 #endif  // MONKEY_LEXER_TOKEN_H_
\ No newline at end of file
@@ -1,24 +1,74 @@
 #ifndef MONKEY_OBJECT_ENV_H_
 #define MONKEY_OBJECT_ENV_H_
 
+#include <monkey/ast/symbol.h>
+
+#include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace monkey::object {
 
 class Object;
+class Function;
 
+// A scope. Globals, and the scopes of code evaluated without resolution, are
+// maps from names. Resolved code keeps its locals in frames, arrays of slots
+// with no names at all, whose outer scope is always a named one.
 class Env {
  public:
   Env();
   explicit Env(std::shared_ptr<Env> outer);
+  // A frame of `size` unset slots for a call of `function`, or for a block
+  // at the top level if it is null.
+  Env(std::shared_ptr<Env> outer, size_t size,
+      const Function* function = nullptr);
+
+  // Makes a frame ready for another call, as if it had just been made.
+  void reset(std::shared_ptr<Env> outer, size_t size,
+             const Function* function);
+
+  [[nodiscard]] bool is_frame() const { return frame_; }
+  [[nodiscard]] const std::shared_ptr<Env>& outer() const { return outer_; }
+
+  // Null while the slot is unset.
+  [[nodiscard]] const std::shared_ptr<Object>& slot(uint32_t index) const {
+    return slots_[index];
+  }
+  void set_slot(uint32_t index, std::shared_ptr<Object> value) {
+    slots_[index] = std::move(value);
+  }
+  // The function being called, for its captures. Only valid while the call
+  // runs: closures that keep the frame afterwards read its slots alone.
+  [[nodiscard]] const Function* function() const { return function_; }
+
+  // Looks through the named scopes only, skipping frames.
+  void set(ast::Symbol name, std::shared_ptr<Object> value);
+  std::shared_ptr<Object> get(ast::Symbol name) const;
+  // Interns the name first; for callers outside the evaluator.
+  void set(std::string_view name, std::shared_ptr<Object> value);
+  std::shared_ptr<Object> get(std::string_view name) const;
+
+  // Bumped whenever a name is bound again, which could change what a
+  // function reading it returns. Binding a new name does not count.
+  [[nodiscard]] uint64_t version() const { return version_; }
 
-  void set(const std::string &name, std::shared_ptr<Object> value);
-  std::shared_ptr<Object> get(const std::string &name) const;
+  // Results a pure function defined in this environment caches, see
+  // MemoTable; 0, the default, caches nothing unless memo() asks to.
+  [[nodiscard]] size_t memo_capacity() const { return memo_capacity_; }
+  void set_memo_capacity(size_t capacity) { memo_capacity_ = capacity; }
 
  private:
-  std::unordered_map<std::string, std::shared_ptr<Object>> store_;
+  std::vector<std::shared_ptr<Object>> slots_;
+  const Function* function_ = nullptr;
+  bool frame_ = false;
+  std::unordered_map<ast::Symbol, std::shared_ptr<Object>> store_;
+  uint64_t version_ = 0;
+  size_t memo_capacity_ = 0;
   std::shared_ptr<Env> outer_;
 };
 
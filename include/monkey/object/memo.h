@@ -0,0 +1,79 @@
+#ifndef MONKEY_OBJECT_MEMO_H_
+#define MONKEY_OBJECT_MEMO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace monkey::object {
+
+class Object;
+
+// Counts calls of builtins with side effects. A call that changed the count
+// did something a cached result would skip, so it must not be cached.
+uint64_t effect_count();
+void record_effect();
+
+// The results of a pure function by the values of its arguments, evicting
+// the least recently used once full. Integers, booleans, strings, null and
+// arrays and hashes of them are compared by value; calls with any other
+// argument are not cached. Entries are only valid for the version of the
+// globals they were made under, see Env::version().
+class MemoTable {
+ public:
+  using Arguments = std::vector<std::shared_ptr<Object>>;
+
+  static constexpr size_t kDefaultCapacity = 4096;
+
+  explicit MemoTable(size_t capacity = kDefaultCapacity);
+
+  // Null on a miss. Only calls that could be cached count as hits or
+  // misses.
+  std::shared_ptr<Object> find(const Arguments& args, uint64_t version);
+  void insert(const Arguments& args, std::shared_ptr<Object> result,
+              uint64_t version);
+
+  [[nodiscard]] uint64_t hits() const { return hits_; }
+  [[nodiscard]] uint64_t misses() const { return misses_; }
+  [[nodiscard]] size_t size() const { return entries_.size(); }
+  [[nodiscard]] size_t capacity() const { return capacity_; }
+
+ private:
+  struct Entry {
+    Arguments args;
+    std::shared_ptr<Object> result;
+    size_t hash;
+  };
+
+  // Points into the entry, whose place in the list never moves.
+  struct Key {
+    const Arguments* args;
+    size_t hash;
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const { return key.hash; }
+  };
+
+  struct KeyEqual {
+    bool operator()(const Key& lhs, const Key& rhs) const;
+  };
+
+  void reset(uint64_t version);
+
+  size_t capacity_;
+  uint64_t version_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+  // Most recently used first.
+  std::list<Entry> entries_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash, KeyEqual>
+      index_;
+};
+
+}  // namespace monkey::object
+
+#endif  // MONKEY_OBJECT_MEMO_H_
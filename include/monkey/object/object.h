@@ -2,24 +2,29 @@
 #define MONKEY_OBJECT_OBJECT_H_
 
 #include <monkey/ast/ast.h>
+#include <monkey/ast/flat.h>
 
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace monkey::object {
 
 class Env;
+class MemoTable;
 
 enum class ObjectType {
   kInteger,
   kBoolean,
   kNull,
   kReturnValue,
+  kTailCall,
   kFunction,
   kString,
   kArray,
@@ -118,10 +123,34 @@ class ReturnValue : public Object {
   std::shared_ptr<Object> value_;
 };
 
+// What a call in tail position yields in place of its value: the evaluator
+// makes the call once the function it returns from has left its frame.
+// Like a ReturnValue, it never gets past that function.
+class TailCall : public Object {
+ public:
+  TailCall() noexcept;
+
+  [[nodiscard]] ObjectType type() const override {
+    return ObjectType::kTailCall;
+  }
+
+  [[nodiscard]] std::string to_string() const override;
+
+  bool operator==(const Object& other) const override;
+  bool operator!=(const Object& other) const override;
+};
+
 class Function : public Object {
  public:
+  // `arena` owns the nodes of `parameters` and `body`, unless it is null.
+  // `env` is the global scope: everything else the body refers to is in
+  // `captures`, or in the slots of `frames` if it could still change.
   Function(std::vector<std::shared_ptr<ast::Identifier>> parameters,
-           std::shared_ptr<ast::BlockStatement> body, std::shared_ptr<Env> env);
+           std::shared_ptr<ast::BlockStatement> body,
+           std::shared_ptr<const ast::AstArena> arena, std::shared_ptr<Env> env,
+           size_t frame_size, std::vector<std::shared_ptr<Object>> captures,
+           std::vector<std::shared_ptr<Env>> frames, bool pure = false,
+           bool frame_escapes = true);
 
   [[nodiscard]] ObjectType type() const override {
     return ObjectType::kFunction;
@@ -142,10 +171,68 @@ class Function : public Object {
   }
 
   [[nodiscard]] const std::shared_ptr<Env>& env() const { return env_; }
+  // Slots in the frame of a call, see ast::FunctionLiteral::frame_size().
+  [[nodiscard]] size_t frame_size() const { return frame_size_; }
+  // See ast::FunctionLiteral::frame_escapes().
+  [[nodiscard]] bool frame_escapes() const { return frame_escapes_; }
+  [[nodiscard]] const std::vector<std::shared_ptr<Object>>& captures() const {
+    return captures_;
+  }
+  [[nodiscard]] const std::vector<std::shared_ptr<Env>>& frames() const {
+    return frames_;
+  }
+
+  // Whether a call depends only on its arguments and the globals, see
+  // ast::FunctionLiteral::pure(), so that its result can be cached.
+  [[nodiscard]] bool pure() const { return pure_; }
+  // The cache of the function's results, or null if they are not cached.
+  [[nodiscard]] MemoTable* memo() const { return memo_.get(); }
+  void set_memo(std::shared_ptr<MemoTable> memo) { memo_ = std::move(memo); }
 
  private:
   std::vector<std::shared_ptr<ast::Identifier>> parameters_;
   std::shared_ptr<ast::BlockStatement> body_;
+  std::shared_ptr<const ast::AstArena> arena_;
+  std::shared_ptr<Env> env_;
+  size_t frame_size_;
+  std::vector<std::shared_ptr<Object>> captures_;
+  std::vector<std::shared_ptr<Env>> frames_;
+  bool pure_;
+  bool frame_escapes_;
+  std::shared_ptr<MemoTable> memo_;
+};
+
+// A function literal evaluated from an ast::FlatProgram, which it keeps alive.
+class FlatFunction : public Object {
+ public:
+  FlatFunction(std::shared_ptr<const ast::FlatProgram> program,
+               ast::NodeIndex literal, std::shared_ptr<Env> env);
+
+  [[nodiscard]] ObjectType type() const override {
+    return ObjectType::kFunction;
+  }
+
+  [[nodiscard]] std::string to_string() const override;
+
+  bool operator==(const Object& other) const override;
+  bool operator!=(const Object& other) const override;
+
+  [[nodiscard]] const std::shared_ptr<const ast::FlatProgram>& program() const {
+    return program_;
+  }
+  [[nodiscard]] std::span<const ast::NodeIndex> parameters() const {
+    const auto& node = program_->node(literal_);
+    return program_->children(node.a, node.b);
+  }
+  [[nodiscard]] ast::NodeIndex body() const {
+    return program_->node(literal_).c;
+  }
+
+  [[nodiscard]] const std::shared_ptr<Env>& env() const { return env_; }
+
+ private:
+  std::shared_ptr<const ast::FlatProgram> program_;
+  ast::NodeIndex literal_;
   std::shared_ptr<Env> env_;
 };
 
@@ -224,7 +311,8 @@ class Builtin : public Object {
   using FunctionType = std::shared_ptr<Object>(
       const std::vector<std::shared_ptr<object::Object>>&);
 
-  explicit Builtin(FunctionType* fn);
+  // A builtin that is not pure has side effects, see record_effect().
+  explicit Builtin(FunctionType* fn, bool pure = true);
 
   [[nodiscard]] ObjectType type() const override {
     return ObjectType::kBuiltin;
@@ -236,9 +324,11 @@ class Builtin : public Object {
   bool operator!=(const Object& other) const override;
 
   [[nodiscard]] FunctionType* function() const { return function_; }
+  [[nodiscard]] bool pure() const { return pure_; }
 
  private:
   FunctionType* function_;
+  bool pure_;
 };
 
 class Error : public Object {
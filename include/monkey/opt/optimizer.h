@@ -0,0 +1,105 @@
+#ifndef MONKEY_OPT_OPTIMIZER_H_
+#define MONKEY_OPT_OPTIMIZER_H_
+
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace monkey::opt {
+
+// One rewrite over a program. The optimizer walks the tree bottom-up and
+// offers every expression and every statement list (program or block) to the
+// pass after their children have been rewritten. A pass returns its input to
+// leave it alone; new nodes must come from `arena` and take the offset of
+// the node they replace.
+class Pass {
+ public:
+  Pass() = default;
+  Pass(const Pass&) = delete;
+  Pass(Pass&&) = delete;
+  Pass& operator=(const Pass&) = delete;
+  Pass& operator=(Pass&&) = delete;
+  virtual ~Pass() = default;
+
+  [[nodiscard]] virtual std::string_view name() const = 0;
+
+  virtual std::shared_ptr<ast::Expression> rewrite(
+      const std::shared_ptr<ast::Expression>& expression,
+      ast::AstArena& arena);
+  // May erase statements; the last one is the list's value.
+  virtual void rewrite(std::vector<std::shared_ptr<ast::Statement>>& statements);
+};
+
+// Folds prefix and infix operators over literals, with the evaluator's own
+// semantics. Operations that would fail at runtime are left in place.
+class FoldConstants : public Pass {
+ public:
+  [[nodiscard]] std::string_view name() const override {
+    return "fold-constants";
+  }
+  std::shared_ptr<ast::Expression> rewrite(
+      const std::shared_ptr<ast::Expression>& expression,
+      ast::AstArena& arena) override;
+  using Pass::rewrite;
+};
+
+// Resolves if-expressions whose condition is a literal to the branch taken.
+class PruneBranches : public Pass {
+ public:
+  [[nodiscard]] std::string_view name() const override {
+    return "prune-branches";
+  }
+  std::shared_ptr<ast::Expression> rewrite(
+      const std::shared_ptr<ast::Expression>& expression,
+      ast::AstArena& arena) override;
+  using Pass::rewrite;
+};
+
+// Drops expression statements that can neither fail nor have an effect and
+// whose value is not the value of their block, and statements after a return.
+class DropUnused : public Pass {
+ public:
+  [[nodiscard]] std::string_view name() const override { return "drop-unused"; }
+  void rewrite(
+      std::vector<std::shared_ptr<ast::Statement>>& statements) override;
+  using Pass::rewrite;
+};
+
+struct PassStats {
+  std::string_view name;
+  // Expressions replaced plus statements removed, summed over runs.
+  size_t rewrites = 0;
+  std::chrono::nanoseconds time{};
+};
+
+// Runs a pipeline of passes between parsing and evaluation. The result shares
+// every unchanged subtree with the input program and keeps its arena alive.
+class Optimizer {
+ public:
+  static constexpr int kMaxLevel = 2;
+
+  // Level 0 runs nothing, 1 folds constants and prunes branches, 2 also
+  // drops unused statements.
+  explicit Optimizer(int level = 0);
+
+  void add(std::unique_ptr<Pass> pass);
+
+  std::shared_ptr<ast::Program> run(
+      const std::shared_ptr<ast::Program>& program);
+
+  [[nodiscard]] const std::vector<PassStats>& stats() const { return stats_; }
+
+ private:
+  std::vector<std::unique_ptr<Pass>> passes_;
+  std::vector<PassStats> stats_;
+};
+
+}  // namespace monkey::opt
+
+#endif  // MONKEY_OPT_OPTIMIZER_H_
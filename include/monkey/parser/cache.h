@@ -0,0 +1,36 @@
+#ifndef MONKEY_PARSER_CACHE_H_
+#define MONKEY_PARSER_CACHE_H_
+
+#include <monkey/ast/ast.h>
+#include <monkey/ast/binary.h>
+
+#include <filesystem>
+#include <memory>
+
+namespace monkey::parser {
+
+// A directory of parsed programs in the ast/binary.h encoding, one .mkc file
+// per source named by its hash. A hit maps the file and decodes it without
+// lexing or parsing.
+//
+// The cache is best effort: an entry that is missing, stale or unreadable is
+// a miss, and a failed store is only reported to the caller. Entries are
+// written to a temporary file and renamed into place, so processes sharing
+// a directory never see a partial one.
+class ProgramCache {
+ public:
+  explicit ProgramCache(std::filesystem::path directory);
+
+  [[nodiscard]] std::shared_ptr<ast::Program> load(
+      const ast::SourceKey& key) const;
+  bool store(const ast::SourceKey& key, const ast::Program& program) const;
+
+  [[nodiscard]] std::filesystem::path path(const ast::SourceKey& key) const;
+
+ private:
+  std::filesystem::path directory_;
+};
+
+}  // namespace monkey::parser
+
+#endif  // MONKEY_PARSER_CACHE_H_
@@ -3,8 +3,10 @@
 
 #include <monkey/lexer/token.h>
 
+#include <cstddef>
 #include <exception>
 #include <string>
+#include <string_view>
 
 namespace monkey::parser {
 
@@ -21,20 +23,43 @@ class ParserError : public std::exception {
   std::string message_;
 };
 
+// The syntax errors below also expose their text through message(), which
+// the recovering parse records without constructing the exception.
+
 class PeekTokenError : public ParserError {
  public:
   PeekTokenError(lexer::TokenType expect, lexer::TokenType got);
+
+  static std::string message(lexer::TokenType expect, lexer::TokenType got);
 };
 
 class HandlerNotFoundError : public ParserError {
  public:
   explicit HandlerNotFoundError(lexer::TokenType type);
+
+  static std::string message(lexer::TokenType type);
 };
 
 class InvalidIntegerError : public ParserError {
  public:
   explicit InvalidIntegerError(const std::string& literal);
   explicit InvalidIntegerError(std::string&& literal);
+
+  static std::string message(std::string_view literal);
+};
+
+// A syntax error collected by Parser::parse_program_recovering(). The token
+// views the parsed source, so its position can be recovered from there.
+struct Diagnostic {
+  std::string message;
+  lexer::Token token;
+
+  bool operator==(const Diagnostic& rhs) const = default;
+};
+
+class InvalidEditError : public ParserError {
+ public:
+  InvalidEditError(size_t offset, size_t removed, size_t size);
 };
 
 }  // namespace monkey::parser
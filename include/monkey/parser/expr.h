@@ -5,9 +5,9 @@
 #include <monkey/lexer/token.h>
 #include <monkey/parser/reader.h>
 
-#include <functional>
+#include <array>
 #include <memory>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace monkey::parser {
@@ -23,17 +23,30 @@ enum class Precedence {
   kIndex
 };
 
-const std::unordered_map<lexer::TokenType, Precedence> kPrecedences = {
-    {lexer::TokenType::kEqual, Precedence::kEquality},
-    {lexer::TokenType::kNotEqual, Precedence::kEquality},
-    {lexer::TokenType::kLessThan, Precedence::kComparison},
-    {lexer::TokenType::kGreaterThan, Precedence::kComparison},
-    {lexer::TokenType::kPlus, Precedence::kSum},
-    {lexer::TokenType::kMinus, Precedence::kSum},
-    {lexer::TokenType::kSlash, Precedence::kProduct},
-    {lexer::TokenType::kAsterisk, Precedence::kProduct},
-    {lexer::TokenType::kLeftParen, Precedence::kCall},
-    {lexer::TokenType::kLeftBracket, Precedence::kIndex}};
+inline constexpr std::array<Precedence, lexer::kTokenTypeCount> kPrecedences =
+    [] {
+      std::array<Precedence, lexer::kTokenTypeCount> precedences{};
+      precedences.fill(Precedence::kLowest);
+      precedences[lexer::to_index(lexer::TokenType::kEqual)] =
+          Precedence::kEquality;
+      precedences[lexer::to_index(lexer::TokenType::kNotEqual)] =
+          Precedence::kEquality;
+      precedences[lexer::to_index(lexer::TokenType::kLessThan)] =
+          Precedence::kComparison;
+      precedences[lexer::to_index(lexer::TokenType::kGreaterThan)] =
+          Precedence::kComparison;
+      precedences[lexer::to_index(lexer::TokenType::kPlus)] = Precedence::kSum;
+      precedences[lexer::to_index(lexer::TokenType::kMinus)] = Precedence::kSum;
+      precedences[lexer::to_index(lexer::TokenType::kSlash)] =
+          Precedence::kProduct;
+      precedences[lexer::to_index(lexer::TokenType::kAsterisk)] =
+          Precedence::kProduct;
+      precedences[lexer::to_index(lexer::TokenType::kLeftParen)] =
+          Precedence::kCall;
+      precedences[lexer::to_index(lexer::TokenType::kLeftBracket)] =
+          Precedence::kIndex;
+      return precedences;
+    }();
 
 Precedence get_precedence(lexer::TokenType type);
 
@@ -75,34 +88,70 @@ std::vector<std::shared_ptr<ast::Expression>> parse_expression_list(
 std::vector<std::shared_ptr<ast::Identifier>> parse_function_parameters(
     Reader& reader);
 
-using PrefixHandler = std::function<std::shared_ptr<ast::Expression>(Reader&)>;
-using InfixHandler = std::function<std::shared_ptr<ast::Expression>(
-    Reader&, std::shared_ptr<ast::Expression>)>;
-
-const std::unordered_map<lexer::TokenType, PrefixHandler> kPrefixHandlers = {
-    {lexer::TokenType::kIdentifer, parse_identifier},
-    {lexer::TokenType::kInteger, parse_integer_literal},
-    {lexer::TokenType::kTrue, parse_boolean_literal},
-    {lexer::TokenType::kFalse, parse_boolean_literal},
-    {lexer::TokenType::kString, parse_string_literal},
-    {lexer::TokenType::kLeftBracket, parse_array_literal},
-    {lexer::TokenType::kLeftBrace, parse_hash_literal},
-    {lexer::TokenType::kFunction, parse_function_literal},
-    {lexer::TokenType::kBang, parse_prefix_expression},
-    {lexer::TokenType::kMinus, parse_prefix_expression},
-    {lexer::TokenType::kLeftParen, parse_grouped_expression},
-    {lexer::TokenType::kIf, parse_if_expression}};
-const std::unordered_map<lexer::TokenType, InfixHandler> kInfixHandlers = {
-    {lexer::TokenType::kPlus, parse_infix_expression},
-    {lexer::TokenType::kMinus, parse_infix_expression},
-    {lexer::TokenType::kSlash, parse_infix_expression},
-    {lexer::TokenType::kAsterisk, parse_infix_expression},
-    {lexer::TokenType::kEqual, parse_infix_expression},
-    {lexer::TokenType::kNotEqual, parse_infix_expression},
-    {lexer::TokenType::kLessThan, parse_infix_expression},
-    {lexer::TokenType::kGreaterThan, parse_infix_expression},
-    {lexer::TokenType::kLeftParen, parse_call_expression},
-    {lexer::TokenType::kLeftBracket, parse_index_expression}};
+using PrefixHandler = std::shared_ptr<ast::Expression> (*)(Reader&);
+using InfixHandler = std::shared_ptr<ast::Expression> (*)(
+    Reader&, std::shared_ptr<ast::Expression>);
+
+// Adapts the typed parse functions above to the uniform handler signatures.
+template <auto Parse>
+std::shared_ptr<ast::Expression> prefix_handler(Reader& reader) {
+  return Parse(reader);
+}
+
+template <auto Parse>
+std::shared_ptr<ast::Expression> infix_handler(
+    Reader& reader, std::shared_ptr<ast::Expression> left) {
+  return Parse(reader, std::move(left));
+}
+
+// Both tables are indexed by lexer::TokenType; tokens without a handler map
+// to nullptr.
+inline constexpr std::array<PrefixHandler, lexer::kTokenTypeCount>
+    kPrefixHandlers = [] {
+      std::array<PrefixHandler, lexer::kTokenTypeCount> handlers{};
+      handlers[lexer::to_index(lexer::TokenType::kIdentifer)] =
+          prefix_handler<parse_identifier>;
+      handlers[lexer::to_index(lexer::TokenType::kInteger)] =
+          prefix_handler<parse_integer_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kTrue)] =
+          prefix_handler<parse_boolean_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kFalse)] =
+          prefix_handler<parse_boolean_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kString)] =
+          prefix_handler<parse_string_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kLeftBracket)] =
+          prefix_handler<parse_array_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kLeftBrace)] =
+          prefix_handler<parse_hash_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kFunction)] =
+          prefix_handler<parse_function_literal>;
+      handlers[lexer::to_index(lexer::TokenType::kBang)] =
+          prefix_handler<parse_prefix_expression>;
+      handlers[lexer::to_index(lexer::TokenType::kMinus)] =
+          prefix_handler<parse_prefix_expression>;
+      handlers[lexer::to_index(lexer::TokenType::kLeftParen)] =
+          prefix_handler<parse_grouped_expression>;
+      handlers[lexer::to_index(lexer::TokenType::kIf)] =
+          prefix_handler<parse_if_expression>;
+      return handlers;
+    }();
+
+inline constexpr std::array<InfixHandler, lexer::kTokenTypeCount>
+    kInfixHandlers = [] {
+      std::array<InfixHandler, lexer::kTokenTypeCount> handlers{};
+      for (const auto type :
+           {lexer::TokenType::kPlus, lexer::TokenType::kMinus,
+            lexer::TokenType::kSlash, lexer::TokenType::kAsterisk,
+            lexer::TokenType::kEqual, lexer::TokenType::kNotEqual,
+            lexer::TokenType::kLessThan, lexer::TokenType::kGreaterThan}) {
+        handlers[lexer::to_index(type)] = infix_handler<parse_infix_expression>;
+      }
+      handlers[lexer::to_index(lexer::TokenType::kLeftParen)] =
+          infix_handler<parse_call_expression>;
+      handlers[lexer::to_index(lexer::TokenType::kLeftBracket)] =
+          infix_handler<parse_index_expression>;
+      return handlers;
+    }();
 
 }  // namespace monkey::parser
 
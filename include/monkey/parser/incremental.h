@@ -0,0 +1,83 @@
+#ifndef MONKEY_PARSER_INCREMENTAL_H_
+#define MONKEY_PARSER_INCREMENTAL_H_
+
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/lexer/source.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace monkey::parser {
+
+// Replaces `removed` bytes at `offset` with `inserted`.
+struct TextEdit {
+  size_t offset = 0;
+  size_t removed = 0;
+  std::string inserted;
+};
+
+struct ReparseResult {
+  std::shared_ptr<ast::Program> program;
+  // Indices into program->statements() of the statements that were parsed
+  // anew; every other statement is shared with the previous program.
+  std::vector<size_t> changed;
+};
+
+// Keeps a script parsed across edits. The text is tracked as segments ending
+// at top-level ';', each parsed on its own. An edit relexes and reparses from
+// the segment it starts in only until the statement boundaries line up with
+// the old ones again; the statements of every other segment are reused by
+// pointer, and Program::offset() places them where they now are in the
+// text.
+class IncrementalParser {
+ public:
+  explicit IncrementalParser(std::string text);
+
+  [[nodiscard]] std::string_view text() const { return source_->text(); }
+  [[nodiscard]] const std::shared_ptr<ast::Program>& program() const {
+    return program_;
+  }
+
+  // Applies an edit and returns the updated program. If the edited text does
+  // not parse, the error is thrown and the parser keeps its previous state.
+  ReparseResult apply(const TextEdit& edit);
+
+ private:
+  struct Segment {
+    size_t begin;
+    size_t end;
+    // Number of statements the segment contributes to program_.
+    size_t statements;
+    // Index into arenas_ of the arena its nodes live in.
+    size_t generation;
+    // Added to the offsets of its nodes, which it keeps from when it was
+    // parsed however far the edits before it have moved it.
+    uint32_t shift = 0;
+  };
+
+  // Parses [begin, end) of `source` into `arena`, appending the statements.
+  static Segment parse_segment(
+      const std::shared_ptr<const lexer::StringSource>& source, size_t begin,
+      size_t end, size_t generation,
+      const std::shared_ptr<ast::AstArena>& arena,
+      std::vector<std::shared_ptr<ast::Statement>>& statements);
+  std::shared_ptr<ast::Program> assemble(
+      std::vector<std::shared_ptr<ast::Statement>> statements) const;
+
+  std::shared_ptr<const lexer::StringSource> source_;
+  std::vector<Segment> segments_;
+  // One arena per parse (the initial one and each edit), shared by all the
+  // segments it produced and released once none of them is left.
+  std::vector<std::shared_ptr<const ast::AstArena>> arenas_;
+  std::vector<size_t> arena_uses_;
+  std::shared_ptr<ast::Program> program_;
+};
+
+}  // namespace monkey::parser
+
+#endif  // MONKEY_PARSER_INCREMENTAL_H_
@@ -0,0 +1,36 @@
+#ifndef MONKEY_PARSER_PARALLEL_H_
+#define MONKEY_PARSER_PARALLEL_H_
+
+#include <monkey/ast/ast.h>
+#include <monkey/lexer/source.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace monkey::parser {
+
+// Parses a large source on a pool of threads. The text is first split at
+// top-level statement boundaries by lexer::StatementSplitter; the chunks are
+// then lexed and parsed independently and their statements joined back in
+// source order. The result is the same program Parser would produce, and a
+// syntax error is reported as the one Parser would have thrown first.
+class ParallelParser {
+ public:
+  // A thread count of zero uses one thread per hardware thread.
+  explicit ParallelParser(std::shared_ptr<const lexer::Source> source,
+                          size_t threads = 0,
+                          size_t chunk_size = kDefaultChunkSize);
+
+  std::shared_ptr<ast::Program> parse_program();
+
+  static constexpr size_t kDefaultChunkSize = 1 << 18;
+
+ private:
+  std::shared_ptr<const lexer::Source> source_;
+  size_t threads_;
+  size_t chunk_size_;
+};
+
+}  // namespace monkey::parser
+
+#endif  // MONKEY_PARSER_PARALLEL_H_
@@ -1,18 +1,43 @@
 #ifndef MONKEY_PARSER_PARSER_H_
 #define MONKEY_PARSER_PARSER_H_
 
+#include <monkey/ast/arena.h>
+#include <monkey/ast/flat.h>
+#include <monkey/parser/error.h>
 #include <monkey/parser/expr.h>
 #include <monkey/parser/stmt.h>
 
+#include <memory>
 #include <vector>
 
 namespace monkey::parser {
 
+// Outcome of a recovering parse: the statements that parsed cleanly and a
+// diagnostic for each one that did not.
+struct ParseResult {
+  std::shared_ptr<ast::Program> program;
+  std::vector<Diagnostic> diagnostics;
+
+  [[nodiscard]] bool ok() const { return diagnostics.empty(); }
+};
+
 class Parser {
  public:
   explicit Parser(const lexer::Lexer& lexer);
+  // Parses an already lexed token buffer; the tokens' source must outlive the
+  // parser.
+  explicit Parser(std::vector<lexer::Token> tokens);
+  // Allocates the nodes from `arena`, so that several parses can share one.
+  Parser(const lexer::Lexer& lexer, std::shared_ptr<ast::AstArena> arena);
 
   std::shared_ptr<ast::Program> parse_program();
+  // Parses and converts the program to the compact ast::FlatProgram layout;
+  // the intermediate tree is released before returning.
+  std::shared_ptr<const ast::FlatProgram> parse_flat_program();
+  // Parses without throwing on syntax errors: each failed top-level statement
+  // is dropped, its first error recorded, and parsing resumes after it, so
+  // one pass reports every broken statement in the input.
+  ParseResult parse_program_recovering();
 
  private:
   std::shared_ptr<Reader> reader_;
@@ -1,33 +1,83 @@
 #ifndef MONKEY_PARSER_READER_H_
 #define MONKEY_PARSER_READER_H_
 
+#include <monkey/ast/arena.h>
 #include <monkey/ast/ast.h>
 #include <monkey/lexer/lexer.h>
+#include <monkey/parser/error.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace monkey::parser {
 
+// Index cursor over a token buffer produced by lexer::Lexer::tokenize(). It
+// also carries the arena the parse functions allocate nodes from.
 class Reader {
  public:
-  Reader() = default;
-  Reader(lexer::Lexer::Iterator current_location,
-         lexer::Lexer::Iterator end_location);
+  Reader();
+  explicit Reader(std::vector<lexer::Token> tokens);
+  Reader(std::vector<lexer::Token> tokens,
+         std::shared_ptr<ast::AstArena> arena);
 
   bool operator==(const Reader& rhs) const;
   bool operator!=(const Reader& rhs) const;
 
   void next_token();
 
-  [[nodiscard]] lexer::Token current_token() const;
-  [[nodiscard]] lexer::Token peek_token() const;
+  [[nodiscard]] const lexer::Token& current_token() const;
+  [[nodiscard]] const lexer::Token& peek_token() const;
 
   [[nodiscard]] bool expect_peek(lexer::TokenType type);
   [[nodiscard]] bool current_token_is(lexer::TokenType type) const;
   [[nodiscard]] bool peek_token_is(lexer::TokenType type) const;
 
+  // Reports a syntax error of type Error at `token`. By default it is thrown;
+  // while collecting, the first error of a statement is recorded instead
+  // and the caller unwinds by returning nullptr.
+  template <typename Error, typename... Args>
+  void fail(const lexer::Token& token, const Args&... args) {
+    if (diagnostics_ == nullptr) {
+      throw Error(args...);
+    }
+    if (!failed_) {
+      failed_ = true;
+      diagnostics_->push_back({Error::message(args...), token});
+    }
+  }
+
+  // Makes fail() record into `diagnostics`, or throw again when null.
+  void collect(std::vector<Diagnostic>* diagnostics) {
+    diagnostics_ = diagnostics;
+  }
+  [[nodiscard]] bool failed() const { return failed_; }
+  [[nodiscard]] size_t position() const { return position_; }
+  // Skips past the failed statement that started at token `start`: to its
+  // ';' at bracket depth zero, or to the end of input.
+  void synchronize(size_t start);
+
+  // Allocates a node from the arena, located at byte `offset`.
+  template <typename T, typename... Args>
+  std::shared_ptr<T> make(uint32_t offset, Args&&... args) {
+    auto node = arena_->make<T>(std::forward<Args>(args)...);
+    node->set_offset(offset);
+    return node;
+  }
+
+  [[nodiscard]] ast::AstArena& arena() const { return *arena_; }
+  [[nodiscard]] const std::shared_ptr<ast::AstArena>& shared_arena() const {
+    return arena_;
+  }
+
  private:
-  lexer::Lexer::Iterator current_location_;
-  lexer::Lexer::Iterator peek_location_;
-  lexer::Lexer::Iterator end_location_;
+  std::vector<lexer::Token> tokens_;
+  size_t position_ = 0;
+  std::shared_ptr<ast::AstArena> arena_;
+  std::vector<Diagnostic>* diagnostics_ = nullptr;
+  bool failed_ = false;
 };
 
 }  // namespace monkey::parser
@@ -0,0 +1,69 @@
+#ifndef MONKEY_VM_VM_H_
+#define MONKEY_VM_VM_H_
+
+#include <monkey/ast/ast.h>
+#include <monkey/compiler/bytecode.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace monkey::vm {
+
+// A function of a compiled module, with what it captured when it was made:
+// the counterpart of object::Function, with the same captures and frames.
+class Closure : public object::Object {
+ public:
+  Closure(std::shared_ptr<const compiler::Module> module, uint32_t function,
+          std::vector<std::shared_ptr<object::Object>> captures,
+          std::vector<std::shared_ptr<object::Env>> frames);
+
+  [[nodiscard]] object::ObjectType type() const override {
+    return object::ObjectType::kFunction;
+  }
+
+  [[nodiscard]] std::string to_string() const override;
+
+  // Closures are equal if they were made from the same function literal.
+  bool operator==(const Object& other) const override;
+  bool operator!=(const Object& other) const override;
+
+  [[nodiscard]] const std::shared_ptr<const compiler::Module>& module() const {
+    return module_;
+  }
+  [[nodiscard]] const compiler::CompiledFunction& function() const {
+    return *function_;
+  }
+  [[nodiscard]] const std::vector<std::shared_ptr<object::Object>>& captures()
+      const {
+    return captures_;
+  }
+  [[nodiscard]] const std::vector<std::shared_ptr<object::Env>>& frames()
+      const {
+    return frames_;
+  }
+
+ private:
+  std::shared_ptr<const compiler::Module> module_;
+  const compiler::CompiledFunction* function_;
+  std::vector<std::shared_ptr<object::Object>> captures_;
+  std::vector<std::shared_ptr<object::Env>> frames_;
+};
+
+// Compiles the program with compiler::compile() and runs it, with the same
+// semantics as eval::eval() on it: `env` holds the globals, and the result
+// is the value of the last statement, the value returned or the first
+// error. Null if the program has no statements.
+std::shared_ptr<object::Object> run(const ast::Program& program,
+                                    std::shared_ptr<object::Env>& env);
+
+std::shared_ptr<object::Object> run(
+    const std::shared_ptr<const compiler::Module>& module,
+    std::shared_ptr<object::Env>& env);
+
+}  // namespace monkey::vm
+
+#endif  // MONKEY_VM_VM_H_
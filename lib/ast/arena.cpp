@@ -0,0 +1,47 @@
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+
+#include <cstddef>
+#include <memory>
+#include <ranges>
+#include <utility>
+
+namespace monkey::ast {
+
+AstArena::~AstArena() {
+  for (auto* node : std::views::reverse(nodes_)) {
+    node->~Node();
+  }
+}
+
+void* AstArena::allocate_block(size_t size) {
+  // Nodes are a few dozen bytes, so a fresh block always has room and
+  // operator new[] already aligns it for any of them.
+  blocks_.push_back(std::make_unique_for_overwrite<std::byte[]>(kBlockSize));
+  auto* memory = blocks_.back().get();
+  cursor_ = memory + size;
+  limit_ = memory + kBlockSize;
+  return memory;
+}
+
+void AstArena::adopt(std::shared_ptr<const AstArena> other) {
+  adopted_.push_back(std::move(other));
+}
+
+size_t AstArena::node_count() const {
+  auto count = nodes_.size();
+  for (const auto& arena : adopted_) {
+    count += arena->node_count();
+  }
+  return count;
+}
+
+size_t AstArena::bytes_reserved() const {
+  auto bytes = blocks_.size() * kBlockSize;
+  for (const auto& arena : adopted_) {
+    bytes += arena->bytes_reserved();
+  }
+  return bytes;
+}
+
+}  // namespace monkey::ast
@@ -3,6 +3,7 @@
 #include <monkey/ast/stmt.h>
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -58,6 +59,22 @@ std::string to_string(const Node& node) { return node.to_string(); }
 Program::Program(std::vector<std::shared_ptr<Statement>> statements)
     : statements_(std::move(statements)) {}
 
+Program::Program(std::vector<std::shared_ptr<Statement>> statements,
+                 std::shared_ptr<const AstArena> arena)
+    : arena_(std::move(arena)), statements_(std::move(statements)) {}
+
+Program::Program(std::vector<std::shared_ptr<Statement>> statements,
+                 std::shared_ptr<const AstArena> arena,
+                 std::vector<uint32_t> offset_shifts)
+    : arena_(std::move(arena)),
+      statements_(std::move(statements)),
+      offset_shifts_(std::move(offset_shifts)) {
+  if (std::ranges::all_of(offset_shifts_,
+                          [](uint32_t shift) { return shift == 0; })) {
+    offset_shifts_.clear();
+  }
+}
+
 std::string Program::to_string() const {
   std::string statements;
   for (const auto& statement : statements_) {
@@ -0,0 +1,522 @@
+#include <fmt/core.h>
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/binary.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/lexer/token.h>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace monkey::ast {
+
+namespace {
+
+constexpr std::string_view kMagic = "MKC\n";
+
+void put_fixed(std::string& out, uint64_t value, size_t bytes) {
+  for (size_t i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void put_varint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void put_zigzag(std::string& out, int64_t value) {
+  put_varint(out, (static_cast<uint64_t>(value) << 1) ^
+                      static_cast<uint64_t>(value >> 63));
+}
+
+void put_type(std::string& out, NodeType type) {
+  out.push_back(static_cast<char>(type));
+}
+
+class Encoder {
+ public:
+  std::string encode(const Program& program, const SourceKey& key) {
+    program_ = &program;
+    put_varint(body_, program.statements().size());
+    for (size_t i = 0; i < program.statements().size(); ++i) {
+      statement_ = i;
+      put(program.statements()[i].get());
+    }
+
+    std::string out;
+    out.reserve(kMagic.size() + 20 + body_.size() + names_.size() * 8);
+    out += kMagic;
+    put_fixed(out, kBinaryVersion, 4);
+    put_fixed(out, key.hash, 8);
+    put_fixed(out, key.size, 8);
+    put_varint(out, names_.size());
+    for (const auto symbol : names_) {
+      put_varint(out, symbol.name().size());
+      out += symbol.name();
+    }
+    out += body_;
+    return out;
+  }
+
+ private:
+  // Offsets are stored as the difference from the previous node's, which in
+  // prefix order is small and usually positive.
+  void put_offset(const Node& node) {
+    const uint32_t offset = program_->offset(node, statement_);
+    put_zigzag(body_, int64_t{offset} - int64_t{previous_offset_});
+    previous_offset_ = offset;
+  }
+
+  void put_name(const Identifier& identifier) {
+    const auto [it, inserted] = indices_.try_emplace(
+        identifier.symbol(), static_cast<uint32_t>(names_.size()));
+    if (inserted) {
+      names_.push_back(identifier.symbol());
+    }
+    put_varint(body_, it->second);
+  }
+
+  void put_list(const auto& nodes) {
+    put_varint(body_, nodes.size());
+    for (const auto& node : nodes) {
+      put(node.get());
+    }
+  }
+
+  // Only an if-expression's alternative may be missing.
+  void put_optional(const Node* node) {
+    if (node == nullptr) {
+      body_.push_back(static_cast<char>(kNoNodeTag));
+      return;
+    }
+    put(node);
+  }
+
+  void put(const Node* node) {
+    if (node == nullptr) {
+      throw FormatError("missing node");
+    }
+    put_type(body_, node->type());
+    put_offset(*node);
+    switch (node->type()) {
+      case NodeType::kLetStatement: {
+        const auto& let = dynamic_cast<const LetStatement&>(*node);
+        put_offset(*let.name());
+        put_name(*let.name());
+        put(let.value().get());
+        break;
+      }
+      case NodeType::kReturnStatement:
+        put(dynamic_cast<const ReturnStatement&>(*node).return_value().get());
+        break;
+      case NodeType::kExpressionStatement:
+        put(dynamic_cast<const ExpressionStatement&>(*node).expression().get());
+        break;
+      case NodeType::kBlockStatement:
+        put_list(dynamic_cast<const BlockStatement&>(*node).statements());
+        break;
+      case NodeType::kIdentifier:
+        put_name(dynamic_cast<const Identifier&>(*node));
+        break;
+      case NodeType::kIntegerLiteral:
+        put_zigzag(body_, dynamic_cast<const IntegerLiteral&>(*node).value());
+        break;
+      case NodeType::kBooleanLiteral:
+        body_.push_back(
+            dynamic_cast<const BooleanLiteral&>(*node).value() ? 1 : 0);
+        break;
+      case NodeType::kStringLiteral: {
+        const auto& value = dynamic_cast<const StringLiteral&>(*node).value();
+        put_varint(body_, value.size());
+        body_ += value;
+        break;
+      }
+      case NodeType::kFunctionLiteral: {
+        const auto& function = dynamic_cast<const FunctionLiteral&>(*node);
+        put_varint(body_, function.parameters().size());
+        for (const auto& parameter : function.parameters()) {
+          put_offset(*parameter);
+          put_name(*parameter);
+        }
+        put(function.body().get());
+        break;
+      }
+      case NodeType::kArrayLiteral:
+        put_list(dynamic_cast<const ArrayLiteral&>(*node).elements());
+        break;
+      case NodeType::kHashLiteral: {
+        const auto& pairs = dynamic_cast<const HashLiteral&>(*node).pairs();
+        put_varint(body_, pairs.size());
+        for (const auto& [key, value] : pairs) {
+          put(key.get());
+          put(value.get());
+        }
+        break;
+      }
+      case NodeType::kPrefixExpression: {
+        const auto& prefix = dynamic_cast<const PrefixExpression&>(*node);
+        body_.push_back(static_cast<char>(prefix.op()));
+        put(prefix.right().get());
+        break;
+      }
+      case NodeType::kInfixExpression: {
+        const auto& infix = dynamic_cast<const InfixExpression&>(*node);
+        put(infix.left().get());
+        body_.push_back(static_cast<char>(infix.op()));
+        put(infix.right().get());
+        break;
+      }
+      case NodeType::kIfExpression: {
+        const auto& branch = dynamic_cast<const IfExpression&>(*node);
+        put(branch.condition().get());
+        put(branch.consequence().get());
+        put_optional(branch.alternative().get());
+        break;
+      }
+      case NodeType::kCallExpression: {
+        const auto& call = dynamic_cast<const CallExpression&>(*node);
+        put(call.function().get());
+        put_list(call.arguments());
+        break;
+      }
+      case NodeType::kIndexExpression: {
+        const auto& index = dynamic_cast<const IndexExpression&>(*node);
+        put(index.left().get());
+        put(index.index().get());
+        break;
+      }
+      case NodeType::kProgram:
+        throw FormatError("a program cannot be nested");
+    }
+  }
+
+  std::string body_;
+  uint32_t previous_offset_ = 0;
+  // The program and the top-level statement being encoded, so a moved
+  // statement decodes to where it is now.
+  const Program* program_ = nullptr;
+  size_t statement_ = 0;
+  std::vector<Symbol> names_;
+  std::unordered_map<Symbol, uint32_t> indices_;
+};
+
+class Decoder {
+ public:
+  explicit Decoder(std::string_view bytes) : bytes_(bytes) {}
+
+  std::shared_ptr<Program> decode(const SourceKey& key) {
+    if (take(kMagic.size()) != kMagic) {
+      throw FormatError("not a Monkey program cache");
+    }
+    if (const auto version = fixed(4); version != kBinaryVersion) {
+      throw FormatError(fmt::format("unsupported version {}", version));
+    }
+    const auto hash = fixed(8);
+    const auto size = fixed(8);
+    if (SourceKey{hash, size} != key) {
+      throw FormatError("encoded from a different source");
+    }
+
+    const auto name_count = count();
+    names_.reserve(name_count);
+    for (size_t i = 0; i < name_count; ++i) {
+      names_.push_back(Symbol::intern(take(count())));
+    }
+
+    const auto statement_count = count();
+    std::vector<std::shared_ptr<Statement>> statements;
+    statements.reserve(statement_count);
+    for (size_t i = 0; i < statement_count; ++i) {
+      statements.push_back(statement());
+    }
+    if (position_ != bytes_.size()) {
+      throw FormatError("trailing bytes");
+    }
+    return std::make_shared<Program>(std::move(statements), std::move(arena_));
+  }
+
+ private:
+  std::string_view take(size_t size) {
+    if (size > bytes_.size() - position_) {
+      throw FormatError("truncated");
+    }
+    const auto bytes = bytes_.substr(position_, size);
+    position_ += size;
+    return bytes;
+  }
+
+  uint8_t byte() {
+    if (position_ == bytes_.size()) {
+      throw FormatError("truncated");
+    }
+    return static_cast<uint8_t>(bytes_[position_++]);
+  }
+
+  uint64_t fixed(size_t size) {
+    const auto bytes = take(size);
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) {
+      value |= uint64_t{static_cast<uint8_t>(bytes[i])} << (8 * i);
+    }
+    return value;
+  }
+
+  uint64_t varint() {
+    // Most counts and indices fit in one byte.
+    if (position_ < bytes_.size() &&
+        static_cast<uint8_t>(bytes_[position_]) < 0x80) {
+      return static_cast<uint8_t>(bytes_[position_++]);
+    }
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      const auto next = byte();
+      value |= uint64_t{next & 0x7fU} << shift;
+      if ((next & 0x80) == 0) {
+        return value;
+      }
+    }
+    throw FormatError("malformed integer");
+  }
+
+  int64_t zigzag() {
+    const auto value = varint();
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+  }
+
+  uint32_t offset() {
+    const auto value = int64_t{previous_offset_} + zigzag();
+    if (value < 0 || value > int64_t{lexer::kMaxOffset}) {
+      throw FormatError("offset out of range");
+    }
+    previous_offset_ = static_cast<uint32_t>(value);
+    return previous_offset_;
+  }
+
+  template <typename T>
+  static std::shared_ptr<T> located(std::shared_ptr<T> node, uint32_t at) {
+    node->set_offset(at);
+    return node;
+  }
+
+  // An identifier that is a field of its parent rather than an expression.
+  std::shared_ptr<Identifier> identifier() {
+    const auto at = offset();
+    return located(arena_->make<Identifier>(name()), at);
+  }
+
+  // A length or element count. Every element takes at least a byte, so a
+  // count past the end of the input is malformed, which keeps reserve() sane.
+  size_t count() {
+    const auto value = varint();
+    if (value > bytes_.size() - position_) {
+      throw FormatError("truncated");
+    }
+    return static_cast<size_t>(value);
+  }
+
+  Symbol name() {
+    const auto index = varint();
+    if (index >= names_.size()) {
+      throw FormatError("name index out of range");
+    }
+    return names_[index];
+  }
+
+  lexer::TokenType op() {
+    const auto value = byte();
+    if (value > static_cast<uint8_t>(lexer::TokenType::kReturn)) {
+      throw FormatError("invalid operator");
+    }
+    return static_cast<lexer::TokenType>(value);
+  }
+
+  std::shared_ptr<Statement> statement() {
+    const auto tag = byte();
+    const auto at = offset();
+    return located(statement(tag), at);
+  }
+
+  std::shared_ptr<Statement> statement(uint8_t tag) {
+    switch (tag) {
+      case static_cast<uint8_t>(NodeType::kLetStatement): {
+        auto name = identifier();
+        return arena_->make<LetStatement>(std::move(name), expression());
+      }
+      case static_cast<uint8_t>(NodeType::kReturnStatement):
+        return arena_->make<ReturnStatement>(expression());
+      case static_cast<uint8_t>(NodeType::kExpressionStatement):
+        return arena_->make<ExpressionStatement>(expression());
+      case static_cast<uint8_t>(NodeType::kBlockStatement):
+        return block_body();
+      default:
+        throw FormatError(fmt::format("expected a statement, got tag {}", tag));
+    }
+  }
+
+  std::shared_ptr<BlockStatement> block(bool optional = false) {
+    switch (const auto tag = byte(); tag) {
+      case kNoNodeTag:
+        if (!optional) {
+          throw FormatError("missing block");
+        }
+        return nullptr;
+      case static_cast<uint8_t>(NodeType::kBlockStatement): {
+        const auto at = offset();
+        return located(block_body(), at);
+      }
+      default:
+        throw FormatError(fmt::format("expected a block, got tag {}", tag));
+    }
+  }
+
+  std::shared_ptr<BlockStatement> block_body() {
+    const auto size = count();
+    std::vector<std::shared_ptr<Statement>> statements;
+    statements.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      statements.push_back(statement());
+    }
+    return arena_->make<BlockStatement>(std::move(statements));
+  }
+
+  std::vector<std::shared_ptr<Expression>> expressions() {
+    const auto size = count();
+    std::vector<std::shared_ptr<Expression>> list;
+    list.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+      list.push_back(expression());
+    }
+    return list;
+  }
+
+  std::shared_ptr<Expression> expression() {
+    const auto tag = byte();
+    const auto at = offset();
+    return located(expression(tag), at);
+  }
+
+  std::shared_ptr<Expression> expression(uint8_t tag) {
+    switch (tag) {
+      case static_cast<uint8_t>(NodeType::kIdentifier):
+        return arena_->make<Identifier>(name());
+      case static_cast<uint8_t>(NodeType::kIntegerLiteral):
+        return arena_->make<IntegerLiteral>(zigzag());
+      case static_cast<uint8_t>(NodeType::kBooleanLiteral):
+        return arena_->make<BooleanLiteral>(byte() != 0);
+      case static_cast<uint8_t>(NodeType::kStringLiteral):
+        return arena_->make<StringLiteral>(std::string(take(count())));
+      case static_cast<uint8_t>(NodeType::kFunctionLiteral): {
+        const auto size = count();
+        std::vector<std::shared_ptr<Identifier>> parameters;
+        parameters.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+          parameters.push_back(identifier());
+        }
+        auto body = block();
+        return arena_->make<FunctionLiteral>(std::move(parameters),
+                                             std::move(body));
+      }
+      case static_cast<uint8_t>(NodeType::kArrayLiteral):
+        return arena_->make<ArrayLiteral>(expressions());
+      case static_cast<uint8_t>(NodeType::kHashLiteral): {
+        const auto size = count();
+        std::unordered_map<std::shared_ptr<Expression>,
+                           std::shared_ptr<Expression>>
+            pairs;
+        pairs.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+          auto key = expression();
+          pairs.emplace(std::move(key), expression());
+        }
+        return arena_->make<HashLiteral>(std::move(pairs));
+      }
+      case static_cast<uint8_t>(NodeType::kPrefixExpression): {
+        const auto prefix_op = op();
+        return arena_->make<PrefixExpression>(prefix_op, expression());
+      }
+      case static_cast<uint8_t>(NodeType::kInfixExpression): {
+        auto left = expression();
+        const auto infix_op = op();
+        return arena_->make<InfixExpression>(std::move(left), infix_op,
+                                             expression());
+      }
+      case static_cast<uint8_t>(NodeType::kIfExpression): {
+        auto condition = expression();
+        auto consequence = block();
+        auto alternative = block(true);
+        return arena_->make<IfExpression>(std::move(condition),
+                                          std::move(consequence),
+                                          std::move(alternative));
+      }
+      case static_cast<uint8_t>(NodeType::kCallExpression): {
+        auto function = expression();
+        return arena_->make<CallExpression>(std::move(function),
+                                            expressions());
+      }
+      case static_cast<uint8_t>(NodeType::kIndexExpression): {
+        auto left = expression();
+        return arena_->make<IndexExpression>(std::move(left), expression());
+      }
+      default:
+        throw FormatError(
+            fmt::format("expected an expression, got tag {}", tag));
+    }
+  }
+
+  std::string_view bytes_;
+  size_t position_ = 0;
+  uint32_t previous_offset_ = 0;
+  std::vector<Symbol> names_;
+  std::shared_ptr<AstArena> arena_ = std::make_shared<AstArena>();
+};
+
+}  // namespace
+
+FormatError::FormatError(std::string message)
+    : message_(fmt::format("FormatError: {}", std::move(message))) {}
+
+// FxHash over 8-byte words, finished with the splitmix64 mixer so that every
+// input bit reaches every output bit.
+SourceKey source_key(std::string_view text) {
+  constexpr uint64_t kMultiplier = 0x517cc1b727220a95;
+  uint64_t hash = text.size();
+  size_t i = 0;
+  for (; i + 8 <= text.size(); i += 8) {
+    uint64_t word = 0;
+    std::memcpy(&word, text.data() + i, 8);
+    hash = (std::rotl(hash, 5) ^ word) * kMultiplier;
+  }
+  if (i < text.size()) {
+    uint64_t word = 0;
+    std::memcpy(&word, text.data() + i, text.size() - i);
+    hash = (std::rotl(hash, 5) ^ word) * kMultiplier;
+  }
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+  return {hash ^ (hash >> 31), text.size()};
+}
+
+std::string encode(const Program& program, const SourceKey& key) {
+  return Encoder().encode(program, key);
+}
+
+std::shared_ptr<Program> decode(std::string_view bytes, const SourceKey& key) {
+  return Decoder(bytes).decode(key);
+}
+
+}  // namespace monkey::ast
@@ -2,6 +2,7 @@
 #include <monkey/ast/ast.h>
 #include <monkey/ast/expr.h>
 #include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
 #include <monkey/lexer/token.h>
 
 #include <algorithm>
@@ -9,22 +10,31 @@
 #include <memory>
 #include <ranges>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace monkey::ast {
 
-Identifier::Identifier(std::string name) : name_(std::move(name)) {}
+Identifier::Identifier(Symbol symbol) : symbol_(symbol) {}
 
-std::string Identifier::to_string() const { return fmt::format("{}", name_); }
+Identifier::Identifier(std::string_view name)
+    : symbol_(Symbol::intern(name)) {}
+
+void Identifier::set_address(Address address, std::vector<Address> fallbacks) {
+  address_ = address;
+  fallbacks_ = std::move(fallbacks);
+}
+
+std::string Identifier::to_string() const { return name(); }
 
 bool Identifier::operator==(const Node& other) const {
   if (other.type() != NodeType::kIdentifier) {
     return false;
   }
   const auto& other_identifier = dynamic_cast<const Identifier&>(other);
-  return name_ == other_identifier.name_;
+  return symbol_ == other_identifier.symbol_;
 }
 
 bool Identifier::operator!=(const Node& other) const {
@@ -74,6 +84,12 @@ FunctionLiteral::FunctionLiteral(
     std::shared_ptr<BlockStatement> body)
     : parameters_(std::move(parameters)), body_(std::move(body)) {}
 
+void FunctionLiteral::set_captures(std::vector<Capture> captures,
+                                   std::vector<Capture> captured_frames) {
+  captures_ = std::move(captures);
+  captured_frames_ = std::move(captured_frames);
+}
+
 std::string FunctionLiteral::to_string() const {
   std::string parameters;
   for (const auto& parameter : parameters_) {
@@ -244,6 +260,38 @@ bool InfixExpression::operator!=(const Node& other) const {
   return !(*this == other);
 }
 
+std::string to_string(InfixExpression::Specialization specialization) {
+  switch (specialization) {
+    case InfixExpression::Specialization::kUninitialized:
+      return "uninitialized";
+    case InfixExpression::Specialization::kIntegerAdd:
+      return "integer +";
+    case InfixExpression::Specialization::kIntegerSubtract:
+      return "integer -";
+    case InfixExpression::Specialization::kIntegerMultiply:
+      return "integer *";
+    case InfixExpression::Specialization::kIntegerDivide:
+      return "integer /";
+    case InfixExpression::Specialization::kIntegerLessThan:
+      return "integer <";
+    case InfixExpression::Specialization::kIntegerGreaterThan:
+      return "integer >";
+    case InfixExpression::Specialization::kIntegerEqual:
+      return "integer ==";
+    case InfixExpression::Specialization::kIntegerNotEqual:
+      return "integer !=";
+    case InfixExpression::Specialization::kBooleanEqual:
+      return "boolean ==";
+    case InfixExpression::Specialization::kBooleanNotEqual:
+      return "boolean !=";
+    case InfixExpression::Specialization::kStringConcat:
+      return "string +";
+    case InfixExpression::Specialization::kGeneric:
+      return "generic";
+  }
+  return "";
+}
+
 IndexExpression::IndexExpression(std::shared_ptr<Expression> left,
                                  std::shared_ptr<Expression> index)
     : left_(std::move(left)), index_(std::move(index)) {}
@@ -289,7 +337,11 @@ bool IfExpression::operator==(const Node& other) const {
   const auto& other_if_expression = dynamic_cast<const IfExpression&>(other);
   return *condition_ == *other_if_expression.condition_ &&
          consequence_->operator==(*other_if_expression.consequence_) &&
-         alternative_->operator==(*other_if_expression.alternative_);
+         (alternative_ == nullptr
+              ? other_if_expression.alternative_ == nullptr
+              : other_if_expression.alternative_ != nullptr &&
+                    alternative_->operator==(
+                        *other_if_expression.alternative_));
 }
 
 bool IfExpression::operator!=(const Node& other) const {
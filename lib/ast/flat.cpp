@@ -0,0 +1,316 @@
+#include <fmt/core.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/flat.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/lexer/token.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace monkey::ast {
+
+class FlatBuilder {
+ public:
+  std::shared_ptr<const FlatProgram> build(const Program& program) {
+    source_ = &program;
+    std::vector<NodeIndex> indices;
+    indices.reserve(program.statements().size());
+    for (size_t i = 0; i < program.statements().size(); ++i) {
+      statement_ = i;
+      indices.push_back(add(*program.statements()[i]));
+    }
+    const auto [first, count] = append_children(indices);
+    program_->statements_first_ = first;
+    program_->statements_count_ = count;
+    return std::move(program_);
+  }
+
+ private:
+  // Offsets are kept in a parallel array rather than in FlatNode, which stays
+  // 16 bytes. Every node is pushed last, after its children, so the offset
+  // lines up with the index add_fields returns.
+  NodeIndex add(const Node& node) {
+    const auto index = add_fields(node);
+    if (index != kNoNode) {
+      program_->offsets_.push_back(source_->offset(node, statement_));
+    }
+    return index;
+  }
+
+  NodeIndex add_fields(const Node& node) {
+    switch (node.type()) {
+      case NodeType::kLetStatement: {
+        const auto& let = dynamic_cast<const LetStatement&>(node);
+        return push({.type = NodeType::kLetStatement,
+                     .a = intern(let.name()->symbol()),
+                     .b = add(*let.value())});
+      }
+      case NodeType::kReturnStatement: {
+        const auto& ret = dynamic_cast<const ReturnStatement&>(node);
+        return push({.type = NodeType::kReturnStatement,
+                     .a = add(*ret.return_value())});
+      }
+      case NodeType::kExpressionStatement: {
+        const auto& statement = dynamic_cast<const ExpressionStatement&>(node);
+        return push({.type = NodeType::kExpressionStatement,
+                     .a = add(*statement.expression())});
+      }
+      case NodeType::kBlockStatement: {
+        const auto& block = dynamic_cast<const BlockStatement&>(node);
+        const auto [first, count] = add_range(block.statements());
+        return push({.type = NodeType::kBlockStatement, .a = first, .b = count});
+      }
+      case NodeType::kIdentifier: {
+        const auto& identifier = dynamic_cast<const Identifier&>(node);
+        return push({.type = NodeType::kIdentifier,
+                     .a = intern(identifier.symbol())});
+      }
+      case NodeType::kIntegerLiteral: {
+        const auto& literal = dynamic_cast<const IntegerLiteral&>(node);
+        program_->integers_.push_back(literal.value());
+        return push({.type = NodeType::kIntegerLiteral,
+                     .a = to_index(program_->integers_.size() - 1)});
+      }
+      case NodeType::kBooleanLiteral: {
+        const auto& literal = dynamic_cast<const BooleanLiteral&>(node);
+        return push({.type = NodeType::kBooleanLiteral,
+                     .a = literal.value() ? 1U : 0U});
+      }
+      case NodeType::kStringLiteral: {
+        const auto& literal = dynamic_cast<const StringLiteral&>(node);
+        program_->strings_.push_back(literal.value());
+        return push({.type = NodeType::kStringLiteral,
+                     .a = to_index(program_->strings_.size() - 1)});
+      }
+      case NodeType::kArrayLiteral: {
+        const auto& literal = dynamic_cast<const ArrayLiteral&>(node);
+        const auto [first, count] = add_range(literal.elements());
+        return push({.type = NodeType::kArrayLiteral, .a = first, .b = count});
+      }
+      case NodeType::kHashLiteral: {
+        const auto& literal = dynamic_cast<const HashLiteral&>(node);
+        std::vector<NodeIndex> entries;
+        entries.reserve(literal.pairs().size() * 2);
+        for (const auto& [key, value] : literal.pairs()) {
+          entries.push_back(add(*key));
+          entries.push_back(add(*value));
+        }
+        const auto [first, count] = append_children(entries);
+        return push({.type = NodeType::kHashLiteral, .a = first, .b = count});
+      }
+      case NodeType::kFunctionLiteral: {
+        const auto& literal = dynamic_cast<const FunctionLiteral&>(node);
+        const auto [first, count] = add_range(literal.parameters());
+        const auto body = add(*literal.body());
+        return push({.type = NodeType::kFunctionLiteral,
+                     .a = first,
+                     .b = count,
+                     .c = body});
+      }
+      case NodeType::kPrefixExpression: {
+        const auto& expression = dynamic_cast<const PrefixExpression&>(node);
+        return push({.type = NodeType::kPrefixExpression,
+                     .op = expression.op(),
+                     .a = add(*expression.right())});
+      }
+      case NodeType::kInfixExpression: {
+        const auto& expression = dynamic_cast<const InfixExpression&>(node);
+        const auto left = add(*expression.left());
+        const auto right = add(*expression.right());
+        return push({.type = NodeType::kInfixExpression,
+                     .op = expression.op(),
+                     .a = left,
+                     .b = right});
+      }
+      case NodeType::kIfExpression: {
+        const auto& expression = dynamic_cast<const IfExpression&>(node);
+        const auto condition = add(*expression.condition());
+        const auto consequence = add(*expression.consequence());
+        const auto alternative = expression.alternative()
+                                     ? add(*expression.alternative())
+                                     : kNoNode;
+        return push({.type = NodeType::kIfExpression,
+                     .a = condition,
+                     .b = consequence,
+                     .c = alternative});
+      }
+      case NodeType::kCallExpression: {
+        const auto& expression = dynamic_cast<const CallExpression&>(node);
+        const auto function = add(*expression.function());
+        const auto [first, count] = add_range(expression.arguments());
+        return push({.type = NodeType::kCallExpression,
+                     .a = function,
+                     .b = first,
+                     .c = count});
+      }
+      case NodeType::kIndexExpression: {
+        const auto& expression = dynamic_cast<const IndexExpression&>(node);
+        const auto left = add(*expression.left());
+        const auto index = add(*expression.index());
+        return push(
+            {.type = NodeType::kIndexExpression, .a = left, .b = index});
+      }
+      default:
+        return kNoNode;
+    }
+  }
+
+  // Children are flattened first so that each range is contiguous.
+  template <typename T>
+  std::pair<NodeIndex, NodeIndex> add_range(
+      const std::vector<std::shared_ptr<T>>& nodes) {
+    std::vector<NodeIndex> indices;
+    indices.reserve(nodes.size());
+    for (const auto& node : nodes) {
+      indices.push_back(add(*node));
+    }
+    return append_children(indices);
+  }
+
+  std::pair<NodeIndex, NodeIndex> append_children(
+      const std::vector<NodeIndex>& indices) {
+    const auto first = to_index(program_->children_.size());
+    program_->children_.insert(program_->children_.end(), indices.begin(),
+                               indices.end());
+    return {first, to_index(indices.size())};
+  }
+
+  NodeIndex push(const FlatNode& node) {
+    program_->nodes_.push_back(node);
+    return to_index(program_->nodes_.size() - 1);
+  }
+
+  NodeIndex intern(Symbol name) {
+    const auto [it, inserted] =
+        name_indices_.try_emplace(name, to_index(program_->names_.size()));
+    if (inserted) {
+      program_->names_.push_back(name);
+    }
+    return it->second;
+  }
+
+  static NodeIndex to_index(size_t size) { return static_cast<NodeIndex>(size); }
+
+  std::shared_ptr<FlatProgram> program_ = std::make_shared<FlatProgram>();
+  std::unordered_map<Symbol, NodeIndex> name_indices_;
+  // The program and the top-level statement being flattened.
+  const Program* source_ = nullptr;
+  size_t statement_ = 0;
+};
+
+std::shared_ptr<const FlatProgram> flatten(const Program& program) {
+  return FlatBuilder().build(program);
+}
+
+size_t FlatProgram::memory_usage() const {
+  auto usage = sizeof(FlatProgram) + nodes_.capacity() * sizeof(FlatNode) +
+               children_.capacity() * sizeof(NodeIndex) +
+               names_.capacity() * sizeof(Symbol) +
+               integers_.capacity() * sizeof(int64_t) +
+               strings_.capacity() * sizeof(std::string) +
+               offsets_.capacity() * sizeof(uint32_t);
+  // Counts string capacity even where it is stored inline, so this slightly
+  // overestimates.
+  for (const auto& string : strings_) {
+    usage += string.capacity();
+  }
+  return usage;
+}
+
+std::string FlatProgram::to_string() const {
+  std::string statements;
+  for (const auto statement : this->statements()) {
+    if (statements.empty()) {
+      statements = to_string(statement);
+    } else {
+      statements = fmt::format("{}\n{}", statements, to_string(statement));
+    }
+  }
+  return statements;
+}
+
+std::string FlatProgram::to_string(NodeIndex index) const {
+  const auto& flat = node(index);
+  const auto join = [this](std::span<const NodeIndex> nodes) {
+    std::string joined;
+    for (const auto child : nodes) {
+      if (joined.empty()) {
+        joined = to_string(child);
+      } else {
+        joined = fmt::format("{}, {}", joined, to_string(child));
+      }
+    }
+    return joined;
+  };
+  switch (flat.type) {
+    case NodeType::kLetStatement:
+      return fmt::format("let {} = {};", name(flat.a), to_string(flat.b));
+    case NodeType::kReturnStatement:
+      return fmt::format("return {};", to_string(flat.a));
+    case NodeType::kExpressionStatement:
+      return to_string(flat.a);
+    case NodeType::kBlockStatement: {
+      std::string statements;
+      for (const auto statement : children(flat.a, flat.b)) {
+        statements = fmt::format("{}\n{}", statements, to_string(statement));
+      }
+      return statements;
+    }
+    case NodeType::kIdentifier:
+      return name(flat.a);
+    case NodeType::kIntegerLiteral:
+      return fmt::format("{}", integer(flat.a));
+    case NodeType::kBooleanLiteral:
+      return fmt::format("{}", flat.a != 0);
+    case NodeType::kStringLiteral:
+      return string(flat.a);
+    case NodeType::kArrayLiteral:
+      return fmt::format("[{}]", join(children(flat.a, flat.b)));
+    case NodeType::kHashLiteral: {
+      std::string pairs;
+      const auto entries = children(flat.a, flat.b);
+      for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+        const auto pair = fmt::format("{}: {}", to_string(entries[i]),
+                                      to_string(entries[i + 1]));
+        pairs = pairs.empty() ? pair : fmt::format("{}, {}", pairs, pair);
+      }
+      return fmt::format("{{{}}}", pairs);
+    }
+    case NodeType::kFunctionLiteral: {
+      std::string parameters;
+      for (const auto parameter : children(flat.a, flat.b)) {
+        parameters = fmt::format("{}, {}", parameters, to_string(parameter));
+      }
+      return fmt::format("fn({}) {{{}}}", parameters, to_string(flat.c));
+    }
+    case NodeType::kPrefixExpression:
+      return fmt::format("({}{})", lexer::to_operator(flat.op),
+                         to_string(flat.a));
+    case NodeType::kInfixExpression:
+      return fmt::format("({} {} {})", to_string(flat.a),
+                         lexer::to_operator(flat.op), to_string(flat.b));
+    case NodeType::kIfExpression:
+      if (flat.c != kNoNode) {
+        return fmt::format("if ({}) {{{}}} else {{{}}}", to_string(flat.a),
+                           to_string(flat.b), to_string(flat.c));
+      }
+      return fmt::format("if ({}) {{{}}}", to_string(flat.a),
+                         to_string(flat.b));
+    case NodeType::kCallExpression:
+      return fmt::format("{}({})", to_string(flat.a),
+                         join(children(flat.b, flat.c)));
+    case NodeType::kIndexExpression:
+      return fmt::format("({}[{}])", to_string(flat.a), to_string(flat.b));
+    default:
+      return "";
+  }
+}
+
+}  // namespace monkey::ast
@@ -0,0 +1,430 @@
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/resolver.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/lexer/token.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace monkey::ast {
+
+namespace {
+
+// A name declared in a scope. Every let of the name in the scope shares the
+// slot, just as it would overwrite the same entry of a map.
+struct Binding {
+  Symbol name;
+  uint32_t slot = 0;
+  // Whether a let of the name has been passed, or it is a parameter.
+  bool declared = false;
+  // Lets of the name in the scope not passed yet, which would change it.
+  uint32_t pending = 0;
+  // The type of the value of the last let passed, which is what a reference
+  // from the same frame finds. Parameters could be anything.
+  StaticType type = StaticType::kUnknown;
+};
+
+// A function body or block. Blocks share the frame of the function they are
+// in, with slots of their own, since each runs at most once per call.
+struct Scope {
+  Scope* outer = nullptr;
+  // The frame the scope's slots are in; frames nest one level per function.
+  uint32_t level = 0;
+  std::vector<Binding> bindings;
+
+  Binding* find(Symbol name) {
+    for (auto& binding : bindings) {
+      if (binding.name == name) {
+        return &binding;
+      }
+    }
+    return nullptr;
+  }
+};
+
+// The captures of the function whose frame is at some level, deduplicated
+// by what they capture: the slot of an outer frame, or the frame itself.
+struct Frame {
+  std::vector<Capture> captures;
+  std::vector<std::pair<uint32_t, uint32_t>> captured_slots;
+  std::vector<Capture> captured_frames;
+  std::vector<uint32_t> captured_levels;
+  // Whether a closure made in the frame keeps the frame itself.
+  bool escapes = false;
+};
+
+class Resolver {
+ public:
+  // At the top level, where nothing carries over from one statement to
+  // the next.
+  void resolve_top_level(Statement& node) { resolve(node); }
+
+ private:
+  void resolve(Statement& node) {
+    switch (node.type()) {
+      case NodeType::kLetStatement: {
+        auto& let = dynamic_cast<LetStatement&>(node);
+        const auto type = resolve(*let.value());
+        if (scope_ == nullptr) {
+          let.name()->set_address({});
+          return;
+        }
+        auto* binding = scope_->find(let.name()->symbol());
+        binding->declared = true;
+        --binding->pending;
+        binding->type = type;
+        let.name()->set_address(
+            {.kind = Address::Kind::kLocal, .index = binding->slot});
+        return;
+      }
+      case NodeType::kReturnStatement:
+        resolve(*dynamic_cast<ReturnStatement&>(node).return_value());
+        return;
+      case NodeType::kExpressionStatement:
+        resolve(*dynamic_cast<ExpressionStatement&>(node).expression());
+        return;
+      case NodeType::kBlockStatement:
+        block(dynamic_cast<BlockStatement&>(node));
+        return;
+      default:
+        return;
+    }
+  }
+
+  StaticType resolve(Expression& node) {
+    const auto type = infer(node);
+    node.set_static_type(type);
+    return type;
+  }
+
+  // Only integers pass the arithmetic and ordering operators, and `+` is
+  // proven an integer only when both operands are, since it joins strings
+  // too. Equality and negation yield a boolean whatever their operands.
+  StaticType infer(Expression& node) {
+    switch (node.type()) {
+      case NodeType::kIdentifier:
+        return reference(dynamic_cast<Identifier&>(node));
+      case NodeType::kIntegerLiteral:
+        return StaticType::kInteger;
+      case NodeType::kBooleanLiteral:
+        return StaticType::kBoolean;
+      case NodeType::kFunctionLiteral:
+        function(dynamic_cast<FunctionLiteral&>(node));
+        return StaticType::kUnknown;
+      case NodeType::kArrayLiteral:
+        for (const auto& element :
+             dynamic_cast<ArrayLiteral&>(node).elements()) {
+          resolve(*element);
+        }
+        return StaticType::kUnknown;
+      case NodeType::kHashLiteral:
+        for (const auto& [key, value] :
+             dynamic_cast<HashLiteral&>(node).pairs()) {
+          resolve(*key);
+          resolve(*value);
+        }
+        return StaticType::kUnknown;
+      case NodeType::kPrefixExpression: {
+        auto& prefix = dynamic_cast<PrefixExpression&>(node);
+        resolve(*prefix.right());
+        switch (prefix.op()) {
+          case lexer::TokenType::kBang:
+            return StaticType::kBoolean;
+          case lexer::TokenType::kMinus:
+            return StaticType::kInteger;
+          default:
+            return StaticType::kUnknown;
+        }
+      }
+      case NodeType::kInfixExpression: {
+        auto& infix = dynamic_cast<InfixExpression&>(node);
+        const auto left = resolve(*infix.left());
+        const auto right = resolve(*infix.right());
+        switch (infix.op()) {
+          case lexer::TokenType::kPlus:
+            return left == StaticType::kInteger && right == StaticType::kInteger
+                       ? StaticType::kInteger
+                       : StaticType::kUnknown;
+          case lexer::TokenType::kMinus:
+          case lexer::TokenType::kAsterisk:
+          case lexer::TokenType::kSlash:
+            return StaticType::kInteger;
+          case lexer::TokenType::kLessThan:
+          case lexer::TokenType::kGreaterThan:
+          case lexer::TokenType::kEqual:
+          case lexer::TokenType::kNotEqual:
+            return StaticType::kBoolean;
+          default:
+            return StaticType::kUnknown;
+        }
+      }
+      case NodeType::kIfExpression: {
+        auto& branch = dynamic_cast<IfExpression&>(node);
+        resolve(*branch.condition());
+        block(*branch.consequence());
+        if (branch.alternative()) {
+          block(*branch.alternative());
+        }
+        return StaticType::kUnknown;
+      }
+      case NodeType::kCallExpression: {
+        auto& call = dynamic_cast<CallExpression&>(node);
+        resolve(*call.function());
+        for (const auto& argument : call.arguments()) {
+          resolve(*argument);
+        }
+        return StaticType::kUnknown;
+      }
+      case NodeType::kIndexExpression: {
+        auto& index = dynamic_cast<IndexExpression&>(node);
+        resolve(*index.left());
+        resolve(*index.index());
+        return StaticType::kUnknown;
+      }
+      default:
+        return StaticType::kUnknown;
+    }
+  }
+
+  // Within the frame being resolved, a binding is found if its let has been
+  // passed and skipped otherwise. A closure may run at any later point, so
+  // it copies the value of an outer binding only if no let can change it
+  // any more. Otherwise it keeps the binding's frame, and if the let has not
+  // been passed yet the binding is only a candidate, checked at run time
+  // before the next one out. Only a slot of the frame or a copied value has
+  // the type of its last let; a frame captured whole could still change.
+  StaticType reference(Identifier& node) {
+    auto type = StaticType::kUnknown;
+    candidates_.clear();
+    for (auto* scope = scope_; scope != nullptr; scope = scope->outer) {
+      const auto* binding = scope->find(node.symbol());
+      if (binding == nullptr) {
+        continue;
+      }
+      if (scope->level == level_) {
+        if (binding->declared) {
+          candidates_.push_back(
+              {.kind = Address::Kind::kLocal, .index = binding->slot});
+          type = binding->type;
+          break;
+        }
+        continue;
+      }
+      if (binding->declared && binding->pending == 0) {
+        candidates_.push_back(
+            {.kind = Address::Kind::kCapture,
+             .index = capture_slot(level_, scope->level, binding->slot)});
+        type = binding->type;
+        break;
+      }
+      candidates_.push_back({.kind = Address::Kind::kFrame,
+                             .index = capture_frame(level_, scope->level),
+                             .slot = binding->slot});
+      if (binding->declared) {
+        break;
+      }
+    }
+    if (candidates_.empty()) {
+      node.set_address({});
+      return type;
+    }
+    node.set_address(candidates_.front(), std::vector<Address>(
+                                              candidates_.begin() + 1,
+                                              candidates_.end()));
+    return type;
+  }
+
+  // Index of the capture, by the function at `level`, of a slot of the
+  // frame at `outer`. Functions in between capture it too, to pass it on.
+  uint32_t capture_slot(uint32_t level, uint32_t outer, uint32_t slot) {
+    auto& frame = frames_[level];
+    const auto key = std::pair(outer, slot);
+    if (const auto it = std::ranges::find(frame.captured_slots, key);
+        it != frame.captured_slots.end()) {
+      return static_cast<uint32_t>(it - frame.captured_slots.begin());
+    }
+    const auto capture =
+        level - 1 == outer
+            ? Capture{.source = Capture::Source::kSlot, .index = slot}
+            : Capture{.source = Capture::Source::kCapture,
+                      .index = capture_slot(level - 1, outer, slot)};
+    frame.captures.push_back(capture);
+    frame.captured_slots.push_back(key);
+    return static_cast<uint32_t>(frame.captures.size() - 1);
+  }
+
+  uint32_t capture_frame(uint32_t level, uint32_t outer) {
+    auto& frame = frames_[level];
+    if (const auto it = std::ranges::find(frame.captured_levels, outer);
+        it != frame.captured_levels.end()) {
+      return static_cast<uint32_t>(it - frame.captured_levels.begin());
+    }
+    if (level - 1 == outer) {
+      frames_[outer].escapes = true;
+    }
+    const auto capture =
+        level - 1 == outer
+            ? Capture{.source = Capture::Source::kFrame, .index = 0}
+            : Capture{.source = Capture::Source::kCapturedFrame,
+                      .index = capture_frame(level - 1, outer)};
+    frame.captured_frames.push_back(capture);
+    frame.captured_levels.push_back(outer);
+    return static_cast<uint32_t>(frame.captured_frames.size() - 1);
+  }
+
+  // A top-level block opens a frame of its own; nested ones extend the
+  // frame they are in.
+  void block(BlockStatement& node) {
+    const auto top_level = scope_ == nullptr;
+    uint32_t size = 0;
+    auto* const outer_size = frame_size_;
+    if (top_level) {
+      frame_size_ = &size;
+      enter();
+    }
+    auto scope = Scope{.outer = scope_, .level = level_, .bindings = {}};
+    body(scope, node);
+    if (top_level) {
+      node.set_frame_escapes(frames_[level_].escapes);
+      leave();
+      frame_size_ = outer_size;
+    }
+    node.set_frame_size(size);
+  }
+
+  void function(FunctionLiteral& node) {
+    uint32_t size = 0;
+    auto* const outer_size = frame_size_;
+    frame_size_ = &size;
+    enter();
+    // The body shares the parameters' scope: a let there would shadow a
+    // parameter for the rest of the call, so it may as well overwrite it.
+    auto scope = Scope{.outer = scope_, .level = level_, .bindings = {}};
+    for (const auto& parameter : node.parameters()) {
+      if (auto* binding = scope.find(parameter->symbol())) {
+        binding->slot = size;
+      } else {
+        scope.bindings.push_back(
+            {.name = parameter->symbol(), .slot = size, .declared = true});
+      }
+      parameter->set_address(
+          {.kind = Address::Kind::kLocal, .index = size++});
+    }
+    body(scope, *node.body());
+    tail_calls(*node.body(), true);
+    node.body()->set_frame_size(0);
+    auto& frame = frames_[level_];
+    node.set_frame_escapes(frame.escapes);
+    node.set_captures(std::move(frame.captures),
+                      std::move(frame.captured_frames));
+    leave();
+    frame_size_ = outer_size;
+    node.set_frame_size(size);
+  }
+
+  // Marks the calls in tail position among statements the body runs, see
+  // CallExpression::tail(). A return leaves the function wherever such a
+  // statement is, while anything else is only returned if it is last.
+  void tail_calls(const BlockStatement& node, bool tail) {
+    const auto& statements = node.statements();
+    for (size_t i = 0; i < statements.size(); ++i) {
+      const auto last = tail && i + 1 == statements.size();
+      switch (statements[i]->type()) {
+        case NodeType::kReturnStatement:
+          tail_call(
+              *dynamic_cast<ReturnStatement&>(*statements[i]).return_value(),
+              true);
+          break;
+        case NodeType::kExpressionStatement:
+          tail_call(
+              *dynamic_cast<ExpressionStatement&>(*statements[i]).expression(),
+              last);
+          break;
+        case NodeType::kBlockStatement:
+          tail_calls(dynamic_cast<BlockStatement&>(*statements[i]), last);
+          break;
+        default:
+          break;
+      }
+    }
+  }
+
+  // The branches of an if run as statements too; `tail` tells whether the
+  // function returns the expression's value.
+  void tail_call(Expression& node, bool tail) {
+    switch (node.type()) {
+      case NodeType::kCallExpression:
+        dynamic_cast<CallExpression&>(node).set_tail(tail);
+        return;
+      case NodeType::kIfExpression: {
+        const auto& branch = dynamic_cast<IfExpression&>(node);
+        tail_calls(*branch.consequence(), tail);
+        if (branch.alternative()) {
+          tail_calls(*branch.alternative(), tail);
+        }
+        return;
+      }
+      default:
+        return;
+    }
+  }
+
+  void enter() {
+    ++level_;
+    frames_.resize(level_ + 1);
+  }
+
+  void leave() {
+    frames_.pop_back();
+    --level_;
+  }
+
+  // Slots are handed out for every let up front, so that closures can refer
+  // to names declared after them.
+  void body(Scope& scope, const BlockStatement& block) {
+    for (const auto& statement : block.statements()) {
+      if (statement->type() != NodeType::kLetStatement) {
+        continue;
+      }
+      const auto name =
+          dynamic_cast<const LetStatement&>(*statement).name()->symbol();
+      if (auto* binding = scope.find(name)) {
+        ++binding->pending;
+      } else {
+        scope.bindings.push_back(
+            {.name = name, .slot = (*frame_size_)++, .pending = 1});
+      }
+    }
+    scope_ = &scope;
+    for (const auto& statement : block.statements()) {
+      resolve(*statement);
+    }
+    scope_ = scope.outer;
+  }
+
+  Scope* scope_ = nullptr;
+  // Frames between the top level and the scope being resolved.
+  uint32_t level_ = 0;
+  uint32_t* frame_size_ = nullptr;
+  // By level, the first being the top level, which captures nothing.
+  std::vector<Frame> frames_ = std::vector<Frame>(1);
+  std::vector<Address> candidates_;
+};
+
+}  // namespace
+
+void resolve(const Program& program) {
+  for (const auto& statement : program.statements()) {
+    std::call_once(statement->resolved(),
+                   [&] { Resolver().resolve_top_level(*statement); });
+  }
+}
+
+}  // namespace monkey::ast
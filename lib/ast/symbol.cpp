@@ -0,0 +1,135 @@
+#include <monkey/ast/symbol.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace monkey::ast {
+
+namespace {
+
+uint32_t hash_name(std::string_view name) {
+  uint32_t hash = 2166136261U;
+  for (const auto c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 16777619U;
+  }
+  return hash;
+}
+
+// Names live in a deque, which never moves its elements, so name() can hand
+// out references without holding the lock. Lookup is open addressing over
+// (hash, id) pairs, which only touches a name on a full hash match.
+class SymbolTable {
+ public:
+  SymbolTable() { insert(0, "", hash_name("")); }
+
+  // Returns the id along with a view of the table's copy of the name.
+  std::pair<std::string_view, uint32_t> intern(std::string_view name,
+                                               uint32_t hash) {
+    {
+      const auto lock = std::shared_lock(mutex_);
+      if (const auto id = slots_[find(name, hash)].id; id != kEmpty) {
+        return {names_[id], id};
+      }
+    }
+    const auto lock = std::unique_lock(mutex_);
+    auto slot = find(name, hash);
+    if (const auto id = slots_[slot].id; id != kEmpty) {
+      return {names_[id], id};
+    }
+    if ((names_.size() + 1) * 2 > slots_.size()) {
+      grow();
+      slot = find(name, hash);
+    }
+    const auto id = static_cast<uint32_t>(names_.size());
+    insert(slot, name, hash);
+    return {names_.back(), id};
+  }
+
+  const std::string& name(uint32_t id) const {
+    const auto lock = std::shared_lock(mutex_);
+    return names_[id];
+  }
+
+ private:
+  static constexpr uint32_t kEmpty = std::numeric_limits<uint32_t>::max();
+
+  struct Slot {
+    uint32_t hash = 0;
+    uint32_t id = kEmpty;
+  };
+
+  // The slot holding `name`, or the empty one where it would go.
+  [[nodiscard]] size_t find(std::string_view name, uint32_t hash) const {
+    const auto mask = slots_.size() - 1;
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+      const auto& entry = slots_[slot];
+      if (entry.id == kEmpty ||
+          (entry.hash == hash && names_[entry.id] == name)) {
+        return slot;
+      }
+    }
+  }
+
+  void insert(size_t slot, std::string_view name, uint32_t hash) {
+    slots_[slot] = {hash, static_cast<uint32_t>(names_.size())};
+    names_.emplace_back(name);
+  }
+
+  void grow() {
+    auto slots = std::vector<Slot>(slots_.size() * 2);
+    const auto mask = slots.size() - 1;
+    for (const auto& entry : slots_) {
+      if (entry.id != kEmpty) {
+        auto slot = entry.hash & mask;
+        while (slots[slot].id != kEmpty) {
+          slot = (slot + 1) & mask;
+        }
+        slots[slot] = entry;
+      }
+    }
+    slots_ = std::move(slots);
+  }
+
+  mutable std::shared_mutex mutex_;
+  std::deque<std::string> names_;
+  std::vector<Slot> slots_ = std::vector<Slot>(1024);
+};
+
+SymbolTable& table() {
+  static SymbolTable table;
+  return table;
+}
+
+}  // namespace
+
+Symbol Symbol::intern(std::string_view name) {
+  // A per-thread direct-mapped cache in front of the table, so that looking
+  // up a name seen before usually takes no lock. Entries view the table's own
+  // copies, which stay put. A zeroed entry holds the empty name, whose id is
+  // 0.
+  struct Entry {
+    std::string_view name;
+    uint32_t id = 0;
+  };
+  thread_local auto cache = std::array<Entry, 1024>();
+  const auto hash = hash_name(name);
+  auto& entry = cache[hash % cache.size()];
+  if (entry.name != name) {
+    const auto [interned, id] = table().intern(name, hash);
+    entry = {interned, id};
+  }
+  return Symbol(entry.id);
+}
+
+const std::string& Symbol::name() const { return table().name(id_); }
+
+}  // namespace monkey::ast
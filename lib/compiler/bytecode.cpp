@@ -0,0 +1,135 @@
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <monkey/compiler/bytecode.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace monkey::compiler {
+
+bool has_operand(Opcode opcode) {
+  switch (opcode) {
+    case Opcode::kInteger:
+    case Opcode::kConstant:
+    case Opcode::kGetLocal:
+    case Opcode::kSetLocal:
+    case Opcode::kGetSlot:
+    case Opcode::kSetSlot:
+    case Opcode::kGetCapture:
+    case Opcode::kGetGlobal:
+    case Opcode::kSetGlobal:
+    case Opcode::kGetName:
+    case Opcode::kJump:
+    case Opcode::kJumpIfFalse:
+    case Opcode::kArray:
+    case Opcode::kHash:
+    case Opcode::kCall:
+    case Opcode::kClosure:
+    case Opcode::kEnterBlock:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::string_view to_string(Opcode opcode) {
+  switch (opcode) {
+    case Opcode::kInteger:
+      return "integer";
+    case Opcode::kConstant:
+      return "constant";
+    case Opcode::kTrue:
+      return "true";
+    case Opcode::kFalse:
+      return "false";
+    case Opcode::kNull:
+      return "null";
+    case Opcode::kPop:
+      return "pop";
+    case Opcode::kGetLocal:
+      return "get_local";
+    case Opcode::kSetLocal:
+      return "set_local";
+    case Opcode::kGetSlot:
+      return "get_slot";
+    case Opcode::kSetSlot:
+      return "set_slot";
+    case Opcode::kGetCapture:
+      return "get_capture";
+    case Opcode::kGetGlobal:
+      return "get_global";
+    case Opcode::kSetGlobal:
+      return "set_global";
+    case Opcode::kGetName:
+      return "get_name";
+    case Opcode::kMinus:
+      return "minus";
+    case Opcode::kBang:
+      return "bang";
+    case Opcode::kAdd:
+      return "add";
+    case Opcode::kSubtract:
+      return "subtract";
+    case Opcode::kMultiply:
+      return "multiply";
+    case Opcode::kDivide:
+      return "divide";
+    case Opcode::kLessThan:
+      return "less_than";
+    case Opcode::kGreaterThan:
+      return "greater_than";
+    case Opcode::kEqual:
+      return "equal";
+    case Opcode::kNotEqual:
+      return "not_equal";
+    case Opcode::kJump:
+      return "jump";
+    case Opcode::kJumpIfFalse:
+      return "jump_if_false";
+    case Opcode::kArray:
+      return "array";
+    case Opcode::kHash:
+      return "hash";
+    case Opcode::kIndex:
+      return "index";
+    case Opcode::kCall:
+      return "call";
+    case Opcode::kReturn:
+      return "return";
+    case Opcode::kClosure:
+      return "closure";
+    case Opcode::kEnterBlock:
+      return "enter_block";
+    case Opcode::kLeaveBlock:
+      return "leave_block";
+  }
+  return "unknown";
+}
+
+std::string disassemble(const Module& module) {
+  std::string out;
+  for (size_t i = 0; i < module.functions.size(); ++i) {
+    const auto& function = module.functions[i];
+    out += fmt::format("function {} ({} slots{})\n", i, function.frame_size,
+                       function.frame_escapes ? ", escapes" : "");
+    const auto& code = function.code;
+    for (size_t offset = 0; offset < code.size();) {
+      const auto opcode = static_cast<Opcode>(code[offset]);
+      out += fmt::format("{:04} {}", offset, to_string(opcode));
+      ++offset;
+      if (has_operand(opcode)) {
+        uint32_t operand = 0;
+        std::memcpy(&operand, &code[offset], sizeof(operand));
+        offset += sizeof(operand);
+        out += fmt::format(" {}", operand);
+      }
+      out += '\n';
+    }
+  }
+  return out;
+}
+
+}  // namespace monkey::compiler
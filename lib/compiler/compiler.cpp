@@ -0,0 +1,346 @@
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/resolver.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/compiler/bytecode.h>
+#include <monkey/compiler/compiler.h>
+#include <monkey/lexer/token.h>
+#include <monkey/object/object.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace monkey::compiler {
+
+namespace {
+
+class Compiler {
+ public:
+  std::shared_ptr<const Module> compile(const ast::Program& program) {
+    module_->arena = program.arena();
+    module_->functions.emplace_back();
+    statements(program.statements());
+    emit(Opcode::kReturn);
+    return std::move(module_);
+  }
+
+ private:
+  // Every statement leaves its value on the stack, and all but the last are
+  // dropped again. A list without any yields null.
+  void statements(const std::vector<std::shared_ptr<ast::Statement>>& list) {
+    if (list.empty()) {
+      emit(Opcode::kNull);
+      return;
+    }
+    for (size_t i = 0; i < list.size(); ++i) {
+      if (i > 0) {
+        emit(Opcode::kPop);
+      }
+      statement(*list[i]);
+    }
+  }
+
+  void statement(const ast::Statement& node) {
+    switch (node.type()) {
+      case ast::NodeType::kLetStatement: {
+        const auto& let = dynamic_cast<const ast::LetStatement&>(node);
+        expression(*let.value());
+        const auto& name = *let.name();
+        if (name.address().global()) {
+          emit(Opcode::kSetGlobal, global(name.symbol()));
+        } else {
+          emit(heap_frame_ ? Opcode::kSetSlot : Opcode::kSetLocal,
+               name.address().index);
+        }
+        return;
+      }
+      case ast::NodeType::kReturnStatement:
+        expression(
+            *dynamic_cast<const ast::ReturnStatement&>(node).return_value());
+        emit(Opcode::kReturn);
+        return;
+      case ast::NodeType::kExpressionStatement:
+        expression(
+            *dynamic_cast<const ast::ExpressionStatement&>(node).expression());
+        return;
+      case ast::NodeType::kBlockStatement:
+        block(dynamic_cast<const ast::BlockStatement&>(node));
+        return;
+      default:
+        emit(Opcode::kNull);
+        return;
+    }
+  }
+
+  // Only a top-level block has a frame of its own, which is never on the
+  // stack; any other uses its function's.
+  void block(const ast::BlockStatement& node) {
+    if (node.frame_size() == 0) {
+      statements(node.statements());
+      return;
+    }
+    const auto outer = std::exchange(heap_frame_, true);
+    emit(Opcode::kEnterBlock, node.frame_size());
+    statements(node.statements());
+    emit(Opcode::kLeaveBlock);
+    heap_frame_ = outer;
+  }
+
+  void expression(const ast::Expression& node) {
+    switch (node.type()) {
+      case ast::NodeType::kIdentifier:
+        identifier(dynamic_cast<const ast::Identifier&>(node));
+        return;
+      case ast::NodeType::kIntegerLiteral:
+        emit(Opcode::kInteger,
+             integer(dynamic_cast<const ast::IntegerLiteral&>(node).value()));
+        return;
+      case ast::NodeType::kBooleanLiteral:
+        emit(dynamic_cast<const ast::BooleanLiteral&>(node).value()
+                 ? Opcode::kTrue
+                 : Opcode::kFalse);
+        return;
+      case ast::NodeType::kStringLiteral:
+        module_->constants.push_back(std::make_shared<object::String>(
+            dynamic_cast<const ast::StringLiteral&>(node).value()));
+        emit(Opcode::kConstant,
+             static_cast<uint32_t>(module_->constants.size() - 1));
+        return;
+      case ast::NodeType::kArrayLiteral: {
+        const auto& elements =
+            dynamic_cast<const ast::ArrayLiteral&>(node).elements();
+        for (const auto& element : elements) {
+          expression(*element);
+        }
+        emit(Opcode::kArray, static_cast<uint32_t>(elements.size()));
+        return;
+      }
+      case ast::NodeType::kHashLiteral: {
+        const auto& pairs = dynamic_cast<const ast::HashLiteral&>(node).pairs();
+        for (const auto& [key, value] : pairs) {
+          expression(*key);
+          expression(*value);
+        }
+        emit(Opcode::kHash, static_cast<uint32_t>(pairs.size()));
+        return;
+      }
+      case ast::NodeType::kPrefixExpression: {
+        const auto& prefix = dynamic_cast<const ast::PrefixExpression&>(node);
+        expression(*prefix.right());
+        prefix_operator(prefix.op());
+        return;
+      }
+      case ast::NodeType::kInfixExpression: {
+        const auto& infix = dynamic_cast<const ast::InfixExpression&>(node);
+        expression(*infix.left());
+        expression(*infix.right());
+        infix_operator(infix.op());
+        return;
+      }
+      case ast::NodeType::kIfExpression:
+        branch(dynamic_cast<const ast::IfExpression&>(node));
+        return;
+      case ast::NodeType::kFunctionLiteral:
+        emit(Opcode::kClosure,
+             function(dynamic_cast<const ast::FunctionLiteral&>(node)));
+        return;
+      case ast::NodeType::kCallExpression: {
+        const auto& call = dynamic_cast<const ast::CallExpression&>(node);
+        expression(*call.function());
+        for (const auto& argument : call.arguments()) {
+          expression(*argument);
+        }
+        emit(Opcode::kCall, static_cast<uint32_t>(call.arguments().size()));
+        return;
+      }
+      case ast::NodeType::kIndexExpression: {
+        const auto& index = dynamic_cast<const ast::IndexExpression&>(node);
+        expression(*index.left());
+        expression(*index.index());
+        emit(Opcode::kIndex);
+        return;
+      }
+      default:
+        emit(Opcode::kNull);
+        return;
+    }
+  }
+
+  // A binding that is sure to be set when the code runs is read directly;
+  // anything with candidates to try in turn is looked up by name.
+  void identifier(const ast::Identifier& node) {
+    const auto address = node.address();
+    if (node.fallbacks().empty()) {
+      switch (address.kind) {
+        case ast::Address::Kind::kGlobal:
+          emit(Opcode::kGetGlobal, global(node.symbol()));
+          return;
+        case ast::Address::Kind::kLocal:
+          emit(heap_frame_ ? Opcode::kGetSlot : Opcode::kGetLocal,
+               address.index);
+          return;
+        case ast::Address::Kind::kCapture:
+          emit(Opcode::kGetCapture, address.index);
+          return;
+        default:
+          break;
+      }
+    }
+    auto name = Name{.symbol = node.symbol(), .addresses = {address}};
+    name.addresses.insert(name.addresses.end(), node.fallbacks().begin(),
+                          node.fallbacks().end());
+    module_->names.push_back(std::move(name));
+    emit(Opcode::kGetName, static_cast<uint32_t>(module_->names.size() - 1));
+  }
+
+  // The parser produces no other operators; were one to get here, it would
+  // yield null rather than fail.
+  void prefix_operator(lexer::TokenType op) {
+    switch (op) {
+      case lexer::TokenType::kBang:
+        emit(Opcode::kBang);
+        return;
+      case lexer::TokenType::kMinus:
+        emit(Opcode::kMinus);
+        return;
+      default:
+        emit(Opcode::kPop);
+        emit(Opcode::kNull);
+        return;
+    }
+  }
+
+  void infix_operator(lexer::TokenType op) {
+    switch (op) {
+      case lexer::TokenType::kPlus:
+        emit(Opcode::kAdd);
+        return;
+      case lexer::TokenType::kMinus:
+        emit(Opcode::kSubtract);
+        return;
+      case lexer::TokenType::kAsterisk:
+        emit(Opcode::kMultiply);
+        return;
+      case lexer::TokenType::kSlash:
+        emit(Opcode::kDivide);
+        return;
+      case lexer::TokenType::kLessThan:
+        emit(Opcode::kLessThan);
+        return;
+      case lexer::TokenType::kGreaterThan:
+        emit(Opcode::kGreaterThan);
+        return;
+      case lexer::TokenType::kEqual:
+        emit(Opcode::kEqual);
+        return;
+      case lexer::TokenType::kNotEqual:
+        emit(Opcode::kNotEqual);
+        return;
+      default:
+        emit(Opcode::kPop);
+        emit(Opcode::kPop);
+        emit(Opcode::kNull);
+        return;
+    }
+  }
+
+  void branch(const ast::IfExpression& node) {
+    expression(*node.condition());
+    const auto otherwise = jump(Opcode::kJumpIfFalse);
+    block(*node.consequence());
+    const auto end = jump(Opcode::kJump);
+    patch(otherwise);
+    if (node.alternative()) {
+      block(*node.alternative());
+    } else {
+      emit(Opcode::kNull);
+    }
+    patch(end);
+  }
+
+  // The body shares the parameters' frame, so it is compiled as a plain
+  // statement list.
+  uint32_t function(const ast::FunctionLiteral& node) {
+    const auto index = static_cast<uint32_t>(module_->functions.size());
+    module_->functions.push_back({.code = {},
+                                  .frame_size = node.frame_size(),
+                                  .frame_escapes = node.frame_escapes(),
+                                  .captures = node.captures(),
+                                  .captured_frames = node.captured_frames(),
+                                  .parameters = node.parameters(),
+                                  .body = node.body()});
+    const auto outer = std::exchange(function_, index);
+    const auto outer_heap_frame =
+        std::exchange(heap_frame_, node.frame_escapes());
+    statements(node.body()->statements());
+    emit(Opcode::kReturn);
+    heap_frame_ = outer_heap_frame;
+    function_ = outer;
+    return index;
+  }
+
+  uint32_t integer(int64_t value) {
+    const auto [it, inserted] = integers_.try_emplace(
+        value, static_cast<uint32_t>(module_->integers.size()));
+    if (inserted) {
+      module_->integers.push_back(value);
+    }
+    return it->second;
+  }
+
+  uint32_t global(ast::Symbol symbol) {
+    const auto [it, inserted] = globals_.try_emplace(
+        symbol, static_cast<uint32_t>(module_->names.size()));
+    if (inserted) {
+      module_->names.push_back({.symbol = symbol, .addresses = {}});
+    }
+    return it->second;
+  }
+
+  std::vector<uint8_t>& code() { return module_->functions[function_].code; }
+
+  void emit(Opcode opcode) { code().push_back(static_cast<uint8_t>(opcode)); }
+
+  void emit(Opcode opcode, uint32_t operand) {
+    emit(opcode);
+    auto& bytes = code();
+    bytes.resize(bytes.size() + sizeof(operand));
+    std::memcpy(&bytes[bytes.size() - sizeof(operand)], &operand,
+                sizeof(operand));
+  }
+
+  // Emits a jump to be patched once its target is known, returning where
+  // its operand is.
+  size_t jump(Opcode opcode) {
+    emit(opcode, 0);
+    return code().size() - sizeof(uint32_t);
+  }
+
+  void patch(size_t operand) {
+    const auto target = static_cast<uint32_t>(code().size());
+    std::memcpy(&code()[operand], &target, sizeof(target));
+  }
+
+  std::shared_ptr<Module> module_ = std::make_shared<Module>();
+  uint32_t function_ = 0;
+  // Whether the locals in scope are in a frame of their own rather than on
+  // the value stack.
+  bool heap_frame_ = false;
+  std::unordered_map<int64_t, uint32_t> integers_;
+  std::unordered_map<ast::Symbol, uint32_t> globals_;
+};
+
+}  // namespace
+
+std::shared_ptr<const Module> compile(const ast::Program& program) {
+  ast::resolve(program);
+  return Compiler().compile(program);
+}
+
+}  // namespace monkey::compiler
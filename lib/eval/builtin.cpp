@@ -1,8 +1,10 @@
 #include <fmt/core.h>
 #include <monkey/eval/builtin.h>
+#include <monkey/object/memo.h>
 #include <monkey/object/object.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -122,6 +124,73 @@ std::shared_ptr<object::Object> puts(
   return std::make_unique<object::Null>();
 }
 
+std::shared_ptr<object::Object> memo(
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  if (args.empty() || args.size() > 2) {
+    return error::wrong_number_of_arguments("memo", 1, 2, args.size());
+  }
+
+  if (args[0]->type() != object::ObjectType::kFunction) {
+    return error::wrong_argument_type("memo", object::ObjectType::kFunction,
+                                      args[0]->type());
+  }
+
+  auto capacity = object::MemoTable::kDefaultCapacity;
+  if (args.size() == 2) {
+    if (args[1]->type() != object::ObjectType::kInteger) {
+      return error::wrong_argument_type("memo", object::ObjectType::kInteger,
+                                        args[1]->type());
+    }
+    const auto value = dynamic_cast<object::Integer&>(*args[1]).value();
+    capacity = value < 0 ? 0 : static_cast<size_t>(value);
+  }
+
+  // Only the tree-walker's functions carry what the resolver found out
+  // about their purity and a cache to check. Those of a flat program, the
+  // bytecode VM and the closure engine do neither.
+  const auto* function = dynamic_cast<const object::Function*>(args[0].get());
+  if (function == nullptr) {
+    return error::unsupported_builtin("memo");
+  }
+  if (!function->pure()) {
+    return error::impure_function("memo");
+  }
+
+  auto memoized = std::make_shared<object::Function>(*function);
+  memoized->set_memo(std::make_shared<object::MemoTable>(capacity));
+  return memoized;
+}
+
+std::shared_ptr<object::Object> memo_stats(
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  if (args.size() != 1) {
+    return error::wrong_number_of_arguments("memo_stats", 1, args.size());
+  }
+
+  if (args[0]->type() != object::ObjectType::kFunction) {
+    return error::wrong_argument_type(
+        "memo_stats", object::ObjectType::kFunction, args[0]->type());
+  }
+
+  const auto* function = dynamic_cast<const object::Function*>(args[0].get());
+  if (function == nullptr || function->memo() == nullptr) {
+    return std::make_shared<object::Null>();
+  }
+
+  const auto& table = *function->memo();
+  object::Hash::HashType pairs;
+  const auto add = [&pairs](const char* name, uint64_t value) {
+    pairs.insert(
+        {std::make_shared<object::String>(name),
+         std::make_shared<object::Integer>(static_cast<int64_t>(value))});
+  };
+  add("hits", table.hits());
+  add("misses", table.misses());
+  add("size", table.size());
+  add("capacity", table.capacity());
+  return std::make_shared<object::Hash>(pairs);
+}
+
 }  // namespace builtin
 
 namespace error {
@@ -138,6 +207,13 @@ std::shared_ptr<object::Object> wrong_number_of_arguments(
                   expected, got));
 }
 
+std::shared_ptr<object::Object> wrong_number_of_arguments(
+    const std::string& name, size_t min, size_t max, size_t got) {
+  return std::make_shared<object::Error>(fmt::format(
+      "wrong number of arguments for {}: expected {} to {}, got {}", name, min,
+      max, got));
+}
+
 std::shared_ptr<object::Object> wrong_argument_type(const std::string& name,
                                                     object::ObjectType expected,
                                                     object::ObjectType got) {
@@ -172,12 +248,26 @@ std::shared_ptr<object::Object> wrong_index_operands(object::ObjectType left,
                   object::to_string(right)));
 }
 
+std::shared_ptr<object::Object> impure_function(const std::string& name) {
+  return std::make_shared<object::Error>(
+      fmt::format("impure function for {}", name));
+}
+
+std::shared_ptr<object::Object> unsupported_builtin(const std::string& name) {
+  return std::make_shared<object::Error>(
+      fmt::format("{}() is not supported on this engine", name));
+}
+
 std::shared_ptr<object::Object> wrong_call_operand(const std::string& name,
                                                    object::ObjectType type) {
   return std::make_shared<object::Error>(fmt::format(
       "wrong operand type for (): {}()", name, object::to_string(type)));
 }
 
+std::shared_ptr<object::Object> call_depth_exceeded() {
+  return std::make_shared<object::Error>("call depth exceeded");
+}
+
 }  // namespace error
 
 }  // namespace monkey::eval
\ No newline at end of file
@@ -0,0 +1,738 @@
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/resolver.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
+#include <monkey/eval/builtin.h>
+#include <monkey/eval/compiled.h>
+#include <monkey/eval/eval.h>
+#include <monkey/eval/value.h>
+#include <monkey/lexer/token.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/resource.h>
+
+namespace monkey::eval {
+
+// The state of a call in progress, or of the top level.
+struct Activation {
+  // Shared by all the calls of a run: arguments and locals of frames that
+  // do not escape live here, from `base` on.
+  std::vector<Value>& stack;
+  const std::shared_ptr<object::Env>& globals;
+  size_t base;
+  // The slots when they are not on the value stack: those of a call whose
+  // frame escapes, or of the top-level block being run.
+  std::shared_ptr<object::Env> frame;
+  // Null at the top level.
+  const BoundFunction* function;
+  // Set by a return statement until the call, or the program, is left.
+  bool returning;
+  // The lowest native stack address a call may start at, see
+  // stack_limit().
+  uintptr_t stack_limit;
+  // Set, along with `returning`, by a call in tail position: the function
+  // to call once this one is left, with the arguments on the stack from
+  // `tail_base` on.
+  std::shared_ptr<object::Object> tail_callee;
+  size_t tail_base;
+};
+
+// What a node compiles to: run, it yields the node's value or an error.
+using Code = std::function<Value(Activation&)>;
+
+struct Prototype {
+  Code body;
+  uint32_t frame_size;
+  bool frame_escapes;
+  std::vector<ast::Capture> captures;
+  std::vector<ast::Capture> captured_frames;
+  // Only for to_string().
+  std::vector<std::shared_ptr<ast::Identifier>> parameters;
+  std::shared_ptr<ast::BlockStatement> node;
+  // Owns the nodes above, unless it is null.
+  std::shared_ptr<const ast::AstArena> arena;
+};
+
+BoundFunction::BoundFunction(
+    std::shared_ptr<const Prototype> prototype,
+    std::shared_ptr<object::Env> env,
+    std::vector<std::shared_ptr<object::Object>> captures,
+    std::vector<std::shared_ptr<object::Env>> frames)
+    : prototype_(std::move(prototype)),
+      env_(std::move(env)),
+      captures_(std::move(captures)),
+      frames_(std::move(frames)) {}
+
+std::string BoundFunction::to_string() const {
+  std::string out = "fn(";
+  for (const auto& param : prototype_->parameters) {
+    out += param->to_string() + ", ";
+  }
+  out += ") {\n" + prototype_->node->to_string() + "\n}";
+  return out;
+}
+
+bool BoundFunction::operator==(const Object& other) const {
+  const auto* function = dynamic_cast<const BoundFunction*>(&other);
+  return function != nullptr && prototype_ == function->prototype_;
+}
+
+bool BoundFunction::operator!=(const Object& other) const {
+  return !(*this == other);
+}
+
+namespace {
+
+Value null() {
+  static const auto instance = std::make_shared<object::Null>();
+  return wrap(instance);
+}
+
+// Unset if no address has the name bound yet and there is no global of that
+// name either.
+Value lookup(const std::vector<ast::Address>& addresses, ast::Symbol symbol,
+             const Activation& activation) {
+  for (const auto address : addresses) {
+    switch (address.kind) {
+      case ast::Address::Kind::kLocal:
+        if (activation.frame == nullptr) {
+          if (const auto& value =
+                  activation.stack[activation.base + address.index];
+              value.kind != Value::Kind::kUnset) {
+            return value;
+          }
+        } else if (const auto& value = activation.frame->slot(address.index)) {
+          return unbox(value);
+        }
+        break;
+      case ast::Address::Kind::kCapture:
+        if (const auto& value =
+                activation.function->captures()[address.index]) {
+          return unbox(value);
+        }
+        break;
+      case ast::Address::Kind::kFrame:
+        if (const auto& value =
+                activation.function->frames()[address.index]->slot(
+                    address.slot)) {
+          return unbox(value);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+  if (auto value = activation.globals->get(symbol)) {
+    return unbox(std::move(value));
+  }
+  return {};
+}
+
+// Every call that is not in tail position recurses on the native stack, so
+// a program recursing to within this much of its end fails instead of
+// overflowing it. What one call takes depends on the expressions it is
+// nested in and on the build, so the stack is measured rather than the
+// calls counted; the margin covers the frames between two calls and those
+// of the builtins and of error reporting below the last one.
+constexpr uintptr_t kStackMargin = uintptr_t{256} << 10;
+
+// Used when the bounds of the stack cannot be asked for, counted from where
+// the run starts.
+constexpr uintptr_t kStackFallback = uintptr_t{1} << 20;
+
+// Where the native stack is, for comparing against Activation::stack_limit.
+[[gnu::noinline]] uintptr_t stack_position() {
+  return reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+}
+
+// The lowest native stack address a call may start at on this thread: the
+// end of its stack plus kStackMargin. Looked up once per thread, as it
+// reads /proc/self/maps for the main one.
+uintptr_t stack_limit() {
+  thread_local const uintptr_t limit = [] {
+    const uintptr_t position = stack_position();
+    uintptr_t size = kStackFallback;
+#if defined(__GLIBC__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+      void* low = nullptr;
+      size_t length = 0;
+      const bool known = pthread_attr_getstack(&attr, &low, &length) == 0;
+      pthread_attr_destroy(&attr);
+      if (known) {
+        return reinterpret_cast<uintptr_t>(low) + kStackMargin;
+      }
+    }
+#endif
+    if (rlimit bound{}; getrlimit(RLIMIT_STACK, &bound) == 0 &&
+        bound.rlim_cur != RLIM_INFINITY) {
+      size = std::min<uintptr_t>(size, bound.rlim_cur);
+    }
+    return position - size + kStackMargin;
+  }();
+  return limit;
+}
+
+// The arguments are on the stack from `base` on, and are left there as the
+// first locals unless the frame escapes. Calls in tail position are made
+// here, one after the other, each with its arguments moved to `base` once
+// the one before has been left.
+Value call(const BoundFunction& function, Activation& caller, size_t base) {
+  if (stack_position() < caller.stack_limit) {
+    caller.stack.resize(base);
+    return wrap(error::call_depth_exceeded());
+  }
+  // Keeps the function called in tail position alive while it runs.
+  std::shared_ptr<object::Object> held;
+  const auto* callee = &function;
+  while (true) {
+    const auto& prototype = callee->prototype();
+    auto activation = Activation{.stack = caller.stack,
+                                 .globals = callee->env(),
+                                 .base = base,
+                                 .frame = nullptr,
+                                 .function = callee,
+                                 .returning = false,
+                                 .stack_limit = caller.stack_limit,
+                                 .tail_callee = nullptr,
+                                 .tail_base = 0};
+    if (prototype.frame_escapes) {
+      activation.frame = std::make_shared<object::Env>(callee->env(),
+                                                       prototype.frame_size);
+      for (uint32_t i = 0; i < prototype.parameters.size(); ++i) {
+        activation.frame->set_slot(i, box(std::move(caller.stack[base + i])));
+      }
+      caller.stack.resize(base);
+    } else {
+      caller.stack.resize(base + prototype.frame_size);
+    }
+    auto result = prototype.body(activation);
+    if (activation.tail_callee == nullptr) {
+      caller.stack.resize(base);
+      return result;
+    }
+    auto& stack = caller.stack;
+    const auto first =
+        stack.begin() + static_cast<std::ptrdiff_t>(activation.tail_base);
+    const auto count = static_cast<size_t>(stack.end() - first);
+    std::move(first, stack.end(),
+              stack.begin() + static_cast<std::ptrdiff_t>(base));
+    stack.resize(base + count);
+    held = std::move(activation.tail_callee);
+    callee = static_cast<const BoundFunction*>(held.get());
+  }
+}
+
+// Integer operands take a path picked once for the operator; anything else
+// goes through the shared operators, which also word the errors.
+template <lexer::TokenType kOp>
+Code infix(Code left, Code right) {
+  return [left = std::move(left),
+          right = std::move(right)](Activation& activation) {
+    auto lhs = left(activation);
+    if (failed(lhs)) {
+      return lhs;
+    }
+    auto rhs = right(activation);
+    if (failed(rhs)) {
+      return rhs;
+    }
+    if (lhs.kind == Value::Kind::kInteger &&
+        rhs.kind == Value::Kind::kInteger) {
+      if constexpr (kOp == lexer::TokenType::kPlus) {
+        return integer(lhs.integer + rhs.integer);
+      } else if constexpr (kOp == lexer::TokenType::kMinus) {
+        return integer(lhs.integer - rhs.integer);
+      } else if constexpr (kOp == lexer::TokenType::kAsterisk) {
+        return integer(lhs.integer * rhs.integer);
+      } else if constexpr (kOp == lexer::TokenType::kSlash) {
+        if (rhs.integer != 0) {
+          return integer(lhs.integer / rhs.integer);
+        }
+      } else if constexpr (kOp == lexer::TokenType::kLessThan) {
+        return boolean(lhs.integer < rhs.integer);
+      } else if constexpr (kOp == lexer::TokenType::kGreaterThan) {
+        return boolean(lhs.integer > rhs.integer);
+      } else if constexpr (kOp == lexer::TokenType::kEqual) {
+        return boolean(lhs.integer == rhs.integer);
+      } else if constexpr (kOp == lexer::TokenType::kNotEqual) {
+        return boolean(lhs.integer != rhs.integer);
+      }
+    }
+    return evalInfixOperator(kOp, std::move(lhs), std::move(rhs));
+  };
+}
+
+class Compiler {
+ public:
+  // Every statement yields a value, and all but the last are dropped. A
+  // list without any yields null.
+  Code statements(const std::vector<std::shared_ptr<ast::Statement>>& list) {
+    if (list.empty()) {
+      return [](Activation&) { return null(); };
+    }
+    std::vector<Code> codes;
+    codes.reserve(list.size());
+    for (const auto& node : list) {
+      codes.push_back(statement(*node));
+    }
+    if (codes.size() == 1) {
+      return std::move(codes.front());
+    }
+    return [codes = std::move(codes)](Activation& activation) {
+      Value value;
+      for (const auto& code : codes) {
+        value = code(activation);
+        if (activation.returning || failed(value)) {
+          break;
+        }
+      }
+      return value;
+    };
+  }
+
+ private:
+  Code statement(const ast::Statement& node) {
+    switch (node.type()) {
+      case ast::NodeType::kLetStatement:
+        return let(dynamic_cast<const ast::LetStatement&>(node));
+      case ast::NodeType::kReturnStatement:
+        return [value = expression(
+                    *dynamic_cast<const ast::ReturnStatement&>(node)
+                         .return_value())](Activation& activation) {
+          auto result = value(activation);
+          activation.returning = true;
+          return result;
+        };
+      case ast::NodeType::kExpressionStatement:
+        return expression(
+            *dynamic_cast<const ast::ExpressionStatement&>(node).expression());
+      case ast::NodeType::kBlockStatement:
+        return block(dynamic_cast<const ast::BlockStatement&>(node));
+      default:
+        return [](Activation&) { return null(); };
+    }
+  }
+
+  Code let(const ast::LetStatement& node) {
+    auto value = expression(*node.value());
+    const auto& name = *node.name();
+    if (name.address().global()) {
+      return [value = std::move(value),
+              symbol = name.symbol()](Activation& activation) {
+        auto result = value(activation);
+        if (!failed(result)) {
+          activation.globals->set(symbol, box(result));
+        }
+        return result;
+      };
+    }
+    if (heap_frame_) {
+      return [value = std::move(value),
+              slot = name.address().index](Activation& activation) {
+        auto result = value(activation);
+        if (!failed(result)) {
+          activation.frame->set_slot(slot, box(result));
+        }
+        return result;
+      };
+    }
+    return [value = std::move(value),
+            slot = name.address().index](Activation& activation) {
+      auto result = value(activation);
+      if (!failed(result)) {
+        activation.stack[activation.base + slot] = result;
+      }
+      return result;
+    };
+  }
+
+  // Only a top-level block has a frame of its own, which is never on the
+  // stack; any other uses its function's.
+  Code block(const ast::BlockStatement& node) {
+    if (node.frame_size() == 0) {
+      return statements(node.statements());
+    }
+    const auto outer = std::exchange(heap_frame_, true);
+    auto body = statements(node.statements());
+    heap_frame_ = outer;
+    return [body = std::move(body),
+            size = node.frame_size()](Activation& activation) {
+      activation.frame =
+          std::make_shared<object::Env>(activation.globals, size);
+      auto result = body(activation);
+      activation.frame = nullptr;
+      return result;
+    };
+  }
+
+  Code expression(const ast::Expression& node) {
+    switch (node.type()) {
+      case ast::NodeType::kIdentifier:
+        return identifier(dynamic_cast<const ast::Identifier&>(node));
+      case ast::NodeType::kIntegerLiteral:
+        return [value = integer(
+                    dynamic_cast<const ast::IntegerLiteral&>(node).value())](
+                   Activation&) { return value; };
+      case ast::NodeType::kBooleanLiteral:
+        return [value = boolean(
+                    dynamic_cast<const ast::BooleanLiteral&>(node).value())](
+                   Activation&) { return value; };
+      case ast::NodeType::kStringLiteral:
+        return [value = wrap(std::make_shared<object::String>(
+                    dynamic_cast<const ast::StringLiteral&>(node).value()))](
+                   Activation&) { return value; };
+      case ast::NodeType::kArrayLiteral:
+        return array(dynamic_cast<const ast::ArrayLiteral&>(node));
+      case ast::NodeType::kHashLiteral:
+        return hash(dynamic_cast<const ast::HashLiteral&>(node));
+      case ast::NodeType::kPrefixExpression:
+        return prefix(dynamic_cast<const ast::PrefixExpression&>(node));
+      case ast::NodeType::kInfixExpression:
+        return infix(dynamic_cast<const ast::InfixExpression&>(node));
+      case ast::NodeType::kIfExpression:
+        return branch(dynamic_cast<const ast::IfExpression&>(node));
+      case ast::NodeType::kFunctionLiteral:
+        return function(dynamic_cast<const ast::FunctionLiteral&>(node));
+      case ast::NodeType::kCallExpression:
+        return call(dynamic_cast<const ast::CallExpression&>(node));
+      case ast::NodeType::kIndexExpression:
+        return index(dynamic_cast<const ast::IndexExpression&>(node));
+      default:
+        return [](Activation&) { return null(); };
+    }
+  }
+
+  // A binding that is sure to be set when the code runs is read directly;
+  // anything with candidates to try in turn is looked up by name.
+  Code identifier(const ast::Identifier& node) {
+    const auto address = node.address();
+    const auto symbol = node.symbol();
+    if (node.fallbacks().empty()) {
+      switch (address.kind) {
+        case ast::Address::Kind::kGlobal:
+          return [symbol](Activation& activation) {
+            if (auto value = activation.globals->get(symbol)) {
+              return unbox(std::move(value));
+            }
+            return wrap(error::unknown_identifier(symbol.name()));
+          };
+        case ast::Address::Kind::kLocal:
+          if (heap_frame_) {
+            return [slot = address.index](Activation& activation) {
+              return unbox(activation.frame->slot(slot));
+            };
+          }
+          return [slot = address.index](Activation& activation) {
+            return activation.stack[activation.base + slot];
+          };
+        case ast::Address::Kind::kCapture:
+          return [index = address.index](Activation& activation) {
+            return unbox(activation.function->captures()[index]);
+          };
+        default:
+          break;
+      }
+    }
+    auto addresses = std::vector<ast::Address>{address};
+    addresses.insert(addresses.end(), node.fallbacks().begin(),
+                     node.fallbacks().end());
+    return [addresses = std::move(addresses),
+            symbol](Activation& activation) {
+      auto value = lookup(addresses, symbol, activation);
+      if (value.kind == Value::Kind::kUnset) {
+        return wrap(error::unknown_identifier(symbol.name()));
+      }
+      return value;
+    };
+  }
+
+  Code array(const ast::ArrayLiteral& node) {
+    std::vector<Code> elements;
+    elements.reserve(node.elements().size());
+    for (const auto& element : node.elements()) {
+      elements.push_back(expression(*element));
+    }
+    return [elements = std::move(elements)](Activation& activation) {
+      std::vector<std::shared_ptr<object::Object>> values;
+      values.reserve(elements.size());
+      for (const auto& element : elements) {
+        auto value = element(activation);
+        if (failed(value)) {
+          return value;
+        }
+        values.push_back(box(std::move(value)));
+      }
+      return wrap(std::make_shared<object::Array>(std::move(values)));
+    };
+  }
+
+  Code hash(const ast::HashLiteral& node) {
+    std::vector<std::pair<Code, Code>> pairs;
+    pairs.reserve(node.pairs().size());
+    for (const auto& [key, value] : node.pairs()) {
+      pairs.emplace_back(expression(*key), expression(*value));
+    }
+    return [pairs = std::move(pairs)](Activation& activation) {
+      object::Hash::HashType values;
+      for (const auto& [key, value] : pairs) {
+        auto k = key(activation);
+        if (failed(k)) {
+          return k;
+        }
+        auto v = value(activation);
+        if (failed(v)) {
+          return v;
+        }
+        values.insert({box(std::move(k)), box(std::move(v))});
+      }
+      return wrap(std::make_shared<object::Hash>(std::move(values)));
+    };
+  }
+
+  // The parser produces no other operators; were one to get here, it would
+  // yield null rather than fail.
+  Code prefix(const ast::PrefixExpression& node) {
+    auto right = expression(*node.right());
+    switch (node.op()) {
+      case lexer::TokenType::kBang:
+        return [right = std::move(right)](Activation& activation) {
+          auto value = right(activation);
+          if (value.kind == Value::Kind::kBoolean) {
+            return boolean(!value.boolean);
+          }
+          if (failed(value)) {
+            return value;
+          }
+          return evalPrefixOperator(lexer::TokenType::kBang, std::move(value));
+        };
+      case lexer::TokenType::kMinus:
+        return [right = std::move(right)](Activation& activation) {
+          auto value = right(activation);
+          if (value.kind == Value::Kind::kInteger) {
+            return integer(-value.integer);
+          }
+          if (failed(value)) {
+            return value;
+          }
+          return evalPrefixOperator(lexer::TokenType::kMinus,
+                                    std::move(value));
+        };
+      default:
+        return [right = std::move(right)](Activation& activation) {
+          auto value = right(activation);
+          return failed(value) ? value : null();
+        };
+    }
+  }
+
+  Code infix(const ast::InfixExpression& node) {
+    auto left = expression(*node.left());
+    auto right = expression(*node.right());
+    switch (node.op()) {
+      case lexer::TokenType::kPlus:
+        return eval::infix<lexer::TokenType::kPlus>(std::move(left),
+                                                    std::move(right));
+      case lexer::TokenType::kMinus:
+        return eval::infix<lexer::TokenType::kMinus>(std::move(left),
+                                                     std::move(right));
+      case lexer::TokenType::kAsterisk:
+        return eval::infix<lexer::TokenType::kAsterisk>(std::move(left),
+                                                        std::move(right));
+      case lexer::TokenType::kSlash:
+        return eval::infix<lexer::TokenType::kSlash>(std::move(left),
+                                                     std::move(right));
+      case lexer::TokenType::kLessThan:
+        return eval::infix<lexer::TokenType::kLessThan>(std::move(left),
+                                                        std::move(right));
+      case lexer::TokenType::kGreaterThan:
+        return eval::infix<lexer::TokenType::kGreaterThan>(std::move(left),
+                                                           std::move(right));
+      case lexer::TokenType::kEqual:
+        return eval::infix<lexer::TokenType::kEqual>(std::move(left),
+                                                     std::move(right));
+      case lexer::TokenType::kNotEqual:
+        return eval::infix<lexer::TokenType::kNotEqual>(std::move(left),
+                                                        std::move(right));
+      default:
+        return [left = std::move(left),
+                right = std::move(right)](Activation& activation) {
+          auto lhs = left(activation);
+          if (failed(lhs)) {
+            return lhs;
+          }
+          auto rhs = right(activation);
+          return failed(rhs) ? rhs : null();
+        };
+    }
+  }
+
+  Code branch(const ast::IfExpression& node) {
+    auto alternative = node.alternative()
+                           ? block(*node.alternative())
+                           : Code([](Activation&) { return null(); });
+    return [condition = expression(*node.condition()),
+            consequence = block(*node.consequence()),
+            alternative =
+                std::move(alternative)](Activation& activation) {
+      auto value = condition(activation);
+      if (failed(value)) {
+        return value;
+      }
+      return isTruthy(value) ? consequence(activation)
+                             : alternative(activation);
+    };
+  }
+
+  // The body shares the parameters' frame, so it is compiled as a plain
+  // statement list.
+  Code function(const ast::FunctionLiteral& node) {
+    const auto outer = std::exchange(heap_frame_, node.frame_escapes());
+    auto prototype = std::make_shared<const Prototype>(
+        Prototype{.body = statements(node.body()->statements()),
+                  .frame_size = node.frame_size(),
+                  .frame_escapes = node.frame_escapes(),
+                  .captures = node.captures(),
+                  .captured_frames = node.captured_frames(),
+                  .parameters = node.parameters(),
+                  .node = node.body(),
+                  .arena = node.arena()});
+    heap_frame_ = outer;
+    return [prototype = std::move(prototype)](Activation& activation) {
+      std::vector<std::shared_ptr<object::Object>> captures;
+      captures.reserve(prototype->captures.size());
+      for (const auto capture : prototype->captures) {
+        if (capture.source != ast::Capture::Source::kSlot) {
+          captures.push_back(activation.function->captures()[capture.index]);
+        } else if (activation.frame == nullptr) {
+          captures.push_back(
+              box(activation.stack[activation.base + capture.index]));
+        } else {
+          captures.push_back(activation.frame->slot(capture.index));
+        }
+      }
+      std::vector<std::shared_ptr<object::Env>> frames;
+      frames.reserve(prototype->captured_frames.size());
+      for (const auto capture : prototype->captured_frames) {
+        frames.push_back(capture.source == ast::Capture::Source::kFrame
+                             ? activation.frame
+                             : activation.function->frames()[capture.index]);
+      }
+      return wrap(std::make_shared<BoundFunction>(
+          prototype, activation.globals, std::move(captures),
+          std::move(frames)));
+    };
+  }
+
+  // Arguments go straight onto the stack, where the callee finds its
+  // locals. Anything but a function of this engine is called as the
+  // evaluator would, builtins included.
+  Code call(const ast::CallExpression& node) {
+    std::vector<Code> arguments;
+    arguments.reserve(node.arguments().size());
+    for (const auto& argument : node.arguments()) {
+      arguments.push_back(expression(*argument));
+    }
+    return [callee = expression(*node.function()),
+            arguments = std::move(arguments),
+            tail = node.tail()](Activation& activation) {
+      auto function = callee(activation);
+      if (failed(function)) {
+        return function;
+      }
+      auto& stack = activation.stack;
+      const auto base = stack.size();
+      for (const auto& argument : arguments) {
+        auto value = argument(activation);
+        if (failed(value)) {
+          stack.resize(base);
+          return value;
+        }
+        stack.push_back(std::move(value));
+      }
+      if (function.kind != Value::Kind::kObject ||
+          function.object->type() != object::ObjectType::kFunction) {
+        std::vector<std::shared_ptr<object::Object>> args;
+        args.reserve(arguments.size());
+        for (auto i = base; i < stack.size(); ++i) {
+          args.push_back(box(std::move(stack[i])));
+        }
+        stack.resize(base);
+        return unbox(applyFunction(box(std::move(function)), args));
+      }
+      const auto& bound = static_cast<const BoundFunction&>(*function.object);
+      if (const auto expected = bound.prototype().parameters.size();
+          arguments.size() != expected) {
+        stack.resize(base);
+        return wrap(error::wrong_number_of_arguments(
+            bound.to_string(), expected, arguments.size()));
+      }
+      // Left to the caller of the function this call is in, see
+      // ast::CallExpression::tail().
+      if (tail) {
+        activation.tail_callee = std::move(function.object);
+        activation.tail_base = base;
+        activation.returning = true;
+        return null();
+      }
+      return eval::call(bound, activation, base);
+    };
+  }
+
+  Code index(const ast::IndexExpression& node) {
+    return [left = expression(*node.left()),
+            index = expression(*node.index())](Activation& activation) {
+      auto lhs = left(activation);
+      if (failed(lhs)) {
+        return lhs;
+      }
+      auto rhs = index(activation);
+      if (failed(rhs)) {
+        return rhs;
+      }
+      return unbox(
+          evalIndexOperator(box(std::move(lhs)), box(std::move(rhs))));
+    };
+  }
+
+  // Whether the locals in scope are in a frame of their own rather than on
+  // the value stack.
+  bool heap_frame_ = false;
+};
+
+}  // namespace
+
+std::shared_ptr<object::Object> evalCompiled(
+    const ast::Program& program, std::shared_ptr<object::Env>& env) {
+  ast::resolve(program);
+  if (program.statements().empty()) {
+    return nullptr;
+  }
+  const auto code = Compiler().statements(program.statements());
+  std::vector<Value> stack;
+  auto activation = Activation{.stack = stack,
+                               .globals = env,
+                               .base = 0,
+                               .frame = nullptr,
+                               .function = nullptr,
+                               .returning = false,
+                               .stack_limit = stack_limit(),
+                               .tail_callee = nullptr,
+                               .tail_base = 0};
+  return box(code(activation));
+}
+
+}  // namespace monkey::eval
@@ -1,14 +1,23 @@
+#include <monkey/ast/arena.h>
 #include <monkey/ast/ast.h>
 #include <monkey/ast/expr.h>
+#include <monkey/ast/resolver.h>
 #include <monkey/ast/stmt.h>
 #include <monkey/eval/builtin.h>
 #include <monkey/eval/eval.h>
+#include <monkey/eval/flat.h>
+#include <monkey/eval/value.h>
 #include <monkey/lexer/token.h>
 #include <monkey/object/env.h>
+#include <monkey/object/memo.h>
 #include <monkey/object/object.h>
 
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace monkey::eval {
@@ -72,6 +81,7 @@ std::shared_ptr<object::Object> eval(const ast::Node& node,
 
 std::shared_ptr<object::Object> evalProgram(const ast::Program& program,
                                             std::shared_ptr<object::Env>& env) {
+  ast::resolve(program);
   std::shared_ptr<object::Object> result;
   for (const auto& statement : program.statements()) {
     result = eval(*statement, env);
@@ -94,7 +104,12 @@ std::shared_ptr<object::Object> evalLetStatement(
     return value;
   }
 
-  env->set(let_statement.name()->name(), value);
+  const auto& name = *let_statement.name();
+  if (name.address().global()) {
+    env->set(name.symbol(), value);
+  } else {
+    env->set_slot(name.address().index, value);
+  }
   return value;
 }
 
@@ -102,7 +117,9 @@ std::shared_ptr<object::Object> evalReturnStatement(
     const ast::ReturnStatement& return_statement,
     std::shared_ptr<object::Env>& env) {
   auto value = eval(*return_statement.return_value(), env);
-  if (value->type() == object::ObjectType::kError) {
+  // A tail call leaves the function just as well, see callFunction().
+  if (value->type() == object::ObjectType::kError ||
+      value->type() == object::ObjectType::kTailCall) {
     return value;
   }
 
@@ -115,15 +132,70 @@ std::shared_ptr<object::Object> evalExpressionStatement(
   return eval(*expression_statement.expression(), env);
 }
 
-std::shared_ptr<object::Object> evalBlockStatement(
+namespace {
+
+// Frames that no closure can keep, see ast::FunctionLiteral::frame_escapes(),
+// reused last in first out: once the stack has been as deep as a call
+// needs, the call allocates no frame at all.
+class FrameStack {
+ public:
+  // The frame is handed out as a shared_ptr that owns nothing, kept along
+  // with it so that a call holds no more than a reference on the native
+  // stack.
+  std::shared_ptr<object::Env>& push(std::shared_ptr<object::Env> outer,
+                                     size_t size,
+                                     const object::Function* function) {
+    if (depth_ == frames_.size()) {
+      auto added = std::make_unique<Frame>();
+      added->handle = {std::shared_ptr<object::Env>(), &added->env};
+      frames_.push_back(std::move(added));
+    }
+    auto& frame = *frames_[depth_++];
+    frame.env.reset(std::move(outer), size, function);
+    return frame.handle;
+  }
+
+  // Releases what the frame holds right away, as freeing it would.
+  void pop() { frames_[--depth_]->env.reset(nullptr, 0, nullptr); }
+
+ private:
+  struct Frame {
+    object::Env env{nullptr, 0};
+    std::shared_ptr<object::Env> handle;
+  };
+
+  // Frames stay where they are as the vector grows.
+  std::vector<std::unique_ptr<Frame>> frames_;
+  size_t depth_ = 0;
+};
+
+thread_local FrameStack frame_stack;
+
+// A frame from the stack for as long as a call or block runs.
+class StackFrame {
+ public:
+  StackFrame(std::shared_ptr<object::Env> outer, size_t size,
+             const object::Function* function = nullptr)
+      : frame_(frame_stack.push(std::move(outer), size, function)) {}
+  StackFrame(const StackFrame&) = delete;
+  StackFrame& operator=(const StackFrame&) = delete;
+  ~StackFrame() { frame_stack.pop(); }
+
+  std::shared_ptr<object::Env>& get() { return frame_; }
+
+ private:
+  std::shared_ptr<object::Env>& frame_;
+};
+
+std::shared_ptr<object::Object> evalStatements(
     const ast::BlockStatement& block_statement,
     std::shared_ptr<object::Env>& env) {
-  auto subenv = std::make_shared<object::Env>(env);
   std::shared_ptr<object::Object> result;
   for (const auto& statement : block_statement.statements()) {
-    result = eval(*statement, subenv);
+    result = eval(*statement, env);
 
     if (result->type() == object::ObjectType::kReturnValue ||
+        result->type() == object::ObjectType::kTailCall ||
         result->type() == object::ObjectType::kError) {
       return result;
     }
@@ -132,10 +204,66 @@ std::shared_ptr<object::Object> evalBlockStatement(
   return result;
 }
 
+// Kept out of line, like every path that makes a frame, so that the
+// functions each call recurses through take as little native stack as they
+// can.
+[[gnu::noinline]] std::shared_ptr<object::Object> evalBlockInFrame(
+    const ast::BlockStatement& block_statement,
+    std::shared_ptr<object::Env>& env) {
+  if (block_statement.frame_escapes()) {
+    auto frame =
+        std::make_shared<object::Env>(env, block_statement.frame_size());
+    return evalStatements(block_statement, frame);
+  }
+  auto frame = StackFrame(env, block_statement.frame_size());
+  return evalStatements(block_statement, frame.get());
+}
+
+}  // namespace
+
+std::shared_ptr<object::Object> evalBlockStatement(
+    const ast::BlockStatement& block_statement,
+    std::shared_ptr<object::Env>& env) {
+  // Only a top-level block needs a frame; any other uses its function's.
+  if (block_statement.frame_size() == 0) {
+    return evalStatements(block_statement, env);
+  }
+  return evalBlockInFrame(block_statement, env);
+}
+
+namespace {
+
+// Null for a global, or a local that is not set yet.
+const std::shared_ptr<object::Object>& lookup(ast::Address address,
+                                              const object::Env& env) {
+  static const auto kUnset = std::shared_ptr<object::Object>();
+  switch (address.kind) {
+    case ast::Address::Kind::kLocal:
+      return env.slot(address.index);
+    case ast::Address::Kind::kCapture:
+      return env.function()->captures()[address.index];
+    case ast::Address::Kind::kFrame:
+      return env.function()->frames()[address.index]->slot(address.slot);
+    default:
+      return kUnset;
+  }
+}
+
+}  // namespace
+
 std::shared_ptr<object::Object> evalIdentifier(
     const ast::Identifier& identifier, std::shared_ptr<object::Env>& env) {
-  auto value = env->get(identifier.name());
-  if (value) {
+  if (!identifier.address().global()) {
+    if (const auto& value = lookup(identifier.address(), *env)) {
+      return value;
+    }
+    for (const auto address : identifier.fallbacks()) {
+      if (const auto& value = lookup(address, *env)) {
+        return value;
+      }
+    }
+  }
+  if (auto value = env->get(identifier.symbol())) {
     return value;
   }
 
@@ -191,15 +319,231 @@ std::shared_ptr<object::Object> evalHashLiteral(
   return std::make_shared<object::Hash>(pairs);
 }
 
+namespace {
+
+Value evalUnboxed(const ast::Expression& expression,
+                  std::shared_ptr<object::Env>& env);
+
+Value evalUnboxedPrefix(const ast::PrefixExpression& prefix_expression,
+                        std::shared_ptr<object::Env>& env) {
+  auto right = evalUnboxed(*prefix_expression.right(), env);
+  if (failed(right)) {
+    return right;
+  }
+  return evalPrefixOperator(prefix_expression.op(), std::move(right));
+}
+
+using Specialization = ast::InfixExpression::Specialization;
+
+bool isString(const Value& value) {
+  return value.kind == Value::Kind::kObject &&
+         value.object->type() == object::ObjectType::kString;
+}
+
+// What an infix expression first seeing these operands is specialized to.
+Specialization specialization(lexer::TokenType op, const Value& left,
+                              const Value& right) {
+  if (left.kind == Value::Kind::kInteger &&
+      right.kind == Value::Kind::kInteger) {
+    switch (op) {
+      case lexer::TokenType::kPlus:
+        return Specialization::kIntegerAdd;
+      case lexer::TokenType::kMinus:
+        return Specialization::kIntegerSubtract;
+      case lexer::TokenType::kAsterisk:
+        return Specialization::kIntegerMultiply;
+      case lexer::TokenType::kSlash:
+        return Specialization::kIntegerDivide;
+      case lexer::TokenType::kLessThan:
+        return Specialization::kIntegerLessThan;
+      case lexer::TokenType::kGreaterThan:
+        return Specialization::kIntegerGreaterThan;
+      case lexer::TokenType::kEqual:
+        return Specialization::kIntegerEqual;
+      case lexer::TokenType::kNotEqual:
+        return Specialization::kIntegerNotEqual;
+      default:
+        return Specialization::kGeneric;
+    }
+  }
+  if (left.kind == Value::Kind::kBoolean &&
+      right.kind == Value::Kind::kBoolean) {
+    switch (op) {
+      case lexer::TokenType::kEqual:
+        return Specialization::kBooleanEqual;
+      case lexer::TokenType::kNotEqual:
+        return Specialization::kBooleanNotEqual;
+      default:
+        return Specialization::kGeneric;
+    }
+  }
+  if (op == lexer::TokenType::kPlus && isString(left) && isString(right)) {
+    return Specialization::kStringConcat;
+  }
+  return Specialization::kGeneric;
+}
+
+// What quickening_stats() reads. Counted from every thread evaluating, so
+// only the counts are atomic, and without ordering.
+struct QuickeningCounters {
+  std::array<std::atomic<size_t>, ast::InfixExpression::kSpecializations>
+      sites{};
+  std::atomic<size_t> deoptimizations = 0;
+};
+
+QuickeningCounters& quickening_counters() {
+  static QuickeningCounters counters;
+  return counters;
+}
+
+// Runs the expression as what it is specialized to, which only checks the
+// type of its operands. The first evaluation picks the specialization, and
+// a failed check makes the expression generic for good.
+Value evalSpecializedInfix(const ast::InfixExpression& infix_expression,
+                           Value left, Value right) {
+  const auto integers = left.kind == Value::Kind::kInteger &&
+                        right.kind == Value::Kind::kInteger;
+  const auto booleans = left.kind == Value::Kind::kBoolean &&
+                        right.kind == Value::Kind::kBoolean;
+  switch (infix_expression.specialization()) {
+    case Specialization::kUninitialized: {
+      const auto picked = specialization(infix_expression.op(), left, right);
+      infix_expression.specialize(picked);
+      quickening_counters().sites[static_cast<size_t>(picked)].fetch_add(
+          1, std::memory_order_relaxed);
+      return evalSpecializedInfix(infix_expression, std::move(left),
+                                  std::move(right));
+    }
+    case Specialization::kIntegerAdd:
+      if (integers) {
+        return integer(left.integer + right.integer);
+      }
+      break;
+    case Specialization::kIntegerSubtract:
+      if (integers) {
+        return integer(left.integer - right.integer);
+      }
+      break;
+    case Specialization::kIntegerMultiply:
+      if (integers) {
+        return integer(left.integer * right.integer);
+      }
+      break;
+    case Specialization::kIntegerDivide:
+      if (integers) {
+        if (right.integer == 0) {
+          return wrap(error::division_by_zero());
+        }
+        return integer(left.integer / right.integer);
+      }
+      break;
+    case Specialization::kIntegerLessThan:
+      if (integers) {
+        return boolean(left.integer < right.integer);
+      }
+      break;
+    case Specialization::kIntegerGreaterThan:
+      if (integers) {
+        return boolean(left.integer > right.integer);
+      }
+      break;
+    case Specialization::kIntegerEqual:
+      if (integers) {
+        return boolean(left.integer == right.integer);
+      }
+      break;
+    case Specialization::kIntegerNotEqual:
+      if (integers) {
+        return boolean(left.integer != right.integer);
+      }
+      break;
+    case Specialization::kBooleanEqual:
+      if (booleans) {
+        return boolean(left.boolean == right.boolean);
+      }
+      break;
+    case Specialization::kBooleanNotEqual:
+      if (booleans) {
+        return boolean(left.boolean != right.boolean);
+      }
+      break;
+    case Specialization::kStringConcat:
+      if (isString(left) && isString(right)) {
+        return wrap(std::make_shared<object::String>(
+            static_cast<const object::String&>(*left.object).value() +
+            static_cast<const object::String&>(*right.object).value()));
+      }
+      break;
+    case Specialization::kGeneric:
+      return evalInfixOperator(infix_expression.op(), std::move(left),
+                               std::move(right));
+  }
+  infix_expression.specialize(Specialization::kGeneric);
+  auto& counters = quickening_counters();
+  counters.deoptimizations.fetch_add(1, std::memory_order_relaxed);
+  counters.sites[static_cast<size_t>(Specialization::kGeneric)].fetch_add(
+      1, std::memory_order_relaxed);
+  return evalInfixOperator(infix_expression.op(), std::move(left),
+                           std::move(right));
+}
+
+Value evalUnboxedInfix(const ast::InfixExpression& infix_expression,
+                       std::shared_ptr<object::Env>& env) {
+  auto left = evalUnboxed(*infix_expression.left(), env);
+  if (failed(left)) {
+    return left;
+  }
+
+  auto right = evalUnboxed(*infix_expression.right(), env);
+  if (failed(right)) {
+    return right;
+  }
+
+  return evalSpecializedInfix(infix_expression, std::move(left),
+                              std::move(right));
+}
+
+// The node types are checked, so static_cast is as safe as dynamic_cast.
+Value evalUnboxed(const ast::Expression& expression,
+                  std::shared_ptr<object::Env>& env) {
+  switch (expression.type()) {
+    case ast::NodeType::kIntegerLiteral:
+      return integer(
+          static_cast<const ast::IntegerLiteral&>(expression).value());
+    case ast::NodeType::kBooleanLiteral:
+      return boolean(
+          static_cast<const ast::BooleanLiteral&>(expression).value());
+    case ast::NodeType::kPrefixExpression:
+      return evalUnboxedPrefix(
+          static_cast<const ast::PrefixExpression&>(expression), env);
+    case ast::NodeType::kInfixExpression:
+      return evalUnboxedInfix(
+          static_cast<const ast::InfixExpression&>(expression), env);
+    default:
+      return unbox(eval(expression, env));
+  }
+}
+
+}  // namespace
+
 std::shared_ptr<object::Object> evalPrefixExpression(
     const ast::PrefixExpression& prefix_expression,
     std::shared_ptr<object::Env>& env) {
+  if (prefix_expression.static_type() != ast::StaticType::kUnknown) {
+    return box(evalUnboxedPrefix(prefix_expression, env));
+  }
+
   auto right = eval(*prefix_expression.right(), env);
   if (right->type() == object::ObjectType::kError) {
     return right;
   }
 
-  switch (prefix_expression.op()) {
+  return evalPrefixOperator(prefix_expression.op(), right);
+}
+
+std::shared_ptr<object::Object> evalPrefixOperator(
+    lexer::TokenType op, const std::shared_ptr<object::Object>& right) {
+  switch (op) {
     case lexer::TokenType::kBang:
       switch (right->type()) {
         case object::ObjectType::kBoolean:
@@ -224,6 +568,13 @@ std::shared_ptr<object::Object> evalPrefixExpression(
 std::shared_ptr<object::Object> evalInfixExpression(
     const ast::InfixExpression& infix_expression,
     std::shared_ptr<object::Env>& env) {
+  // A site that has not failed a guard is evaluated unboxed, as one of a
+  // proven type is, so nested arithmetic boxes only its result.
+  if (infix_expression.static_type() != ast::StaticType::kUnknown ||
+      infix_expression.specialization() != Specialization::kGeneric) {
+    return box(evalUnboxedInfix(infix_expression, env));
+  }
+
   auto left = eval(*infix_expression.left(), env);
   if (left->type() == object::ObjectType::kError) {
     return left;
@@ -234,7 +585,13 @@ std::shared_ptr<object::Object> evalInfixExpression(
     return right;
   }
 
-  switch (infix_expression.op()) {
+  return evalInfixOperator(infix_expression.op(), left, right);
+}
+
+std::shared_ptr<object::Object> evalInfixOperator(
+    lexer::TokenType op, const std::shared_ptr<object::Object>& left,
+    const std::shared_ptr<object::Object>& right) {
+  switch (op) {
     case lexer::TokenType::kPlus:
       if (left->type() == object::ObjectType::kInteger &&
           right->type() == object::ObjectType::kInteger) {
@@ -301,15 +658,87 @@ std::shared_ptr<object::Object> evalInfixExpression(
   }
 }
 
+Value evalPrefixOperator(lexer::TokenType op, Value right) {
+  switch (op) {
+    case lexer::TokenType::kBang:
+      if (right.kind == Value::Kind::kBoolean) {
+        return boolean(!right.boolean);
+      }
+      if (right.kind == Value::Kind::kInteger) {
+        return boolean(false);
+      }
+      break;
+    case lexer::TokenType::kMinus:
+      if (right.kind == Value::Kind::kInteger) {
+        return integer(-right.integer);
+      }
+      break;
+    default:
+      break;
+  }
+  return unbox(evalPrefixOperator(op, box(std::move(right))));
+}
+
+Value evalInfixOperator(lexer::TokenType op, Value left, Value right) {
+  if (left.kind == Value::Kind::kInteger &&
+      right.kind == Value::Kind::kInteger) {
+    switch (op) {
+      case lexer::TokenType::kPlus:
+        return integer(left.integer + right.integer);
+      case lexer::TokenType::kMinus:
+        return integer(left.integer - right.integer);
+      case lexer::TokenType::kAsterisk:
+        return integer(left.integer * right.integer);
+      case lexer::TokenType::kSlash:
+        if (right.integer == 0) {
+          return wrap(error::division_by_zero());
+        }
+        return integer(left.integer / right.integer);
+      case lexer::TokenType::kLessThan:
+        return boolean(left.integer < right.integer);
+      case lexer::TokenType::kGreaterThan:
+        return boolean(left.integer > right.integer);
+      case lexer::TokenType::kEqual:
+        return boolean(left.integer == right.integer);
+      case lexer::TokenType::kNotEqual:
+        return boolean(left.integer != right.integer);
+      default:
+        break;
+    }
+  }
+  if (left.kind == Value::Kind::kBoolean &&
+      right.kind == Value::Kind::kBoolean) {
+    switch (op) {
+      case lexer::TokenType::kEqual:
+        return boolean(left.boolean == right.boolean);
+      case lexer::TokenType::kNotEqual:
+        return boolean(left.boolean != right.boolean);
+      default:
+        break;
+    }
+  }
+  return unbox(evalInfixOperator(op, box(std::move(left)),
+                                 box(std::move(right))));
+}
+
 std::shared_ptr<object::Object> evalIfExpression(
     const ast::IfExpression& if_expression, std::shared_ptr<object::Env>& env) {
-  auto condition = eval(*if_expression.condition(), env);
-  if (condition->type() == object::ObjectType::kError) {
-    return condition;
+  bool truthy = false;
+  if (if_expression.condition()->static_type() == ast::StaticType::kBoolean) {
+    auto condition = evalUnboxed(*if_expression.condition(), env);
+    if (failed(condition)) {
+      return box(std::move(condition));
+    }
+    truthy = condition.boolean;
+  } else {
+    auto condition = eval(*if_expression.condition(), env);
+    if (condition->type() == object::ObjectType::kError) {
+      return condition;
+    }
+    truthy = isTruthy(*condition);
   }
 
-  if (*condition != *std::make_shared<object::Boolean>(false) &&
-      *condition != *std::make_shared<object::Null>()) {
+  if (truthy) {
     return eval(*if_expression.consequence(), env);
   }
 
@@ -323,10 +752,183 @@ std::shared_ptr<object::Object> evalIfExpression(
 std::shared_ptr<object::Object> evalFunctionLiteral(
     const ast::FunctionLiteral& function_literal,
     std::shared_ptr<object::Env>& env) {
-  return std::make_shared<object::Function>(function_literal.parameters(),
-                                            function_literal.body(), env);
+  const auto* outer = env->function();
+  std::vector<std::shared_ptr<object::Object>> captures;
+  captures.reserve(function_literal.captures().size());
+  for (const auto capture : function_literal.captures()) {
+    captures.push_back(capture.source == ast::Capture::Source::kSlot
+                           ? env->slot(capture.index)
+                           : outer->captures()[capture.index]);
+  }
+  std::vector<std::shared_ptr<object::Env>> frames;
+  frames.reserve(function_literal.captured_frames().size());
+  for (const auto capture : function_literal.captured_frames()) {
+    frames.push_back(capture.source == ast::Capture::Source::kFrame
+                         ? env
+                         : outer->frames()[capture.index]);
+  }
+  // Only the global scope is kept whole.
+  const auto& globals = env->is_frame() ? env->outer() : env;
+  auto function = std::make_shared<object::Function>(
+      function_literal.parameters(), function_literal.body(),
+      function_literal.arena(), globals,
+      function_literal.frame_size(), std::move(captures), std::move(frames),
+      function_literal.pure(), function_literal.frame_escapes());
+  // Closures with captures tend to be made afresh for each use, and would
+  // each fill a cache of their own.
+  if (globals->memo_capacity() != 0 && function_literal.pure() &&
+      function_literal.captures().empty()) {
+    function->set_memo(
+        std::make_shared<object::MemoTable>(globals->memo_capacity()));
+  }
+  return function;
+}
+
+namespace {
+
+// Parameters take the first slots of the frame, in order.
+std::shared_ptr<object::Object> evalCall(
+    const object::Function& function,
+    const std::vector<std::shared_ptr<object::Object>>& args,
+    std::shared_ptr<object::Env> frame) {
+  for (size_t i = 0; i < args.size(); ++i) {
+    frame->set_slot(static_cast<uint32_t>(i), args[i]);
+  }
+  return eval(*function.body(), frame);
+}
+
+[[gnu::noinline]] std::shared_ptr<object::Object> evalEscapingCall(
+    const object::Function& function,
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  return evalCall(function, args,
+                  std::make_shared<object::Env>(
+                      function.env(), function.frame_size(), &function));
+}
+
+std::shared_ptr<object::Object> evalCall(
+    const object::Function& function,
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  std::shared_ptr<object::Object> evaluated;
+  if (function.frame_escapes()) {
+    evaluated = evalEscapingCall(function, args);
+  } else {
+    auto frame =
+        StackFrame(function.env(), function.frame_size(), &function);
+    evaluated = evalCall(function, args, frame.get());
+  }
+  if (evaluated->type() == object::ObjectType::kReturnValue) {
+    return dynamic_cast<object::ReturnValue&>(*evaluated).value();
+  }
+  return evaluated;
+}
+
+// A call in tail position is left here rather than made, see
+// ast::CallExpression::tail(), and what it yields stands in for its value.
+struct PendingCall {
+  std::shared_ptr<object::Object> function;
+  std::vector<std::shared_ptr<object::Object>> args;
+};
+
+thread_local PendingCall pending_call;
+
+const std::shared_ptr<object::Object>& tail_call() {
+  static const std::shared_ptr<object::Object> tail_call =
+      std::make_shared<object::TailCall>();
+  return tail_call;
+}
+
+// The arguments are already checked against the parameters.
+std::shared_ptr<object::Object> callFunction(
+    const object::Function& function,
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  auto* memo = function.memo();
+  uint64_t version = 0;
+  uint64_t effects = 0;
+  if (memo != nullptr) {
+    version = function.env()->version();
+    if (auto cached = memo->find(args, version)) {
+      return cached;
+    }
+    effects = object::effect_count();
+  }
+
+  // Tail calls are made here, one after the other, each once the frame of
+  // the one before has been left: recursion in tail position takes no
+  // native stack, and reuses the same frame of the frame stack.
+  auto evaluated = evalCall(function, args);
+  if (evaluated->type() == object::ObjectType::kTailCall) {
+    std::shared_ptr<object::Object> callee;
+    std::vector<std::shared_ptr<object::Object>> callee_args;
+    do {
+      callee = std::move(pending_call.function);
+      callee_args = std::move(pending_call.args);
+      evaluated =
+          evalCall(static_cast<const object::Function&>(*callee), callee_args);
+    } while (evaluated->type() == object::ObjectType::kTailCall);
+  }
+  // A call that failed or had side effects must run again next time.
+  if (memo != nullptr && evaluated->type() != object::ObjectType::kError &&
+      object::effect_count() == effects) {
+    memo->insert(args, evaluated, version);
+  }
+  return evaluated;
 }
 
+std::shared_ptr<object::Object> callBuiltin(
+    const object::Builtin& builtin,
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  if (!builtin.pure()) {
+    object::record_effect();
+  }
+  return builtin.function()(args);
+}
+
+// What a call site passing `count` arguments can call the callee as, the
+// next time it finds the same one.
+ast::CallExpression::Target target(const object::Object& callee,
+                                   size_t count) {
+  switch (callee.type()) {
+    case object::ObjectType::kFunction: {
+      const auto* function = dynamic_cast<const object::Function*>(&callee);
+      return function != nullptr && function->parameters().size() == count
+                 ? ast::CallExpression::Target::kFunction
+                 : ast::CallExpression::Target::kUnknown;
+    }
+    case object::ObjectType::kBuiltin:
+      return dynamic_cast<const object::Builtin*>(&callee) != nullptr
+                 ? ast::CallExpression::Target::kBuiltin
+                 : ast::CallExpression::Target::kUnknown;
+    default:
+      return ast::CallExpression::Target::kUnknown;
+  }
+}
+
+// Calls the callee as `target`, which it is known to be.
+std::shared_ptr<object::Object> callTarget(
+    const ast::CallExpression& call_expression,
+    ast::CallExpression::Target target,
+    std::shared_ptr<object::Object> function,
+    std::vector<std::shared_ptr<object::Object>> args) {
+  switch (target) {
+    case ast::CallExpression::Target::kFunction: {
+      const auto& callee = static_cast<const object::Function&>(*function);
+      // Memoized functions are called right away, to find their results.
+      if (call_expression.tail() && callee.memo() == nullptr) {
+        pending_call.function = std::move(function);
+        pending_call.args = std::move(args);
+        return tail_call();
+      }
+      return callFunction(callee, args);
+    }
+    case ast::CallExpression::Target::kBuiltin:
+      return callBuiltin(static_cast<const object::Builtin&>(*function), args);
+    default:
+      return applyFunction(function, args);
+  }
+}
+
+}  // namespace
+
 std::shared_ptr<object::Object> evalCallExpression(
     const ast::CallExpression& call_expression,
     std::shared_ptr<object::Env>& env) {
@@ -336,6 +938,7 @@ std::shared_ptr<object::Object> evalCallExpression(
   }
 
   std::vector<std::shared_ptr<object::Object>> args;
+  args.reserve(call_expression.arguments().size());
   for (const auto& arg : call_expression.arguments()) {
     auto evaluated = eval(*arg, env);
     if (evaluated->type() == object::ObjectType::kError) {
@@ -344,35 +947,81 @@ std::shared_ptr<object::Object> evalCallExpression(
     args.push_back(evaluated);
   }
 
+  // Owners are compared by control block, which the cache keeps from being
+  // reused even once the callee is gone, so no other object can pass for it.
+  auto cache = call_expression.cache();
+  if (cache == nullptr || cache->callee.owner_before(function) ||
+      function.owner_before(cache->callee)) {
+    cache = std::make_shared<const ast::CallExpression::InlineCache>(
+        ast::CallExpression::InlineCache{
+            .callee = function, .target = target(*function, args.size())});
+    call_expression.set_cache(cache);
+  }
+  const auto found = cache->target;
+  return callTarget(call_expression, found, std::move(function),
+                    std::move(args));
+}
+
+std::shared_ptr<object::Object> applyFunction(
+    const std::shared_ptr<object::Object>& function,
+    const std::vector<std::shared_ptr<object::Object>>& args) {
   switch (function->type()) {
     case object::ObjectType::kFunction: {
-      auto function_object = dynamic_cast<object::Function&>(*function);
+      if (const auto* flat_function =
+              dynamic_cast<const object::FlatFunction*>(function.get())) {
+        return applyFlatFunction(*flat_function, args);
+      }
+      const auto& function_object =
+          dynamic_cast<const object::Function&>(*function);
       if (args.size() != function_object.parameters().size()) {
         return error::wrong_number_of_arguments(
             function_object.to_string(), function_object.parameters().size(),
             args.size());
       }
-      auto subenv = std::make_shared<object::Env>(function_object.env());
-      for (size_t i = 0; i < args.size(); ++i) {
-        subenv->set(function_object.parameters()[i]->name(), args[i]);
-      }
-
-      auto evaluated = eval(*function_object.body(), subenv);
-      if (evaluated->type() == object::ObjectType::kReturnValue) {
-        return dynamic_cast<object::ReturnValue&>(*evaluated).value();
-      }
-      return evaluated;
-    }
-    case object::ObjectType::kBuiltin: {
-      auto builtin = dynamic_cast<object::Builtin&>(*function);
-      return builtin.function()(args);
+      return callFunction(function_object, args);
     }
+    case object::ObjectType::kBuiltin:
+      return callBuiltin(dynamic_cast<const object::Builtin&>(*function),
+                         args);
     default:
       return error::wrong_argument_type("call", object::ObjectType::kFunction,
                                         function->type());
   }
 }
 
+QuickeningStats quickening_stats() {
+  const auto& counters = quickening_counters();
+  QuickeningStats stats;
+  for (size_t i = 0; i < stats.sites.size(); ++i) {
+    stats.sites[i] = counters.sites[i].load(std::memory_order_relaxed);
+  }
+  stats.deoptimizations =
+      counters.deoptimizations.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool isTruthy(const object::Object& condition) {
+  switch (condition.type()) {
+    case object::ObjectType::kBoolean:
+      return dynamic_cast<const object::Boolean&>(condition).value();
+    case object::ObjectType::kNull:
+      return false;
+    default:
+      return true;
+  }
+}
+
+bool isTruthy(const Value& condition) {
+  switch (condition.kind) {
+    case Value::Kind::kBoolean:
+      return condition.boolean;
+    case Value::Kind::kInteger:
+      return true;
+    default:
+      return isTruthy(*condition.object);
+  }
+}
+
 std::shared_ptr<object::Object> evalIndexExpression(
     const ast::IndexExpression& index_expression,
     std::shared_ptr<object::Env>& env) {
@@ -386,6 +1035,55 @@ std::shared_ptr<object::Object> evalIndexExpression(
     return index;
   }
 
+  // The receiver found last is checked for first, along with an index of
+  // the type it takes; anything else goes the generic way and is expected
+  // from then on.
+  switch (index_expression.receiver()) {
+    case ast::IndexExpression::Receiver::kArray:
+      if (left->type() == object::ObjectType::kArray &&
+          index->type() == object::ObjectType::kInteger) {
+        const auto& elements =
+            static_cast<const object::Array&>(*left).elements();
+        const auto i = static_cast<const object::Integer&>(*index).value();
+        if (i < 0 || static_cast<size_t>(i) >= elements.size()) {
+          return std::make_shared<object::Null>();
+        }
+        return elements[static_cast<size_t>(i)];
+      }
+      break;
+    case ast::IndexExpression::Receiver::kHash:
+      if (left->type() == object::ObjectType::kHash &&
+          (index->type() == object::ObjectType::kBoolean ||
+           index->type() == object::ObjectType::kInteger ||
+           index->type() == object::ObjectType::kString)) {
+        const auto& pairs = static_cast<const object::Hash&>(*left).pairs();
+        const auto it = pairs.find(index);
+        if (it == pairs.end()) {
+          return std::make_shared<object::Null>();
+        }
+        return it->second;
+      }
+      break;
+    default:
+      break;
+  }
+  switch (left->type()) {
+    case object::ObjectType::kArray:
+      index_expression.expect(ast::IndexExpression::Receiver::kArray);
+      break;
+    case object::ObjectType::kHash:
+      index_expression.expect(ast::IndexExpression::Receiver::kHash);
+      break;
+    default:
+      index_expression.expect(ast::IndexExpression::Receiver::kUnknown);
+      break;
+  }
+  return evalIndexOperator(left, index);
+}
+
+std::shared_ptr<object::Object> evalIndexOperator(
+    const std::shared_ptr<object::Object>& left,
+    const std::shared_ptr<object::Object>& index) {
   switch (left->type()) {
     case object::ObjectType::kArray: {
       auto& array = dynamic_cast<object::Array&>(*left);
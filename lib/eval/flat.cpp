@@ -0,0 +1,214 @@
+#include <monkey/ast/ast.h>
+#include <monkey/ast/flat.h>
+#include <monkey/eval/builtin.h>
+#include <monkey/eval/eval.h>
+#include <monkey/eval/flat.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace monkey::eval {
+
+namespace {
+
+bool is_error(const std::shared_ptr<object::Object>& value) {
+  return value->type() == object::ObjectType::kError;
+}
+
+// Evaluates the statements of a block or program, stopping at the first
+// return value or error.
+std::shared_ptr<object::Object> evalFlatStatements(
+    const std::shared_ptr<const ast::FlatProgram>& program,
+    std::span<const ast::NodeIndex> statements,
+    std::shared_ptr<object::Env>& env) {
+  std::shared_ptr<object::Object> result;
+  for (const auto statement : statements) {
+    result = evalFlatNode(program, statement, env);
+
+    if (result->type() == object::ObjectType::kReturnValue ||
+        result->type() == object::ObjectType::kError) {
+      return result;
+    }
+  }
+
+  return result;
+}
+
+// Evaluates a range of expressions into `values`, returning the first error.
+std::shared_ptr<object::Object> evalFlatExpressions(
+    const std::shared_ptr<const ast::FlatProgram>& program,
+    std::span<const ast::NodeIndex> expressions,
+    std::shared_ptr<object::Env>& env,
+    std::vector<std::shared_ptr<object::Object>>& values) {
+  values.reserve(expressions.size());
+  for (const auto expression : expressions) {
+    auto evaluated = evalFlatNode(program, expression, env);
+    if (is_error(evaluated)) {
+      return evaluated;
+    }
+    values.push_back(std::move(evaluated));
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+std::shared_ptr<object::Object> evalFlatProgram(
+    const std::shared_ptr<const ast::FlatProgram>& program,
+    std::shared_ptr<object::Env>& env) {
+  auto result = evalFlatStatements(program, program->statements(), env);
+  if (result != nullptr &&
+      result->type() == object::ObjectType::kReturnValue) {
+    return dynamic_cast<object::ReturnValue&>(*result).value();
+  }
+  return result;
+}
+
+std::shared_ptr<object::Object> evalFlatNode(
+    const std::shared_ptr<const ast::FlatProgram>& program,
+    ast::NodeIndex index, std::shared_ptr<object::Env>& env) {
+  const auto& node = program->node(index);
+  switch (node.type) {
+    case ast::NodeType::kLetStatement: {
+      auto value = evalFlatNode(program, node.b, env);
+      if (is_error(value)) {
+        return value;
+      }
+      env->set(program->symbol(node.a), value);
+      return value;
+    }
+    case ast::NodeType::kReturnStatement: {
+      auto value = evalFlatNode(program, node.a, env);
+      if (is_error(value)) {
+        return value;
+      }
+      return std::make_shared<object::ReturnValue>(value);
+    }
+    case ast::NodeType::kExpressionStatement:
+      return evalFlatNode(program, node.a, env);
+    case ast::NodeType::kBlockStatement: {
+      auto subenv = std::make_shared<object::Env>(env);
+      return evalFlatStatements(program, program->children(node.a, node.b),
+                                subenv);
+    }
+    case ast::NodeType::kIdentifier: {
+      auto value = env->get(program->symbol(node.a));
+      if (value) {
+        return value;
+      }
+      return error::unknown_identifier(program->name(node.a));
+    }
+    case ast::NodeType::kIntegerLiteral:
+      return std::make_shared<object::Integer>(program->integer(node.a));
+    case ast::NodeType::kBooleanLiteral:
+      return std::make_shared<object::Boolean>(node.a != 0);
+    case ast::NodeType::kStringLiteral:
+      return std::make_shared<object::String>(program->string(node.a));
+    case ast::NodeType::kArrayLiteral: {
+      std::vector<std::shared_ptr<object::Object>> elements;
+      if (auto failure = evalFlatExpressions(
+              program, program->children(node.a, node.b), env, elements)) {
+        return failure;
+      }
+      return std::make_shared<object::Array>(std::move(elements));
+    }
+    case ast::NodeType::kHashLiteral: {
+      std::vector<std::shared_ptr<object::Object>> entries;
+      if (auto failure = evalFlatExpressions(
+              program, program->children(node.a, node.b), env, entries)) {
+        return failure;
+      }
+      object::Hash::HashType pairs;
+      for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+        pairs.insert({entries[i], entries[i + 1]});
+      }
+      return std::make_shared<object::Hash>(std::move(pairs));
+    }
+    case ast::NodeType::kFunctionLiteral:
+      return std::make_shared<object::FlatFunction>(program, index, env);
+    case ast::NodeType::kPrefixExpression: {
+      auto right = evalFlatNode(program, node.a, env);
+      if (is_error(right)) {
+        return right;
+      }
+      return evalPrefixOperator(node.op, right);
+    }
+    case ast::NodeType::kInfixExpression: {
+      auto left = evalFlatNode(program, node.a, env);
+      if (is_error(left)) {
+        return left;
+      }
+      auto right = evalFlatNode(program, node.b, env);
+      if (is_error(right)) {
+        return right;
+      }
+      return evalInfixOperator(node.op, left, right);
+    }
+    case ast::NodeType::kIfExpression: {
+      auto condition = evalFlatNode(program, node.a, env);
+      if (is_error(condition)) {
+        return condition;
+      }
+      if (isTruthy(*condition)) {
+        return evalFlatNode(program, node.b, env);
+      }
+      if (node.c != ast::kNoNode) {
+        return evalFlatNode(program, node.c, env);
+      }
+      return std::make_shared<object::Null>();
+    }
+    case ast::NodeType::kCallExpression: {
+      auto function = evalFlatNode(program, node.a, env);
+      if (is_error(function)) {
+        return function;
+      }
+      std::vector<std::shared_ptr<object::Object>> args;
+      if (auto failure = evalFlatExpressions(
+              program, program->children(node.b, node.c), env, args)) {
+        return failure;
+      }
+      return applyFunction(function, args);
+    }
+    case ast::NodeType::kIndexExpression: {
+      auto left = evalFlatNode(program, node.a, env);
+      if (is_error(left)) {
+        return left;
+      }
+      auto index_value = evalFlatNode(program, node.b, env);
+      if (is_error(index_value)) {
+        return index_value;
+      }
+      return evalIndexOperator(left, index_value);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+std::shared_ptr<object::Object> applyFlatFunction(
+    const object::FlatFunction& function,
+    const std::vector<std::shared_ptr<object::Object>>& args) {
+  const auto& program = function.program();
+  const auto parameters = function.parameters();
+  if (args.size() != parameters.size()) {
+    return error::wrong_number_of_arguments(function.to_string(),
+                                            parameters.size(), args.size());
+  }
+  auto subenv = std::make_shared<object::Env>(function.env());
+  for (size_t i = 0; i < args.size(); ++i) {
+    subenv->set(program->symbol(program->node(parameters[i]).a), args[i]);
+  }
+
+  auto evaluated = evalFlatNode(program, function.body(), subenv);
+  if (evaluated->type() == object::ObjectType::kReturnValue) {
+    return dynamic_cast<object::ReturnValue&>(*evaluated).value();
+  }
+  return evaluated;
+}
+
+}  // namespace monkey::eval
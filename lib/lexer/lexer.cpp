@@ -1,36 +1,239 @@
 #include <monkey/lexer/lexer.h>
+#include <monkey/lexer/source.h>
 #include <monkey/lexer/token.h>
 
-#include <cctype>
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MONKEY_LEXER_SIMD 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define MONKEY_LEXER_SIMD 1
+#endif
 
 namespace monkey::lexer {
 
-Lexer::Lexer(std::string input) : input_(std::move(input)) {}
+namespace {
 
-Lexer::Iterator Lexer::begin() const {
-  return Iterator(input_.begin(), input_.end());
+enum CharClass : uint8_t {
+  kWhitespace = 1U << 0U,
+  kLetter = 1U << 1U,
+  kDigit = 1U << 2U,
+  kIdentifierPart = 1U << 3U,
+};
+
+constexpr std::array<uint8_t, 256> kCharClasses = [] {
+  std::array<uint8_t, 256> classes{};
+  for (const char ch : {' ', '\t', '\n', '\r'}) {
+    classes[static_cast<unsigned char>(ch)] |= kWhitespace;
+  }
+  for (unsigned char ch = 'a'; ch <= 'z'; ++ch) {
+    classes[ch] |= kLetter | kIdentifierPart;
+    classes[ch - 'a' + 'A'] |= kLetter | kIdentifierPart;
+  }
+  for (unsigned char ch = '0'; ch <= '9'; ++ch) {
+    classes[ch] |= kDigit;
+  }
+  classes['_'] |= kIdentifierPart;
+  return classes;
+}();
+
+constexpr bool has_class(char ch, uint8_t char_class) {
+  return (kCharClasses[static_cast<unsigned char>(ch)] & char_class) != 0;
 }
 
-Lexer::Iterator Lexer::end() const {
-  return Iterator(input_.end(), input_.end());
+// Keywords are resolved with a perfect hash over the first two characters
+// and the length; the static_assert below rejects any keyword set for which
+// it stops being collision free.
+constexpr size_t kKeywordTableSize = 16;
+
+constexpr size_t keyword_hash(std::string_view word) {
+  return (static_cast<unsigned char>(word[0]) +
+          static_cast<unsigned char>(word[1]) + word.size()) %
+         kKeywordTableSize;
+}
+
+constexpr std::array<Keyword, kKeywordTableSize> kKeywordTable = [] {
+  std::array<Keyword, kKeywordTableSize> table{};
+  for (const auto& keyword : kKeywords) {
+    table[keyword_hash(keyword.word)] = keyword;
+  }
+  return table;
+}();
+
+static_assert(std::ranges::all_of(kKeywords,
+                                  [](const Keyword& keyword) {
+                                    return kKeywordTable[keyword_hash(
+                                                             keyword.word)]
+                                               .word == keyword.word;
+                                  }),
+              "keyword hash has collisions");
+
+constexpr auto kKeywordMinLength =
+    std::ranges::min(kKeywords, {}, [](const Keyword& keyword) {
+      return keyword.word.size();
+    }).word.size();
+constexpr auto kKeywordMaxLength =
+    std::ranges::max(kKeywords, {}, [](const Keyword& keyword) {
+      return keyword.word.size();
+    }).word.size();
+
+static_assert(kKeywordMinLength >= 2, "keyword hash reads two characters");
+
+TokenType lookup_identifier(std::string_view word) {
+  if (word.size() < kKeywordMinLength || word.size() > kKeywordMaxLength) {
+    return TokenType::kIdentifer;
+  }
+  const auto& keyword = kKeywordTable[keyword_hash(word)];
+  return keyword.word == word ? keyword.type : TokenType::kIdentifer;
+}
+
+#if defined(MONKEY_LEXER_SIMD)
+
+#if defined(__AVX2__)
+using Block = __m256i;
+constexpr uint32_t kBlockMask = 0xFFFFFFFFU;
+
+Block load(const char* location) {
+  return _mm256_loadu_si256(reinterpret_cast<const Block*>(location));
+}
+Block splat(int ch) { return _mm256_set1_epi8(static_cast<char>(ch)); }
+Block equal(Block lhs, Block rhs) { return _mm256_cmpeq_epi8(lhs, rhs); }
+Block less(Block lhs, Block rhs) { return _mm256_cmpgt_epi8(rhs, lhs); }
+Block add(Block lhs, Block rhs) { return _mm256_add_epi8(lhs, rhs); }
+Block either(Block lhs, Block rhs) { return _mm256_or_si256(lhs, rhs); }
+uint32_t to_mask(Block block) {
+  return static_cast<uint32_t>(_mm256_movemask_epi8(block));
+}
+#else
+using Block = __m128i;
+constexpr uint32_t kBlockMask = 0xFFFFU;
+
+Block load(const char* location) {
+  return _mm_loadu_si128(reinterpret_cast<const Block*>(location));
+}
+Block splat(int ch) { return _mm_set1_epi8(static_cast<char>(ch)); }
+Block equal(Block lhs, Block rhs) { return _mm_cmpeq_epi8(lhs, rhs); }
+Block less(Block lhs, Block rhs) { return _mm_cmplt_epi8(lhs, rhs); }
+Block add(Block lhs, Block rhs) { return _mm_add_epi8(lhs, rhs); }
+Block either(Block lhs, Block rhs) { return _mm_or_si128(lhs, rhs); }
+uint32_t to_mask(Block block) {
+  return static_cast<uint32_t>(_mm_movemask_epi8(block));
+}
+#endif
+
+constexpr size_t kBlockSize = sizeof(Block);
+
+// SSE2/AVX2 only offer signed byte comparisons, so shift [low, low + count)
+// onto [-128, -128 + count) before comparing.
+Block in_range(Block block, int low, int count) {
+  return less(add(block, splat(128 - low)), splat(-128 + count));
+}
+
+Block match_whitespace(Block block) {
+  return either(either(equal(block, splat(' ')), equal(block, splat('\t'))),
+                either(equal(block, splat('\n')), equal(block, splat('\r'))));
+}
+
+Block match_identifier_part(Block block) {
+  return either(in_range(either(block, splat(0x20)), 'a', 26),
+                equal(block, splat('_')));
+}
+
+Block match_digit(Block block) { return in_range(block, '0', 10); }
+
+Block match_string_body(Block block) {
+  // Every byte except the closing quote belongs to the string body.
+  return equal(equal(block, splat('"')), splat(0));
+}
+
+#endif
+
+// Advances from location while the character class matches, a block at a time
+// where SIMD is available and byte by byte for the tail.
+template <typename BlockMatcher, typename CharMatcher>
+const char* scan_while(const char* location, const char* end,
+                       [[maybe_unused]] BlockMatcher block_matcher,
+                       CharMatcher char_matcher) {
+#if defined(MONKEY_LEXER_SIMD)
+  while (static_cast<size_t>(end - location) >= kBlockSize) {
+    const auto stop = ~to_mask(block_matcher(load(location))) & kBlockMask;
+    if (stop != 0) {
+      return location + std::countr_zero(stop);
+    }
+    location += kBlockSize;
+  }
+#endif
+  while (location != end && char_matcher(*location)) {
+    ++location;
+  }
+  return location;
 }
 
-Lexer::Iterator Lexer::cbegin() const {
-  return Iterator(input_.begin(), input_.end());
+#if !defined(MONKEY_LEXER_SIMD)
+constexpr auto match_whitespace = nullptr;
+constexpr auto match_identifier_part = nullptr;
+constexpr auto match_digit = nullptr;
+constexpr auto match_string_body = nullptr;
+#endif
+
+}  // namespace
+
+Lexer::Lexer(std::string input)
+    : Lexer(std::make_shared<StringSource>(std::move(input))) {}
+
+Lexer::Lexer(std::shared_ptr<const Source> source)
+    : source_(std::move(source)),
+      input_(source_->text()),
+      base_(source_->offset()) {}
+
+Lexer::Iterator Lexer::begin() const {
+  return Iterator(input_.data(), input_.data() + input_.size(), base_);
 }
 
-Lexer::Iterator Lexer::cend() const {
-  return Iterator(input_.end(), input_.end());
+Lexer::Iterator Lexer::end() const {
+  return Iterator(input_.data() + input_.size(),
+                  input_.data() + input_.size());
 }
 
-Lexer::Iterator::Iterator(std::string::const_iterator start_location,
-                          std::string::const_iterator end_location)
-    : impl_(std::make_unique<IteratorImpl>(start_location, end_location)) {}
+Lexer::Iterator Lexer::cbegin() const { return begin(); }
+
+Lexer::Iterator Lexer::cend() const { return end(); }
+
+std::vector<Token> Lexer::tokenize() const {
+  // Typical code runs to about four bytes per token, so most buffers are
+  // never regrown. Large inputs only reserve up to a cap of a million tokens
+  // and grow past it as needed, so that a big mapped file does not claim
+  // address space many times its size up front.
+  constexpr size_t kMaxReservedTokens = size_t{1} << 20;
+  std::vector<Token> tokens;
+  tokens.reserve(std::min(input_.size() / 4 + 1, kMaxReservedTokens));
+  auto impl = Iterator::IteratorImpl(input_.data(),
+                                     input_.data() + input_.size(), base_);
+  while (true) {
+    tokens.push_back(impl.next_token());
+    if (tokens.back().type() == TokenType::kEOF) {
+      break;
+    }
+  }
+  return tokens;
+}
+
+Lexer::Iterator::Iterator(const char *start_location,
+                          const char *end_location, size_t base)
+    : impl_(std::make_unique<IteratorImpl>(start_location, end_location,
+                                           base)) {}
 
 Lexer::Iterator::Iterator(const Iterator &other)
     : impl_(std::make_unique<IteratorImpl>(*other.impl_)) {}
@@ -68,18 +271,16 @@ Token Lexer::Iterator::operator*() const {
 
 Token Lexer::Iterator::operator->() const { return **this; }
 
-Lexer::Iterator::IteratorImpl::IteratorImpl(
-    std::string::const_iterator start_location,
-    std::string::const_iterator end_location)
+Lexer::Iterator::IteratorImpl::IteratorImpl(const char *start_location,
+                                            const char *end_location,
+                                            size_t base)
     : current_location_(start_location),
-      peek_location_(start_location),
-      end_location_(end_location) {
-  read_char();
-}
+      end_location_(end_location),
+      start_location_(start_location),
+      base_(base) {}
 
 bool Lexer::Iterator::IteratorImpl::operator==(const IteratorImpl &rhs) const {
   return current_location_ == rhs.current_location_ &&
-         peek_location_ == rhs.peek_location_ &&
          end_location_ == rhs.end_location_;
 }
 
@@ -88,65 +289,54 @@ bool Lexer::Iterator::IteratorImpl::operator!=(const IteratorImpl &rhs) const {
 }
 
 Token Lexer::Iterator::IteratorImpl::next_token() {
-  auto token = Token(TokenType::kIllegal, std::string());
   skip_whitespace();
+  const auto *start = current_location_;
+  const auto at = offset(start);
+  if (current_location_ == end_location_) {
+    return Token(TokenType::kEOF, "", at);
+  }
+
   const char ch = current_char();
-  switch (ch) {
-    case '+':
-    case '-':
-    case '*':
-    case '/':
-    case '<':
-    case '>':
-    case ',':
-    case ';':
-    case ':':
-    case '(':
-    case ')':
-    case '{':
-    case '}':
-    case '[':
-    case ']':
-    case '\0':
-      token = Token(kSingleCharTokens.at(ch), std::string(1, ch));
-      break;
+  if (has_class(ch, kLetter)) {
+    auto identifier = read_identifier();
+    return Token(lookup_identifier(identifier), identifier, at);
+  }
+  if (has_class(ch, kDigit)) {
+    return Token(TokenType::kInteger, read_integer(), at);
+  }
 
+  auto type = kSingleCharTokens[static_cast<unsigned char>(ch)];
+  switch (ch) {
     case '=':
       if (peek_char() == '=') {
         read_char();
-        token = Token(TokenType::kEqual, "==");
-      } else {
-        token = Token(TokenType::kAssign, "=");
+        type = TokenType::kEqual;
       }
       break;
 
     case '!':
       if (peek_char() == '=') {
         read_char();
-        token = Token(TokenType::kNotEqual, "!=");
-      } else {
-        token = Token(TokenType::kBang, "!");
+        type = TokenType::kNotEqual;
       }
       break;
 
-    case '"':
-      token = Token(TokenType::kString, read_string());
-      break;
+    case '"': {
+      auto literal = read_string();
+      read_char();
+      return Token(TokenType::kString, literal, at);
+    }
 
     default:
-      if (std::isalpha(ch)) {
-        auto identifier = read_identifier();
-        if (kKeywords.find(identifier) != kKeywords.end()) {
-          const auto keyword = kKeywords.at(identifier);
-          return Token(keyword, std::move(identifier));
-        }
-        return Token(TokenType::kIdentifer, std::move(identifier));
-      } else if (std::isdigit(ch)) {
-        return Token(TokenType::kInteger, read_integer());
-      }
+      break;
   }
   read_char();
-  return token;
+  return Token(type, slice(start), at);
+}
+
+uint32_t Lexer::Iterator::IteratorImpl::offset(const char *location) const {
+  return static_cast<uint32_t>(std::min<size_t>(
+      base_ + static_cast<size_t>(location - start_location_), kMaxOffset));
 }
 
 char Lexer::Iterator::IteratorImpl::current_char() const {
@@ -157,52 +347,53 @@ char Lexer::Iterator::IteratorImpl::current_char() const {
 }
 
 char Lexer::Iterator::IteratorImpl::peek_char() const {
-  if (peek_location_ == end_location_) {
+  if (end_location_ - current_location_ < 2) {
     return '\0';
   }
-  return *peek_location_;
+  return current_location_[1];
 }
 
 void Lexer::Iterator::IteratorImpl::read_char() {
-  current_location_ = peek_location_;
-  if (peek_location_ != end_location_) {
-    ++peek_location_;
+  if (current_location_ != end_location_) {
+    ++current_location_;
   }
 }
 
 void Lexer::Iterator::IteratorImpl::skip_whitespace() {
-  while (current_char() == ' ' || current_char() == '\t' ||
-         current_char() == '\n' || current_char() == '\r') {
-    read_char();
-  }
+  current_location_ =
+      scan_while(current_location_, end_location_, match_whitespace,
+                 [](char ch) { return has_class(ch, kWhitespace); });
 }
 
-std::string Lexer::Iterator::IteratorImpl::read_identifier() {
-  const auto start = current_location_;
-  while (std::isalpha(current_char()) || current_char() == '_') {
-    read_char();
-  }
-  return std::string(
-      &*start, static_cast<size_t>(std::distance(start, current_location_)));
+std::string_view Lexer::Iterator::IteratorImpl::slice(
+    const char *start) const {
+  return std::string_view(
+      start, static_cast<size_t>(std::distance(start, current_location_)));
 }
 
-std::string Lexer::Iterator::IteratorImpl::read_integer() {
-  const auto start = current_location_;
-  while (std::isdigit(current_char())) {
-    read_char();
-  }
-  return std::string(
-      &*start, static_cast<size_t>(std::distance(start, current_location_)));
+std::string_view Lexer::Iterator::IteratorImpl::read_identifier() {
+  const auto *start = current_location_;
+  current_location_ =
+      scan_while(current_location_, end_location_, match_identifier_part,
+                 [](char ch) { return has_class(ch, kIdentifierPart); });
+  return slice(start);
+}
+
+std::string_view Lexer::Iterator::IteratorImpl::read_integer() {
+  const auto *start = current_location_;
+  current_location_ =
+      scan_while(current_location_, end_location_, match_digit,
+                 [](char ch) { return has_class(ch, kDigit); });
+  return slice(start);
 }
 
-std::string Lexer::Iterator::IteratorImpl::read_string() {
+std::string_view Lexer::Iterator::IteratorImpl::read_string() {
   read_char();
-  const auto start = current_location_;
-  while (current_char() != '"') {
-    read_char();
-  }
-  return std::string(
-      &*start, static_cast<size_t>(std::distance(start, current_location_)));
+  const auto *start = current_location_;
+  current_location_ =
+      scan_while(current_location_, end_location_, match_string_body,
+                 [](char ch) { return ch != '"'; });
+  return slice(start);
 }
 
 }  // namespace monkey::lexer
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <monkey/lexer/location.h>
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/token.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace monkey::lexer {
+
+LineTable::LineTable(std::shared_ptr<const Source> source)
+    : source_(std::move(source)) {}
+
+Location LineTable::locate(uint32_t offset) const {
+  std::call_once(built_, [this] { build(); });
+  const auto text = source_->text();
+  const auto base = source_->offset();
+  const auto position = static_cast<uint32_t>(
+      std::min(offset > base ? offset - base : 0, text.size()));
+  // The last line starting at or before the position.
+  const auto line =
+      std::ranges::upper_bound(line_starts_, position) - line_starts_.begin();
+  return {static_cast<uint32_t>(line),
+          position - line_starts_[static_cast<size_t>(line - 1)] + 1};
+}
+
+size_t LineTable::line_count() const {
+  std::call_once(built_, [this] { build(); });
+  return line_starts_.size();
+}
+
+void LineTable::build() const {
+  const auto text = source_->text();
+  line_starts_.push_back(0);
+  const auto* const begin = text.data();
+  const auto* const end = begin + text.size();
+  for (const auto* at = begin; at != end; ++at) {
+    at = static_cast<const char*>(
+        std::memchr(at, '\n', static_cast<size_t>(end - at)));
+    if (at == nullptr) {
+      break;
+    }
+    line_starts_.push_back(static_cast<uint32_t>(
+        std::min<size_t>(static_cast<size_t>(at - begin) + 1, kMaxOffset)));
+  }
+}
+
+}  // namespace monkey::lexer
@@ -0,0 +1,93 @@
+#include <fmt/core.h>
+#include <monkey/lexer/source.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MONKEY_LEXER_MMAP 1
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace monkey::lexer {
+
+SourceError::SourceError(std::string message)
+    : message_(fmt::format("SourceError: {}", std::move(message))) {}
+
+StringSource::StringSource(std::string text, size_t offset)
+    : text_(std::move(text)), offset_(offset) {}
+
+SourceSlice::SourceSlice(std::shared_ptr<const Source> parent,
+                         std::string_view text)
+    : parent_(std::move(parent)),
+      text_(text),
+      offset_(parent_->offset() +
+              static_cast<size_t>(text.data() - parent_->text().data())) {}
+
+#if defined(MONKEY_LEXER_MMAP)
+
+MappedFileSource::MappedFileSource(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw SourceError(
+        fmt::format("could not open {}: {}", path, std::strerror(errno)));
+  }
+
+  struct stat status {};
+  if (::fstat(fd, &status) != 0) {
+    const int error = errno;
+    ::close(fd);
+    throw SourceError(
+        fmt::format("could not stat {}: {}", path, std::strerror(error)));
+  }
+
+  size_ = static_cast<size_t>(status.st_size);
+  if (size_ != 0) {
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      const int error = errno;
+      ::close(fd);
+      throw SourceError(
+          fmt::format("could not map {}: {}", path, std::strerror(error)));
+    }
+    ::madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(data);
+  }
+  ::close(fd);
+}
+
+MappedFileSource::~MappedFileSource() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+#else
+
+MappedFileSource::MappedFileSource(const std::string& path) {
+  auto file = std::ifstream(path, std::ios::binary);
+  if (!file) {
+    throw SourceError(fmt::format("could not open {}", path));
+  }
+  fallback_.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  data_ = fallback_.data();
+  size_ = fallback_.size();
+}
+
+MappedFileSource::~MappedFileSource() = default;
+
+#endif
+
+}  // namespace monkey::lexer
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include <monkey/lexer/lexer.h>
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/stream.h>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace monkey::lexer {
+
+size_t StatementScanner::scan(std::string_view text) {
+  size_t boundary = 0;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (step(text[i])) {
+      boundary = i + 1;
+    }
+  }
+  return boundary;
+}
+
+size_t StatementScanner::scan_one(std::string_view text) {
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (step(text[i])) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+bool StatementScanner::step(char ch) {
+  if (in_string_) {
+    in_string_ = ch != '"';
+    return false;
+  }
+  switch (ch) {
+    case '"':
+      in_string_ = true;
+      return false;
+    case '(':
+    case '{':
+    case '[':
+      ++depth_;
+      return false;
+    case ')':
+    case '}':
+    case ']':
+      // Unbalanced closers are a parse error; do not let them wedge the
+      // scanner below the top level.
+      if (depth_ != 0) {
+        --depth_;
+      }
+      return false;
+    case ';':
+      return depth_ == 0;
+    default:
+      return false;
+  }
+}
+
+void ChunkedLexer::feed(std::string_view chunk) {
+  const auto offset = pending_.size();
+  pending_.append(chunk);
+  const auto boundary =
+      scanner_.scan(std::string_view(pending_).substr(offset));
+  if (boundary != 0) {
+    emit(offset + boundary);
+  }
+}
+
+void ChunkedLexer::finish() {
+  if (!pending_.empty()) {
+    emit(pending_.size());
+  }
+  scanner_ = StatementScanner();
+}
+
+std::optional<TokenBatch> ChunkedLexer::next_batch() {
+  if (batches_.empty()) {
+    return std::nullopt;
+  }
+  auto batch = std::move(batches_.front());
+  batches_.pop_front();
+  return batch;
+}
+
+void ChunkedLexer::emit(size_t length) {
+  auto lexer = Lexer(
+      std::make_shared<StringSource>(pending_.substr(0, length), consumed_));
+  pending_.erase(0, length);
+  consumed_ += length;
+  batches_.push_back(TokenBatch{lexer.source(), lexer.tokenize()});
+}
+
+StatementSplitter::StatementSplitter(std::string_view text, size_t chunk_size)
+    : text_(text), chunk_size_(chunk_size) {}
+
+std::optional<std::string_view> StatementSplitter::next() {
+  if (start_ >= text_.size()) {
+    return std::nullopt;
+  }
+
+  auto end = text_.size();
+  while (scanned_ < text_.size()) {
+    const auto window = text_.substr(scanned_, chunk_size_);
+    const auto boundary = scanner_.scan(window);
+    scanned_ += window.size();
+    if (boundary != 0) {
+      end = scanned_ - window.size() + boundary;
+      break;
+    }
+  }
+
+  const auto chunk = text_.substr(start_, end - start_);
+  start_ = end;
+  return chunk;
+}
+
+BatchedLexer::BatchedLexer(std::shared_ptr<const Source> source,
+                           size_t batch_size)
+    : source_(std::move(source)), splitter_(source_->text(), batch_size) {}
+
+std::optional<TokenBatch> BatchedLexer::next_batch() {
+  const auto text = splitter_.next();
+  if (!text) {
+    return std::nullopt;
+  }
+
+  auto lexer = Lexer(std::make_shared<SourceSlice>(source_, *text));
+  return TokenBatch{lexer.source(), lexer.tokenize()};
+}
+
+}  // namespace monkey::lexer
\ No newline at end of file
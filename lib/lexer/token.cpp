@@ -2,7 +2,7 @@
 #include <monkey/lexer/token.h>
 
 #include <string>
-#include <utility>
+#include <string_view>
 
 namespace monkey::lexer {
 
@@ -105,8 +105,8 @@ std::string to_operator(TokenType type) {
   }
 }
 
-Token::Token(TokenType type, std::string literal)
-    : type_(type), literal_(std::move(literal)) {}
+Token::Token(TokenType type, std::string_view literal, uint32_t offset)
+    : type_(type), offset_(offset), literal_(literal) {}
 
 bool Token::operator==(const Token &rhs) const {
   return type_ == rhs.type_ && literal_ == rhs.literal_;
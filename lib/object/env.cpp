@@ -1,9 +1,11 @@
+#include <monkey/ast/symbol.h>
 #include <monkey/eval/builtin.h>
 #include <monkey/object/env.h>
 #include <monkey/object/object.h>
 
+#include <cstddef>
 #include <memory>
-#include <string>
+#include <string_view>
 #include <utility>
 
 namespace monkey::object {
@@ -14,24 +16,55 @@ Env::Env() : outer_(nullptr) {
   set("last", std::make_shared<Builtin>(eval::builtin::last));
   set("rest", std::make_shared<Builtin>(eval::builtin::rest));
   set("push", std::make_shared<Builtin>(eval::builtin::push));
-  set("puts", std::make_shared<Builtin>(eval::builtin::puts));
+  set("puts", std::make_shared<Builtin>(eval::builtin::puts, false));
+  set("memo", std::make_shared<Builtin>(eval::builtin::memo));
+  set("memo_stats", std::make_shared<Builtin>(eval::builtin::memo_stats));
 }
 
 Env::Env(std::shared_ptr<Env> outer) : outer_(std::move(outer)) {}
 
-void Env::set(const std::string &name, std::shared_ptr<Object> value) {
-  store_[name] = std::move(value);
+Env::Env(std::shared_ptr<Env> outer, size_t size, const Function *function)
+    : slots_(size),
+      function_(function),
+      frame_(true),
+      outer_(std::move(outer)) {}
+
+void Env::reset(std::shared_ptr<Env> outer, size_t size,
+                const Function *function) {
+  // Keeps the capacity, so that a reused frame allocates nothing.
+  slots_.assign(size, nullptr);
+  function_ = function;
+  frame_ = true;
+  outer_ = std::move(outer);
 }
 
-std::shared_ptr<Object> Env::get(const std::string &name) const {
-  auto it = store_.find(name);
-  if (it != store_.end()) {
-    return it->second;
+void Env::set(ast::Symbol name, std::shared_ptr<Object> value) {
+  auto [it, inserted] = store_.try_emplace(name, std::move(value));
+  if (!inserted) {
+    it->second = std::move(value);
+    ++version_;
   }
-  if (outer_ != nullptr) {
-    return outer_->get(name);
+}
+
+std::shared_ptr<Object> Env::get(ast::Symbol name) const {
+  for (const auto *env = this; env != nullptr; env = env->outer_.get()) {
+    if (env->store_.empty()) {
+      continue;
+    }
+    auto it = env->store_.find(name);
+    if (it != env->store_.end()) {
+      return it->second;
+    }
   }
   return nullptr;
 }
 
+void Env::set(std::string_view name, std::shared_ptr<Object> value) {
+  set(ast::Symbol::intern(name), std::move(value));
+}
+
+std::shared_ptr<Object> Env::get(std::string_view name) const {
+  return get(ast::Symbol::intern(name));
+}
+
 }  // namespace monkey::object
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <monkey/object/memo.h>
+#include <monkey/object/object.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace monkey::object {
+
+namespace {
+
+thread_local uint64_t effects = 0;
+
+void combine(size_t& seed, size_t hash) {
+  seed ^= hash + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+}
+
+// Hashes what operator== compares, or returns false if the object is not
+// compared by value. type() has been checked before every static_cast.
+bool hash_into(const Object& object, size_t& seed) {
+  combine(seed, static_cast<size_t>(object.type()));
+  switch (object.type()) {
+    case ObjectType::kInteger:
+      combine(seed, std::hash<int64_t>{}(
+                        static_cast<const Integer&>(object).value()));
+      return true;
+    case ObjectType::kBoolean:
+      combine(seed, static_cast<const Boolean&>(object).value() ? 1 : 0);
+      return true;
+    case ObjectType::kNull:
+      return true;
+    case ObjectType::kString:
+      combine(seed, std::hash<std::string>{}(
+                        static_cast<const String&>(object).value()));
+      return true;
+    case ObjectType::kArray:
+      for (const auto& element :
+           static_cast<const Array&>(object).elements()) {
+        if (!hash_into(*element, seed)) {
+          return false;
+        }
+      }
+      return true;
+    case ObjectType::kHash: {
+      // Pairs are unordered, so their hashes are summed.
+      size_t sum = 0;
+      for (const auto& [key, value] : static_cast<const Hash&>(object).pairs()) {
+        size_t pair = 0;
+        if (!hash_into(*key, pair) || !hash_into(*value, pair)) {
+          return false;
+        }
+        sum += pair;
+      }
+      combine(seed, sum);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+uint64_t effect_count() { return effects; }
+
+void record_effect() { ++effects; }
+
+MemoTable::MemoTable(size_t capacity) : capacity_(capacity) {}
+
+bool MemoTable::KeyEqual::operator()(const Key& lhs, const Key& rhs) const {
+  if (lhs.hash != rhs.hash || lhs.args->size() != rhs.args->size()) {
+    return false;
+  }
+  for (size_t i = 0; i < lhs.args->size(); ++i) {
+    if (*(*lhs.args)[i] != *(*rhs.args)[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<Object> MemoTable::find(const Arguments& args,
+                                        uint64_t version) {
+  auto key = Key{.args = &args, .hash = 0};
+  for (const auto& arg : args) {
+    if (!hash_into(*arg, key.hash)) {
+      return nullptr;
+    }
+  }
+  if (version != version_) {
+    reset(version);
+  }
+  const auto it = index_.find(key);
+  if (it == index_.end()) {
+    ++misses_;
+    return nullptr;
+  }
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->result;
+}
+
+void MemoTable::insert(const Arguments& args, std::shared_ptr<Object> result,
+                       uint64_t version) {
+  if (capacity_ == 0) {
+    return;
+  }
+  auto key = Key{.args = &args, .hash = 0};
+  for (const auto& arg : args) {
+    if (!hash_into(*arg, key.hash)) {
+      return;
+    }
+  }
+  if (version != version_) {
+    reset(version);
+  }
+  if (index_.contains(key)) {
+    return;
+  }
+  if (entries_.size() == capacity_) {
+    const auto& last = entries_.back();
+    index_.erase(Key{.args = &last.args, .hash = last.hash});
+    entries_.pop_back();
+  }
+  entries_.push_front(
+      {.args = args, .result = std::move(result), .hash = key.hash});
+  key.args = &entries_.front().args;
+  index_.emplace(key, entries_.begin());
+}
+
+void MemoTable::reset(uint64_t version) {
+  index_.clear();
+  entries_.clear();
+  version_ = version;
+}
+
+}  // namespace monkey::object
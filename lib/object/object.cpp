@@ -1,5 +1,6 @@
 #include <monkey/ast/ast.h>
 #include <monkey/ast/expr.h>
+#include <monkey/ast/flat.h>
 #include <monkey/ast/stmt.h>
 #include <monkey/object/object.h>
 
@@ -24,6 +25,8 @@ std::string to_string(ObjectType type) {
       return "NULL";
     case ObjectType::kReturnValue:
       return "RETURN";
+    case ObjectType::kTailCall:
+      return "TAIL_CALL";
     case ObjectType::kFunction:
       return "FUNCTION";
     case ObjectType::kString:
@@ -101,12 +104,34 @@ bool ReturnValue::operator!=(const Object& other) const {
   return !(*this == other);
 }
 
+TailCall::TailCall() noexcept = default;
+
+std::string TailCall::to_string() const { return "tail call"; }
+
+bool TailCall::operator==(const Object& other) const {
+  return this == &other;
+}
+
+bool TailCall::operator!=(const Object& other) const {
+  return !(*this == other);
+}
+
 Function::Function(std::vector<std::shared_ptr<ast::Identifier>> parameters,
                    std::shared_ptr<ast::BlockStatement> body,
-                   std::shared_ptr<Env> env)
+                   std::shared_ptr<const ast::AstArena> arena,
+                   std::shared_ptr<Env> env, size_t frame_size,
+                   std::vector<std::shared_ptr<Object>> captures,
+                   std::vector<std::shared_ptr<Env>> frames, bool pure,
+                   bool frame_escapes)
     : parameters_(std::move(parameters)),
       body_(std::move(body)),
-      env_(std::move(env)) {}
+      arena_(std::move(arena)),
+      env_(std::move(env)),
+      frame_size_(frame_size),
+      captures_(std::move(captures)),
+      frames_(std::move(frames)),
+      pure_(pure),
+      frame_escapes_(frame_escapes) {}
 
 std::string Function::to_string() const {
   std::string out = "fn(";
@@ -121,7 +146,11 @@ bool Function::operator==(const Object& other) const {
   if (other.type() != ObjectType::kFunction) {
     return false;
   }
-  const auto& other_func = dynamic_cast<const Function&>(other);
+  const auto* other_function = dynamic_cast<const Function*>(&other);
+  if (other_function == nullptr) {
+    return false;
+  }
+  const auto& other_func = *other_function;
   if (parameters_.size() != other_func.parameters_.size()) {
     return false;
   }
@@ -137,6 +166,29 @@ bool Function::operator!=(const Object& other) const {
   return !(*this == other);
 }
 
+FlatFunction::FlatFunction(std::shared_ptr<const ast::FlatProgram> program,
+                           ast::NodeIndex literal, std::shared_ptr<Env> env)
+    : program_(std::move(program)), literal_(literal), env_(std::move(env)) {}
+
+std::string FlatFunction::to_string() const {
+  std::string out = "fn(";
+  for (const auto param : parameters()) {
+    out += program_->to_string(param) + ", ";
+  }
+  out += ") {\n" + program_->to_string(body()) + "\n}";
+  return out;
+}
+
+bool FlatFunction::operator==(const Object& other) const {
+  const auto* other_function = dynamic_cast<const FlatFunction*>(&other);
+  return other_function != nullptr && program_ == other_function->program_ &&
+         literal_ == other_function->literal_;
+}
+
+bool FlatFunction::operator!=(const Object& other) const {
+  return !(*this == other);
+}
+
 String::String(std::string value) : value_(std::move(value)) {}
 
 std::string String::to_string() const { return value_; }
@@ -208,7 +260,8 @@ bool Hash::operator==(const Object& other) const {
 
 bool Hash::operator!=(const Object& other) const { return !(*this == other); }
 
-Builtin::Builtin(Builtin::FunctionType* fn) : function_(std::move(fn)) {}
+Builtin::Builtin(Builtin::FunctionType* fn, bool pure)
+    : function_(std::move(fn)), pure_(pure) {}
 
 std::string Builtin::to_string() const { return "builtin function"; }
 
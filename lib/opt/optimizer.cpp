@@ -0,0 +1,457 @@
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/eval/eval.h>
+#include <monkey/object/object.h>
+#include <monkey/opt/optimizer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace monkey::opt {
+
+namespace {
+
+// Rebuilds the nodes above whatever a pass replaced and shares the rest.
+class Rewriter {
+ public:
+  Rewriter(Pass& pass, ast::AstArena& arena, PassStats& stats)
+      : pass_(pass), arena_(arena), stats_(stats) {}
+
+  std::vector<std::shared_ptr<ast::Statement>> statements(
+      const std::vector<std::shared_ptr<ast::Statement>>& statements) {
+    auto rewritten = rewrite_each(statements);
+    erase(rewritten);
+    return rewritten;
+  }
+
+  // As above, for the top level: `shifts` holds the Program::offset_shift()
+  // of each statement and is left holding those of the ones kept. Passes
+  // only erase statements, so the ones kept are found in order.
+  std::vector<std::shared_ptr<ast::Statement>> statements(
+      const std::vector<std::shared_ptr<ast::Statement>>& statements,
+      std::vector<uint32_t>& shifts) {
+    const auto rewritten = rewrite_each(statements);
+    auto kept = rewritten;
+    erase(kept);
+    std::vector<uint32_t> kept_shifts;
+    kept_shifts.reserve(kept.size());
+    size_t i = 0;
+    for (const auto& statement : kept) {
+      while (rewritten[i] != statement) {
+        ++i;
+      }
+      kept_shifts.push_back(shifts[i++]);
+    }
+    shifts = std::move(kept_shifts);
+    return kept;
+  }
+
+  std::shared_ptr<ast::Expression> expression(
+      const std::shared_ptr<ast::Expression>& node) {
+    auto rebuilt = located(*node, children(node));
+    auto result = pass_.rewrite(rebuilt, arena_);
+    if (result != rebuilt) {
+      ++stats_.rewrites;
+    }
+    return result;
+  }
+
+ private:
+  std::vector<std::shared_ptr<ast::Statement>> rewrite_each(
+      const std::vector<std::shared_ptr<ast::Statement>>& statements) {
+    std::vector<std::shared_ptr<ast::Statement>> rewritten;
+    rewritten.reserve(statements.size());
+    for (const auto& statement : statements) {
+      rewritten.push_back(located(*statement, this->statement(statement)));
+    }
+    return rewritten;
+  }
+
+  void erase(std::vector<std::shared_ptr<ast::Statement>>& statements) {
+    const auto size = statements.size();
+    pass_.rewrite(statements);
+    stats_.rewrites += size - statements.size();
+  }
+
+  // Gives a rebuilt node the location of the one it replaces.
+  template <typename T>
+  static std::shared_ptr<T> located(const ast::Node& original,
+                                    std::shared_ptr<T> node) {
+    if (node.get() != &original) {
+      node->set_offset(original.offset());
+    }
+    return node;
+  }
+
+  std::shared_ptr<ast::Statement> statement(
+      const std::shared_ptr<ast::Statement>& node) {
+    switch (node->type()) {
+      case ast::NodeType::kLetStatement: {
+        const auto& let = dynamic_cast<const ast::LetStatement&>(*node);
+        auto value = expression(let.value());
+        if (value == let.value()) {
+          return node;
+        }
+        return arena_.make<ast::LetStatement>(let.name(), std::move(value));
+      }
+      case ast::NodeType::kReturnStatement: {
+        const auto& ret = dynamic_cast<const ast::ReturnStatement&>(*node);
+        auto value = expression(ret.return_value());
+        if (value == ret.return_value()) {
+          return node;
+        }
+        return arena_.make<ast::ReturnStatement>(std::move(value));
+      }
+      case ast::NodeType::kExpressionStatement: {
+        const auto& statement =
+            dynamic_cast<const ast::ExpressionStatement&>(*node);
+        auto value = expression(statement.expression());
+        if (value == statement.expression()) {
+          return node;
+        }
+        return arena_.make<ast::ExpressionStatement>(std::move(value));
+      }
+      case ast::NodeType::kBlockStatement:
+        return block(std::dynamic_pointer_cast<ast::BlockStatement>(node));
+      default:
+        return node;
+    }
+  }
+
+  std::shared_ptr<ast::BlockStatement> block(
+      const std::shared_ptr<ast::BlockStatement>& node) {
+    if (node == nullptr) {
+      return nullptr;
+    }
+    auto rewritten = statements(node->statements());
+    if (rewritten == node->statements()) {
+      return node;
+    }
+    return located(*node,
+                   arena_.make<ast::BlockStatement>(std::move(rewritten)));
+  }
+
+  std::vector<std::shared_ptr<ast::Expression>> expressions(
+      const std::vector<std::shared_ptr<ast::Expression>>& nodes) {
+    std::vector<std::shared_ptr<ast::Expression>> rewritten;
+    rewritten.reserve(nodes.size());
+    for (const auto& node : nodes) {
+      rewritten.push_back(expression(node));
+    }
+    return rewritten;
+  }
+
+  std::shared_ptr<ast::Expression> children(
+      const std::shared_ptr<ast::Expression>& node) {
+    switch (node->type()) {
+      case ast::NodeType::kPrefixExpression: {
+        const auto& prefix = dynamic_cast<const ast::PrefixExpression&>(*node);
+        auto right = expression(prefix.right());
+        if (right == prefix.right()) {
+          return node;
+        }
+        return arena_.make<ast::PrefixExpression>(prefix.op(),
+                                                  std::move(right));
+      }
+      case ast::NodeType::kInfixExpression: {
+        const auto& infix = dynamic_cast<const ast::InfixExpression&>(*node);
+        auto left = expression(infix.left());
+        auto right = expression(infix.right());
+        if (left == infix.left() && right == infix.right()) {
+          return node;
+        }
+        return arena_.make<ast::InfixExpression>(std::move(left), infix.op(),
+                                                 std::move(right));
+      }
+      case ast::NodeType::kIfExpression: {
+        const auto& if_expression =
+            dynamic_cast<const ast::IfExpression&>(*node);
+        auto condition = expression(if_expression.condition());
+        auto consequence = block(if_expression.consequence());
+        auto alternative = block(if_expression.alternative());
+        if (condition == if_expression.condition() &&
+            consequence == if_expression.consequence() &&
+            alternative == if_expression.alternative()) {
+          return node;
+        }
+        return arena_.make<ast::IfExpression>(
+            std::move(condition), std::move(consequence),
+            std::move(alternative));
+      }
+      case ast::NodeType::kFunctionLiteral: {
+        const auto& literal = dynamic_cast<const ast::FunctionLiteral&>(*node);
+        auto body = block(literal.body());
+        if (body == literal.body()) {
+          return node;
+        }
+        return arena_.make<ast::FunctionLiteral>(literal.parameters(),
+                                                 std::move(body));
+      }
+      case ast::NodeType::kArrayLiteral: {
+        const auto& literal = dynamic_cast<const ast::ArrayLiteral&>(*node);
+        auto elements = expressions(literal.elements());
+        if (elements == literal.elements()) {
+          return node;
+        }
+        return arena_.make<ast::ArrayLiteral>(std::move(elements));
+      }
+      case ast::NodeType::kHashLiteral: {
+        const auto& literal = dynamic_cast<const ast::HashLiteral&>(*node);
+        std::unordered_map<std::shared_ptr<ast::Expression>,
+                           std::shared_ptr<ast::Expression>>
+            pairs;
+        auto changed = false;
+        for (const auto& [key, value] : literal.pairs()) {
+          auto new_key = expression(key);
+          auto new_value = expression(value);
+          changed = changed || new_key != key || new_value != value;
+          pairs.emplace(std::move(new_key), std::move(new_value));
+        }
+        if (!changed) {
+          return node;
+        }
+        return arena_.make<ast::HashLiteral>(std::move(pairs));
+      }
+      case ast::NodeType::kCallExpression: {
+        const auto& call = dynamic_cast<const ast::CallExpression&>(*node);
+        auto function = expression(call.function());
+        auto arguments = expressions(call.arguments());
+        if (function == call.function() && arguments == call.arguments()) {
+          return node;
+        }
+        return arena_.make<ast::CallExpression>(std::move(function),
+                                                std::move(arguments));
+      }
+      case ast::NodeType::kIndexExpression: {
+        const auto& index = dynamic_cast<const ast::IndexExpression&>(*node);
+        auto left = expression(index.left());
+        auto position = expression(index.index());
+        if (left == index.left() && position == index.index()) {
+          return node;
+        }
+        return arena_.make<ast::IndexExpression>(std::move(left),
+                                                 std::move(position));
+      }
+      default:
+        return node;
+    }
+  }
+
+  Pass& pass_;
+  ast::AstArena& arena_;
+  PassStats& stats_;
+};
+
+// The value of an integer, boolean or string literal, or nullptr.
+std::shared_ptr<object::Object> literal_value(const ast::Expression& node) {
+  switch (node.type()) {
+    case ast::NodeType::kIntegerLiteral:
+      return std::make_shared<object::Integer>(
+          dynamic_cast<const ast::IntegerLiteral&>(node).value());
+    case ast::NodeType::kBooleanLiteral:
+      return std::make_shared<object::Boolean>(
+          dynamic_cast<const ast::BooleanLiteral&>(node).value());
+    case ast::NodeType::kStringLiteral:
+      return std::make_shared<object::String>(
+          dynamic_cast<const ast::StringLiteral&>(node).value());
+    default:
+      return nullptr;
+  }
+}
+
+// The literal for a folded value, or nullptr for errors and anything else a
+// literal cannot spell.
+std::shared_ptr<ast::Expression> make_literal(
+    const std::shared_ptr<object::Object>& value, ast::AstArena& arena) {
+  if (value == nullptr) {
+    return nullptr;
+  }
+  switch (value->type()) {
+    case object::ObjectType::kInteger:
+      return arena.make<ast::IntegerLiteral>(
+          dynamic_cast<const object::Integer&>(*value).value());
+    case object::ObjectType::kBoolean:
+      return arena.make<ast::BooleanLiteral>(
+          dynamic_cast<const object::Boolean&>(*value).value());
+    case object::ObjectType::kString:
+      return arena.make<ast::StringLiteral>(
+          dynamic_cast<const object::String&>(*value).value());
+    default:
+      return nullptr;
+  }
+}
+
+// Whether evaluating the expression can neither fail nor have an effect.
+// Identifiers are excluded since looking up an unbound one is an error.
+bool is_pure(const ast::Expression& node) {
+  switch (node.type()) {
+    case ast::NodeType::kIntegerLiteral:
+    case ast::NodeType::kBooleanLiteral:
+    case ast::NodeType::kStringLiteral:
+    case ast::NodeType::kFunctionLiteral:
+      return true;
+    case ast::NodeType::kArrayLiteral:
+      return std::ranges::all_of(
+          dynamic_cast<const ast::ArrayLiteral&>(node).elements(),
+          [](const auto& element) { return is_pure(*element); });
+    case ast::NodeType::kHashLiteral:
+      return std::ranges::all_of(
+          dynamic_cast<const ast::HashLiteral&>(node).pairs(),
+          [](const auto& pair) {
+            return literal_value(*pair.first) != nullptr &&
+                   is_pure(*pair.second);
+          });
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+std::shared_ptr<ast::Expression> Pass::rewrite(
+    const std::shared_ptr<ast::Expression>& expression, ast::AstArena&) {
+  return expression;
+}
+
+void Pass::rewrite(std::vector<std::shared_ptr<ast::Statement>>&) {}
+
+std::shared_ptr<ast::Expression> FoldConstants::rewrite(
+    const std::shared_ptr<ast::Expression>& expression, ast::AstArena& arena) {
+  std::shared_ptr<object::Object> value;
+  if (expression->type() == ast::NodeType::kPrefixExpression) {
+    const auto& prefix = dynamic_cast<const ast::PrefixExpression&>(*expression);
+    if (auto right = literal_value(*prefix.right())) {
+      value = eval::evalPrefixOperator(prefix.op(), right);
+    }
+  } else if (expression->type() == ast::NodeType::kInfixExpression) {
+    const auto& infix = dynamic_cast<const ast::InfixExpression&>(*expression);
+    auto left = literal_value(*infix.left());
+    auto right = literal_value(*infix.right());
+    if (left != nullptr && right != nullptr) {
+      value = eval::evalInfixOperator(infix.op(), left, right);
+    }
+  }
+  auto literal = make_literal(value, arena);
+  if (literal == nullptr) {
+    return expression;
+  }
+  literal->set_offset(expression->offset());
+  return literal;
+}
+
+std::shared_ptr<ast::Expression> PruneBranches::rewrite(
+    const std::shared_ptr<ast::Expression>& expression, ast::AstArena& arena) {
+  if (expression->type() != ast::NodeType::kIfExpression) {
+    return expression;
+  }
+  const auto& if_expression =
+      dynamic_cast<const ast::IfExpression&>(*expression);
+  const auto condition = literal_value(*if_expression.condition());
+  if (condition == nullptr) {
+    return expression;
+  }
+  const auto taken = eval::isTruthy(*condition);
+  const auto& branch =
+      taken ? if_expression.consequence() : if_expression.alternative();
+
+  if (branch == nullptr) {
+    // Evaluates to null; keep the shortest if that still does.
+    if (if_expression.consequence()->statements().empty() &&
+        if_expression.alternative() == nullptr) {
+      return expression;
+    }
+    auto pruned = arena.make<ast::IfExpression>(
+        arena.make<ast::BooleanLiteral>(false),
+        arena.make<ast::BlockStatement>(
+            std::vector<std::shared_ptr<ast::Statement>>()),
+        nullptr);
+    pruned->set_offset(expression->offset());
+    return pruned;
+  }
+  // A lone expression statement binds nothing, so its block's scope can go.
+  if (branch->statements().size() == 1 &&
+      branch->statements().front()->type() ==
+          ast::NodeType::kExpressionStatement) {
+    return dynamic_cast<const ast::ExpressionStatement&>(
+               *branch->statements().front())
+        .expression();
+  }
+  if (taken && if_expression.alternative() == nullptr &&
+      if_expression.condition()->type() == ast::NodeType::kBooleanLiteral) {
+    return expression;
+  }
+  auto pruned = arena.make<ast::IfExpression>(
+      arena.make<ast::BooleanLiteral>(true), branch, nullptr);
+  pruned->set_offset(expression->offset());
+  return pruned;
+}
+
+void DropUnused::rewrite(
+    std::vector<std::shared_ptr<ast::Statement>>& statements) {
+  const auto is_return = [](const auto& statement) {
+    return statement->type() == ast::NodeType::kReturnStatement;
+  };
+  if (const auto ret = std::ranges::find_if(statements, is_return);
+      ret != statements.end()) {
+    statements.erase(ret + 1, statements.end());
+  }
+  if (statements.size() < 2) {
+    return;
+  }
+  const auto last = statements.back();
+  std::erase_if(statements, [&last](const auto& statement) {
+    return statement != last &&
+           statement->type() == ast::NodeType::kExpressionStatement &&
+           is_pure(*dynamic_cast<const ast::ExpressionStatement&>(*statement)
+                        .expression());
+  });
+}
+
+Optimizer::Optimizer(int level) {
+  if (level >= 1) {
+    add(std::make_unique<FoldConstants>());
+    add(std::make_unique<PruneBranches>());
+  }
+  if (level >= 2) {
+    add(std::make_unique<DropUnused>());
+  }
+}
+
+void Optimizer::add(std::unique_ptr<Pass> pass) {
+  stats_.push_back({.name = pass->name()});
+  passes_.push_back(std::move(pass));
+}
+
+std::shared_ptr<ast::Program> Optimizer::run(
+    const std::shared_ptr<ast::Program>& program) {
+  if (passes_.empty()) {
+    return program;
+  }
+  auto arena = std::make_shared<ast::AstArena>();
+  if (program->arena() != nullptr) {
+    arena->adopt(program->arena());
+  }
+  auto statements = program->statements();
+  std::vector<uint32_t> shifts(statements.size());
+  for (size_t i = 0; i < statements.size(); ++i) {
+    shifts[i] = program->offset_shift(i);
+  }
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    statements = Rewriter(*passes_[i], *arena, stats_[i])
+                     .statements(statements, shifts);
+    stats_[i].time += std::chrono::steady_clock::now() - start;
+  }
+  return std::make_shared<ast::Program>(std::move(statements),
+                                        std::move(arena), std::move(shifts));
+}
+
+}  // namespace monkey::opt
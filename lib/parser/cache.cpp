@@ -0,0 +1,70 @@
+#include <fmt/core.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/binary.h>
+#include <monkey/lexer/source.h>
+#include <monkey/parser/cache.h>
+
+#include <filesystem>
+#include <fstream>
+#include <ios>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace monkey::parser {
+
+ProgramCache::ProgramCache(std::filesystem::path directory)
+    : directory_(std::move(directory)) {}
+
+std::shared_ptr<ast::Program> ProgramCache::load(
+    const ast::SourceKey& key) const {
+  const auto file = path(key);
+  auto error = std::error_code();
+  if (!std::filesystem::is_regular_file(file, error)) {
+    return nullptr;
+  }
+  try {
+    const auto source = lexer::MappedFileSource(file.string());
+    return ast::decode(source.text(), key);
+  } catch (const lexer::SourceError&) {
+    return nullptr;
+  } catch (const ast::FormatError&) {
+    return nullptr;
+  }
+}
+
+bool ProgramCache::store(const ast::SourceKey& key,
+                         const ast::Program& program) const {
+  const auto bytes = ast::encode(program, key);
+  auto error = std::error_code();
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    return false;
+  }
+
+  const auto file = path(key);
+  auto temporary = file;
+  temporary += fmt::format(".{:08x}.tmp", std::random_device()());
+  {
+    auto out = std::ofstream(temporary, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out.flush()) {
+      std::filesystem::remove(temporary, error);
+      return false;
+    }
+  }
+  std::filesystem::rename(temporary, file, error);
+  if (error) {
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
+  return true;
+}
+
+std::filesystem::path ProgramCache::path(const ast::SourceKey& key) const {
+  return directory_ / fmt::format("{:016x}-{:x}.mkc", key.hash, key.size);
+}
+
+}  // namespace monkey::parser
@@ -2,7 +2,9 @@
 #include <monkey/lexer/token.h>
 #include <monkey/parser/error.h>
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace monkey::parser {
@@ -14,19 +16,34 @@ ParserError::ParserError(std::string&& message)
     : message_(fmt::format("ParseError: {}", std::move(message))) {}
 
 PeekTokenError::PeekTokenError(lexer::TokenType expect, lexer::TokenType got)
-    : ParserError(fmt::format("expect next token to be {}, got {} instead",
-                              lexer::to_string(expect),
-                              lexer::to_string(got))) {}
+    : ParserError(message(expect, got)) {}
+
+std::string PeekTokenError::message(lexer::TokenType expect,
+                                    lexer::TokenType got) {
+  return fmt::format("expect next token to be {}, got {} instead",
+                     lexer::to_string(expect), lexer::to_string(got));
+}
 
 HandlerNotFoundError::HandlerNotFoundError(lexer::TokenType type)
-    : ParserError(fmt::format("no parse handler for {} found",
-                              lexer::to_string(type))) {}
+    : ParserError(message(type)) {}
+
+std::string HandlerNotFoundError::message(lexer::TokenType type) {
+  return fmt::format("no parse handler for {} found", lexer::to_string(type));
+}
 
 InvalidIntegerError::InvalidIntegerError(const std::string& literal)
-    : InvalidIntegerError(std::string(literal)) {}
+    : ParserError(message(literal)) {}
 
 InvalidIntegerError::InvalidIntegerError(std::string&& literal)
-    : ParserError(
-          fmt::format("could not parse {} as integer", std::move(literal))) {}
+    : ParserError(message(literal)) {}
+
+std::string InvalidIntegerError::message(std::string_view literal) {
+  return fmt::format("could not parse {} as integer", literal);
+}
+
+InvalidEditError::InvalidEditError(size_t offset, size_t removed, size_t size)
+    : ParserError(fmt::format(
+          "cannot replace {} bytes at offset {} in text of {} bytes", removed,
+          offset, size)) {}
 
 }  // namespace monkey::parser
\ No newline at end of file
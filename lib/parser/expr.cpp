@@ -1,3 +1,4 @@
+#include <monkey/ast/arena.h>
 #include <monkey/ast/expr.h>
 #include <monkey/ast/stmt.h>
 #include <monkey/lexer/token.h>
@@ -6,9 +7,11 @@
 #include <monkey/parser/reader.h>
 #include <monkey/parser/stmt.h>
 
+#include <charconv>
+#include <cstdint>
 #include <memory>
-#include <stdexcept>
 #include <string>
+#include <system_error>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -16,63 +19,74 @@
 namespace monkey::parser {
 
 Precedence get_precedence(lexer::TokenType type) {
-  if (kPrecedences.find(type) != kPrecedences.end()) {
-    return kPrecedences.at(type);
-  }
-
-  return Precedence::kLowest;
+  return kPrecedences[lexer::to_index(type)];
 }
 
 std::shared_ptr<ast::Expression> parse_expression(Reader& reader,
                                                   Precedence precedence) {
-  auto prefix_handler = kPrefixHandlers.find(reader.current_token().type());
-  if (prefix_handler == kPrefixHandlers.end()) {
-    throw HandlerNotFoundError(reader.current_token().type());
+  const auto prefix = kPrefixHandlers[lexer::to_index(
+      reader.current_token().type())];
+  if (prefix == nullptr) {
+    reader.fail<HandlerNotFoundError>(reader.current_token(),
+                                      reader.current_token().type());
+    return nullptr;
   }
 
-  auto left_expression = prefix_handler->second(reader);
+  auto left_expression = prefix(reader);
   while (!reader.peek_token_is(lexer::TokenType::kSemicolon) &&
          precedence < get_precedence(reader.peek_token().type())) {
-    auto infix_handler = kInfixHandlers.find(reader.peek_token().type());
-    if (infix_handler == kInfixHandlers.end()) {
+    const auto infix = kInfixHandlers[lexer::to_index(
+        reader.peek_token().type())];
+    if (infix == nullptr) {
       return left_expression;
     }
 
     reader.next_token();
-    left_expression = infix_handler->second(reader, std::move(left_expression));
+    left_expression = infix(reader, std::move(left_expression));
   }
   return left_expression;
 }
 
 std::shared_ptr<ast::Identifier> parse_identifier(Reader& reader) {
-  return std::make_unique<ast::Identifier>(reader.current_token().literal());
+  return reader.make<ast::Identifier>(reader.current_token().offset(),
+                                     reader.current_token().literal());
 }
 
 std::shared_ptr<ast::IntegerLiteral> parse_integer_literal(Reader& reader) {
-  try {
-    auto value = std::stoi(reader.current_token().literal());
-    return std::make_unique<ast::IntegerLiteral>(value);
-  } catch (std::invalid_argument& e) {
-    throw InvalidIntegerError(reader.current_token().literal());
+  const auto literal = reader.current_token().literal();
+  int64_t value = 0;
+  const auto [end, error] =
+      std::from_chars(literal.data(), literal.data() + literal.size(), value);
+  if (error != std::errc() || end != literal.data() + literal.size()) {
+    reader.fail<InvalidIntegerError>(reader.current_token(),
+                                     std::string(literal));
+    return nullptr;
   }
+  return reader.make<ast::IntegerLiteral>(reader.current_token().offset(),
+                                         value);
 }
 
 std::shared_ptr<ast::BooleanLiteral> parse_boolean_literal(Reader& reader) {
-  return std::make_unique<ast::BooleanLiteral>(
+  return reader.make<ast::BooleanLiteral>(
+      reader.current_token().offset(),
       reader.current_token_is(lexer::TokenType::kTrue));
 }
 
 std::shared_ptr<ast::StringLiteral> parse_string_literal(Reader& reader) {
-  return std::make_unique<ast::StringLiteral>(reader.current_token().literal());
+  return reader.make<ast::StringLiteral>(
+      reader.current_token().offset(),
+      std::string(reader.current_token().literal()));
 }
 
 std::shared_ptr<ast::ArrayLiteral> parse_array_literal(Reader& reader) {
+  const auto offset = reader.current_token().offset();
   std::vector<std::shared_ptr<ast::Expression>> elements =
       parse_expression_list(reader, lexer::TokenType::kRightBracket);
-  return std::make_unique<ast::ArrayLiteral>(std::move(elements));
+  return reader.make<ast::ArrayLiteral>(offset, std::move(elements));
 }
 
 std::shared_ptr<ast::HashLiteral> parse_hash_literal(Reader& reader) {
+  const auto offset = reader.current_token().offset();
   std::unordered_map<std::shared_ptr<ast::Expression>,
                      std::shared_ptr<ast::Expression>>
       pairs;
@@ -93,10 +107,11 @@ std::shared_ptr<ast::HashLiteral> parse_hash_literal(Reader& reader) {
   if (!reader.expect_peek(lexer::TokenType::kRightBrace)) {
     return nullptr;
   }
-  return std::make_unique<ast::HashLiteral>(std::move(pairs));
+  return reader.make<ast::HashLiteral>(offset, std::move(pairs));
 }
 
 std::shared_ptr<ast::FunctionLiteral> parse_function_literal(Reader& reader) {
+  const auto offset = reader.current_token().offset();
   if (!reader.expect_peek(lexer::TokenType::kLeftParen)) {
     return nullptr;
   }
@@ -105,16 +120,16 @@ std::shared_ptr<ast::FunctionLiteral> parse_function_literal(Reader& reader) {
     return nullptr;
   }
   auto body = parse_block_statement(reader);
-  return std::make_unique<ast::FunctionLiteral>(std::move(parameters),
-                                                std::move(body));
+  return reader.make<ast::FunctionLiteral>(offset, std::move(parameters),
+                                           std::move(body));
 }
 
 std::shared_ptr<ast::PrefixExpression> parse_prefix_expression(Reader& reader) {
   auto token = reader.current_token();
   reader.next_token();
   auto right = parse_expression(reader, Precedence::kPrefix);
-  return std::make_unique<ast::PrefixExpression>(token.type(),
-                                                 std::move(right));
+  return reader.make<ast::PrefixExpression>(token.offset(), token.type(),
+                                            std::move(right));
 }
 
 std::shared_ptr<ast::InfixExpression> parse_infix_expression(
@@ -123,23 +138,24 @@ std::shared_ptr<ast::InfixExpression> parse_infix_expression(
   auto precedence = get_precedence(token.type());
   reader.next_token();
   auto right = parse_expression(reader, precedence);
-  return std::make_unique<ast::InfixExpression>(std::move(left), token.type(),
-                                                std::move(right));
+  return reader.make<ast::InfixExpression>(token.offset(), std::move(left),
+                                           token.type(), std::move(right));
 }
 
 std::shared_ptr<ast::IndexExpression> parse_index_expression(
     Reader& reader, std::shared_ptr<ast::Expression> left) {
+  const auto offset = reader.current_token().offset();
   reader.next_token();
   auto index = parse_expression(reader, Precedence::kLowest);
   if (!reader.expect_peek(lexer::TokenType::kRightBracket)) {
     return nullptr;
   }
-  return std::make_unique<ast::IndexExpression>(std::move(left),
-                                                std::move(index));
+  return reader.make<ast::IndexExpression>(offset, std::move(left),
+                                           std::move(index));
 }
 
 std::shared_ptr<ast::IfExpression> parse_if_expression(Reader& reader) {
-  auto token = reader.current_token();
+  const auto offset = reader.current_token().offset();
   if (!reader.expect_peek(lexer::TokenType::kLeftParen)) {
     return nullptr;
   }
@@ -160,15 +176,17 @@ std::shared_ptr<ast::IfExpression> parse_if_expression(Reader& reader) {
     }
     alternative = parse_block_statement(reader);
   }
-  return std::make_unique<ast::IfExpression>(
-      std::move(condition), std::move(consequence), std::move(alternative));
+  return reader.make<ast::IfExpression>(offset, std::move(condition),
+                                        std::move(consequence),
+                                        std::move(alternative));
 }
 
 std::shared_ptr<ast::CallExpression> parse_call_expression(
     Reader& reader, std::shared_ptr<ast::Expression> function) {
+  const auto offset = reader.current_token().offset();
   auto arguments = parse_expression_list(reader, lexer::TokenType::kRightParen);
-  return std::make_unique<ast::CallExpression>(std::move(function),
-                                               std::move(arguments));
+  return reader.make<ast::CallExpression>(offset, std::move(function),
+                                          std::move(arguments));
 }
 
 std::shared_ptr<ast::Expression> parse_grouped_expression(Reader& reader) {
@@ -208,13 +226,11 @@ std::vector<std::shared_ptr<ast::Identifier>> parse_function_parameters(
     return parameters;
   }
   reader.next_token();
-  parameters.push_back(
-      std::make_unique<ast::Identifier>(reader.current_token().literal()));
+  parameters.push_back(parse_identifier(reader));
   while (reader.peek_token_is(lexer::TokenType::kComma)) {
     reader.next_token();
     reader.next_token();
-    parameters.push_back(
-        std::make_unique<ast::Identifier>(reader.current_token().literal()));
+    parameters.push_back(parse_identifier(reader));
   }
   if (!reader.expect_peek(lexer::TokenType::kRightParen)) {
     return {};
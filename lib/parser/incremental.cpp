@@ -0,0 +1,176 @@
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/stream.h>
+#include <monkey/parser/error.h>
+#include <monkey/parser/incremental.h>
+#include <monkey/parser/parser.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace monkey::parser {
+
+IncrementalParser::IncrementalParser(std::string text)
+    : source_(std::make_shared<lexer::StringSource>(std::move(text))) {
+  const auto whole = source_->text();
+  const auto arena = std::make_shared<ast::AstArena>();
+  std::vector<std::shared_ptr<ast::Statement>> statements;
+  auto scanner = lexer::StatementScanner();
+  size_t begin = 0;
+  while (begin < whole.size()) {
+    const auto boundary = scanner.scan_one(whole.substr(begin));
+    const auto end = boundary != 0 ? begin + boundary : whole.size();
+    segments_.push_back(
+        parse_segment(source_, begin, end, 0, arena, statements));
+    begin = end;
+  }
+  arenas_.push_back(arena);
+  arena_uses_.push_back(segments_.size());
+  program_ = assemble(std::move(statements));
+}
+
+ReparseResult IncrementalParser::apply(const TextEdit& edit) {
+  const auto old_text = text();
+  if (edit.offset > old_text.size() ||
+      edit.removed > old_text.size() - edit.offset) {
+    throw InvalidEditError(edit.offset, edit.removed, old_text.size());
+  }
+  const auto edit_end = edit.offset + edit.removed;
+  // Where an offset past the edited range in the old text lands in the new.
+  const auto shifted = [&](size_t offset) {
+    return offset - edit.removed + edit.inserted.size();
+  };
+
+  auto updated = std::string(old_text.substr(0, edit.offset));
+  updated += edit.inserted;
+  updated += old_text.substr(edit_end);
+  auto source = std::make_shared<lexer::StringSource>(std::move(updated));
+  const auto new_text = source->text();
+
+  // Start at the segment holding the edit, or the one just before it, which
+  // the edit may extend when it has no closing ';'.
+  const auto first = static_cast<size_t>(
+      std::ranges::lower_bound(segments_, edit.offset, {}, &Segment::end) -
+      segments_.begin());
+  const auto start =
+      first < segments_.size() ? segments_[first].begin : old_text.size();
+
+  // Once a new segment ends where an old one ending at or past the edit did,
+  // the scanner is back at the top level over identical text, so the old
+  // segmentation holds from there on.
+  const auto generation = arenas_.size();
+  const auto arena = std::make_shared<ast::AstArena>();
+  std::vector<std::shared_ptr<ast::Statement>> parsed;
+  std::vector<Segment> reparsed;
+  auto scanner = lexer::StatementScanner();
+  auto resume = segments_.size();
+  auto candidate = first;
+  for (auto begin = start; begin < new_text.size();) {
+    const auto boundary = scanner.scan_one(new_text.substr(begin));
+    const auto end = boundary != 0 ? begin + boundary : new_text.size();
+    reparsed.push_back(
+        parse_segment(source, begin, end, generation, arena, parsed));
+    begin = end;
+
+    while (candidate < segments_.size() &&
+           (segments_[candidate].end < edit_end ||
+            shifted(segments_[candidate].end) < end)) {
+      ++candidate;
+    }
+    if (candidate < segments_.size() &&
+        shifted(segments_[candidate].end) == end) {
+      resume = candidate + 1;
+      break;
+    }
+  }
+
+  // Nothing below throws, so the parser only changes state on success.
+  size_t preceding = 0;
+  for (size_t i = 0; i < first; ++i) {
+    preceding += segments_[i].statements;
+  }
+  size_t replaced = 0;
+  for (size_t i = first; i < resume; ++i) {
+    replaced += segments_[i].statements;
+    if (--arena_uses_[segments_[i].generation] == 0) {
+      arenas_[segments_[i].generation].reset();
+    }
+  }
+  arenas_.push_back(arena);
+  arena_uses_.push_back(reparsed.size());
+
+  const auto& old_statements = program_->statements();
+  std::vector<std::shared_ptr<ast::Statement>> statements;
+  statements.reserve(old_statements.size() - replaced + parsed.size());
+  statements.insert(
+      statements.end(), old_statements.begin(),
+      old_statements.begin() + static_cast<std::ptrdiff_t>(preceding));
+  statements.insert(statements.end(), parsed.begin(), parsed.end());
+  statements.insert(statements.end(),
+                    old_statements.begin() +
+                        static_cast<std::ptrdiff_t>(preceding + replaced),
+                    old_statements.end());
+  std::vector<Segment> segments;
+  segments.reserve(first + reparsed.size() + segments_.size() - resume);
+  segments.insert(segments.end(), segments_.begin(),
+                  segments_.begin() + static_cast<std::ptrdiff_t>(first));
+  segments.insert(segments.end(), reparsed.begin(), reparsed.end());
+  // The nodes of the segments after the edit are left as they are, shared
+  // with the previous program; only the shift added to their offsets moves.
+  const auto delta =
+      static_cast<uint32_t>(edit.inserted.size() - edit.removed);
+  for (auto it = segments_.begin() + static_cast<std::ptrdiff_t>(resume);
+       it != segments_.end(); ++it) {
+    segments.push_back({shifted(it->begin), shifted(it->end), it->statements,
+                        it->generation, it->shift + delta});
+  }
+
+  std::vector<size_t> changed(parsed.size());
+  std::iota(changed.begin(), changed.end(), preceding);
+
+  source_ = std::move(source);
+  segments_ = std::move(segments);
+  program_ = assemble(std::move(statements));
+  return {program_, std::move(changed)};
+}
+
+IncrementalParser::Segment IncrementalParser::parse_segment(
+    const std::shared_ptr<const lexer::StringSource>& source, size_t begin,
+    size_t end, size_t generation,
+    const std::shared_ptr<ast::AstArena>& arena,
+    std::vector<std::shared_ptr<ast::Statement>>& statements) {
+  auto lexer = lexer::Lexer(std::make_shared<lexer::SourceSlice>(
+      source, source->text().substr(begin, end - begin)));
+  const auto program = Parser(lexer, arena).parse_program();
+  statements.insert(statements.end(), program->statements().begin(),
+                    program->statements().end());
+  return {begin, end, program->statements().size(), generation};
+}
+
+std::shared_ptr<ast::Program> IncrementalParser::assemble(
+    std::vector<std::shared_ptr<ast::Statement>> statements) const {
+  auto arena = std::make_shared<ast::AstArena>();
+  for (const auto& generation : arenas_) {
+    if (generation) {
+      arena->adopt(generation);
+    }
+  }
+  std::vector<uint32_t> shifts;
+  shifts.reserve(statements.size());
+  for (const auto& segment : segments_) {
+    shifts.insert(shifts.end(), segment.statements, segment.shift);
+  }
+  return std::make_shared<ast::Program>(std::move(statements),
+                                        std::move(arena), std::move(shifts));
+}
+
+}  // namespace monkey::parser
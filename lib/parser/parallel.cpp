@@ -0,0 +1,84 @@
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/stream.h>
+#include <monkey/parser/parallel.h>
+#include <monkey/parser/parser.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace monkey::parser {
+
+ParallelParser::ParallelParser(std::shared_ptr<const lexer::Source> source,
+                               size_t threads, size_t chunk_size)
+    : source_(std::move(source)),
+      threads_(threads != 0 ? threads
+                            : std::max(1U, std::thread::hardware_concurrency())),
+      chunk_size_(chunk_size) {}
+
+std::shared_ptr<ast::Program> ParallelParser::parse_program() {
+  std::vector<std::string_view> chunks;
+  auto splitter = lexer::StatementSplitter(source_->text(), chunk_size_);
+  while (auto chunk = splitter.next()) {
+    chunks.push_back(*chunk);
+  }
+
+  struct ChunkResult {
+    std::shared_ptr<ast::Program> program;
+    std::exception_ptr error;
+  };
+  std::vector<ChunkResult> results(chunks.size());
+  std::atomic<size_t> next_chunk = 0;
+  // Chunks after the first failing one cannot affect the outcome.
+  std::atomic<size_t> first_error = std::numeric_limits<size_t>::max();
+
+  const auto work = [&] {
+    for (auto i = next_chunk++; i < chunks.size() && i < first_error;
+         i = next_chunk++) {
+      try {
+        auto lexer = lexer::Lexer(
+            std::make_shared<lexer::SourceSlice>(source_, chunks[i]));
+        results[i].program = Parser(lexer).parse_program();
+      } catch (...) {
+        results[i].error = std::current_exception();
+        auto failed = first_error.load();
+        while (i < failed && !first_error.compare_exchange_weak(failed, i)) {
+        }
+      }
+    }
+  };
+  {
+    std::vector<std::jthread> workers;
+    for (size_t i = 1; i < std::min(threads_, chunks.size()); ++i) {
+      workers.emplace_back(work);
+    }
+    work();
+  }
+
+  auto arena = std::make_shared<ast::AstArena>();
+  std::vector<std::shared_ptr<ast::Statement>> statements;
+  for (auto& result : results) {
+    if (result.error) {
+      std::rethrow_exception(result.error);
+    }
+    const auto& chunk_statements = result.program->statements();
+    statements.insert(statements.end(), chunk_statements.begin(),
+                      chunk_statements.end());
+    arena->adopt(result.program->arena());
+  }
+  return std::make_shared<ast::Program>(std::move(statements),
+                                        std::move(arena));
+}
+
+}  // namespace monkey::parser
@@ -1,7 +1,10 @@
+#include <monkey/ast/arena.h>
 #include <monkey/ast/ast.h>
+#include <monkey/ast/flat.h>
 #include <monkey/ast/stmt.h>
 #include <monkey/lexer/lexer.h>
 #include <monkey/lexer/token.h>
+#include <monkey/parser/error.h>
 #include <monkey/parser/parser.h>
 #include <monkey/parser/reader.h>
 #include <monkey/parser/stmt.h>
@@ -13,7 +16,13 @@
 namespace monkey::parser {
 
 Parser::Parser(const lexer::Lexer &lexer)
-    : reader_(std::make_unique<Reader>(lexer.begin(), lexer.end())) {}
+    : reader_(std::make_unique<Reader>(lexer.tokenize())) {}
+
+Parser::Parser(std::vector<lexer::Token> tokens)
+    : reader_(std::make_unique<Reader>(std::move(tokens))) {}
+
+Parser::Parser(const lexer::Lexer &lexer, std::shared_ptr<ast::AstArena> arena)
+    : reader_(std::make_unique<Reader>(lexer.tokenize(), std::move(arena))) {}
 
 std::shared_ptr<ast::Program> Parser::parse_program() {
   std::vector<std::shared_ptr<ast::Statement>> statements;
@@ -24,7 +33,32 @@ std::shared_ptr<ast::Program> Parser::parse_program() {
     }
     reader_->next_token();
   }
-  return std::make_unique<ast::Program>(std::move(statements));
+  return std::make_shared<ast::Program>(std::move(statements),
+                                       reader_->shared_arena());
+}
+
+std::shared_ptr<const ast::FlatProgram> Parser::parse_flat_program() {
+  return ast::flatten(*parse_program());
+}
+
+ParseResult Parser::parse_program_recovering() {
+  ParseResult result;
+  reader_->collect(&result.diagnostics);
+  std::vector<std::shared_ptr<ast::Statement>> statements;
+  while (!reader_->current_token_is(lexer::TokenType::kEOF)) {
+    const auto start = reader_->position();
+    auto statement = parse_statement(*reader_);
+    if (reader_->failed()) {
+      reader_->synchronize(start);
+    } else if (statement) {
+      statements.push_back(std::move(statement));
+    }
+    reader_->next_token();
+  }
+  reader_->collect(nullptr);
+  result.program = std::make_shared<ast::Program>(std::move(statements),
+                                                  reader_->shared_arena());
+  return result;
 }
 
 }  // namespace monkey::parser
\ No newline at end of file
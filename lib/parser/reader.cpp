@@ -1,45 +1,90 @@
+#include <monkey/ast/arena.h>
 #include <monkey/lexer/lexer.h>
 #include <monkey/lexer/token.h>
 #include <monkey/parser/error.h>
 #include <monkey/parser/reader.h>
 
+#include <memory>
 #include <utility>
+#include <vector>
 
 namespace monkey::parser {
 
-Reader::Reader(lexer::Lexer::Iterator current_location,
-               lexer::Lexer::Iterator end_location)
-    : current_location_(current_location),
-      peek_location_(std::move(current_location)),
-      end_location_(std::move(end_location)) {
-  next_token();
+Reader::Reader() : Reader(std::vector<lexer::Token>()) {}
+
+Reader::Reader(std::vector<lexer::Token> tokens)
+    : Reader(std::move(tokens), std::make_shared<ast::AstArena>()) {}
+
+Reader::Reader(std::vector<lexer::Token> tokens,
+               std::shared_ptr<ast::AstArena> arena)
+    : tokens_(std::move(tokens)), arena_(std::move(arena)) {
+  if (tokens_.empty() || tokens_.back().type() != lexer::TokenType::kEOF) {
+    tokens_.emplace_back(lexer::TokenType::kEOF, "");
+  }
 }
 
 bool Reader ::operator==(const Reader &rhs) const {
-  return current_location_ == rhs.current_location_ &&
-         peek_location_ == rhs.peek_location_ &&
-         end_location_ == rhs.end_location_;
+  return position_ == rhs.position_ && tokens_ == rhs.tokens_;
 }
 
 bool Reader::operator!=(const Reader &rhs) const { return !(*this == rhs); }
 
 void Reader::next_token() {
-  current_location_ = peek_location_;
-  if (peek_location_ != end_location_) {
-    ++peek_location_;
+  if (position_ + 1 < tokens_.size()) {
+    ++position_;
   }
 }
 
-lexer::Token Reader::current_token() const { return *current_location_; }
+const lexer::Token &Reader::current_token() const {
+  return tokens_[position_];
+}
 
-lexer::Token Reader::peek_token() const { return *peek_location_; }
+const lexer::Token &Reader::peek_token() const {
+  if (position_ + 1 < tokens_.size()) {
+    return tokens_[position_ + 1];
+  }
+  return tokens_.back();
+}
 
 bool Reader::expect_peek(lexer::TokenType type) {
   if (peek_token_is(type)) {
     next_token();
     return true;
   }
-  throw PeekTokenError(type, peek_token().type());
+  fail<PeekTokenError>(peek_token(), type, peek_token().type());
+  return false;
+}
+
+namespace {
+
+int depth_change(lexer::TokenType type) {
+  switch (type) {
+    case lexer::TokenType::kLeftParen:
+    case lexer::TokenType::kLeftBrace:
+    case lexer::TokenType::kLeftBracket:
+      return 1;
+    case lexer::TokenType::kRightParen:
+    case lexer::TokenType::kRightBrace:
+    case lexer::TokenType::kRightBracket:
+      return -1;
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+void Reader::synchronize(size_t start) {
+  int depth = 0;
+  for (auto i = start; i <= position_; ++i) {
+    depth += depth_change(tokens_[i].type());
+  }
+  while (!current_token_is(lexer::TokenType::kEOF) &&
+         !(depth <= 0 && current_token_is(lexer::TokenType::kSemicolon))) {
+    next_token();
+    depth += depth_change(current_token().type());
+  }
+  failed_ = false;
 }
 
 bool Reader::current_token_is(lexer::TokenType type) const {
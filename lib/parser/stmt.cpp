@@ -1,3 +1,4 @@
+#include <monkey/ast/arena.h>
 #include <monkey/ast/expr.h>
 #include <monkey/ast/stmt.h>
 #include <monkey/lexer/token.h>
@@ -6,6 +7,7 @@
 #include <monkey/parser/stmt.h>
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -23,11 +25,11 @@ std::shared_ptr<ast::Statement> parse_statement(Reader& reader) {
 }
 
 std::shared_ptr<ast::LetStatement> parse_let_statement(Reader& reader) {
+  const auto offset = reader.current_token().offset();
   if (!reader.expect_peek(lexer::TokenType::kIdentifer)) {
     return nullptr;
   }
-  auto name =
-      std::make_unique<ast::Identifier>(reader.current_token().literal());
+  auto name = parse_identifier(reader);
   if (!reader.expect_peek(lexer::TokenType::kAssign)) {
     return nullptr;
   }
@@ -36,39 +38,45 @@ std::shared_ptr<ast::LetStatement> parse_let_statement(Reader& reader) {
   if (reader.peek_token_is(lexer::TokenType::kSemicolon)) {
     reader.next_token();
   }
-  return std::make_unique<ast::LetStatement>(std::move(name), std::move(value));
+  return reader.make<ast::LetStatement>(offset, std::move(name),
+                                        std::move(value));
 }
 
 std::shared_ptr<ast::ReturnStatement> parse_return_statement(Reader& reader) {
+  const auto offset = reader.current_token().offset();
   reader.next_token();
   auto return_value = parse_expression(reader, Precedence::kLowest);
   if (reader.peek_token_is(lexer::TokenType::kSemicolon)) {
     reader.next_token();
   }
-  return std::make_unique<ast::ReturnStatement>(std::move(return_value));
+  return reader.make<ast::ReturnStatement>(offset, std::move(return_value));
 }
 
 std::shared_ptr<ast::ExpressionStatement> parse_expression_statement(
     Reader& reader) {
+  const auto offset = reader.current_token().offset();
   auto expression = parse_expression(reader, Precedence::kLowest);
   if (reader.peek_token_is(lexer::TokenType::kSemicolon)) {
     reader.next_token();
   }
-  return std::make_unique<ast::ExpressionStatement>(std::move(expression));
+  return reader.make<ast::ExpressionStatement>(offset, std::move(expression));
 }
 
 std::shared_ptr<ast::BlockStatement> parse_block_statement(Reader& reader) {
+  const auto offset = reader.current_token().offset();
   auto statements = std::vector<std::shared_ptr<ast::Statement>>();
   reader.next_token();
+  // After a collected error, stop here and leave the recovery to the top
+  // level rather than read past the block's end.
   while (!reader.current_token_is(lexer::TokenType::kRightBrace) &&
-         !reader.current_token_is(lexer::TokenType::kEOF)) {
+         !reader.current_token_is(lexer::TokenType::kEOF) && !reader.failed()) {
     auto statement = parse_statement(reader);
     if (statement) {
       statements.push_back(std::move(statement));
     }
     reader.next_token();
   }
-  return std::make_unique<ast::BlockStatement>(std::move(statements));
+  return reader.make<ast::BlockStatement>(offset, std::move(statements));
 }
 
 }  // namespace monkey::parser
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include <monkey/ast/arena.h>
+#include <monkey/ast/ast.h>
+#include <monkey/compiler/bytecode.h>
+#include <monkey/compiler/compiler.h>
+#include <monkey/eval/builtin.h>
+#include <monkey/eval/eval.h>
+#include <monkey/eval/value.h>
+#include <monkey/lexer/token.h>
+#include <monkey/object/env.h>
+#include <monkey/object/object.h>
+#include <monkey/vm/vm.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace monkey::vm {
+
+Closure::Closure(std::shared_ptr<const compiler::Module> module,
+                 uint32_t function,
+                 std::vector<std::shared_ptr<object::Object>> captures,
+                 std::vector<std::shared_ptr<object::Env>> frames)
+    : module_(std::move(module)),
+      function_(&module_->functions[function]),
+      captures_(std::move(captures)),
+      frames_(std::move(frames)) {}
+
+std::string Closure::to_string() const {
+  std::string out = "fn(";
+  for (const auto& param : function_->parameters) {
+    out += param->to_string() + ", ";
+  }
+  out += ") {\n" + function_->body->to_string() + "\n}";
+  return out;
+}
+
+bool Closure::operator==(const Object& other) const {
+  const auto* closure = dynamic_cast<const Closure*>(&other);
+  return closure != nullptr && function_ == closure->function_;
+}
+
+bool Closure::operator!=(const Object& other) const {
+  return !(*this == other);
+}
+
+namespace {
+
+using eval::boolean;
+using eval::box;
+using eval::failed;
+using eval::integer;
+using eval::unbox;
+using eval::Value;
+using eval::wrap;
+
+lexer::TokenType token(compiler::Opcode opcode) {
+  switch (opcode) {
+    case compiler::Opcode::kAdd:
+      return lexer::TokenType::kPlus;
+    case compiler::Opcode::kSubtract:
+    case compiler::Opcode::kMinus:
+      return lexer::TokenType::kMinus;
+    case compiler::Opcode::kMultiply:
+      return lexer::TokenType::kAsterisk;
+    case compiler::Opcode::kDivide:
+      return lexer::TokenType::kSlash;
+    case compiler::Opcode::kLessThan:
+      return lexer::TokenType::kLessThan;
+    case compiler::Opcode::kGreaterThan:
+      return lexer::TokenType::kGreaterThan;
+    case compiler::Opcode::kEqual:
+      return lexer::TokenType::kEqual;
+    case compiler::Opcode::kNotEqual:
+      return lexer::TokenType::kNotEqual;
+    default:
+      return lexer::TokenType::kBang;
+  }
+}
+
+uint32_t read(const uint8_t*& ip) {
+  uint32_t operand = 0;
+  std::memcpy(&operand, ip, sizeof(operand));
+  ip += sizeof(operand);
+  return operand;
+}
+
+// A call in progress, or the top level.
+struct Frame {
+  const std::shared_ptr<const compiler::Module>* module;
+  const compiler::CompiledFunction* function;
+  // Null at the top level.
+  const Closure* closure;
+  // Where to resume once a call made from this frame returns.
+  const uint8_t* ip;
+  // The first slot on the value stack; the closure called is just below.
+  size_t base;
+  // The slots when they are not on the value stack: those of a call whose
+  // frame escapes, or of the top-level block being run.
+  std::shared_ptr<object::Env> env;
+};
+
+// Calls push a frame rather than recursing, so the depth of recursion is
+// only bounded by memory.
+class Machine {
+ public:
+  explicit Machine(std::shared_ptr<object::Env> globals)
+      : globals_(std::move(globals)),
+        null_(std::make_shared<object::Null>()) {}
+
+  std::shared_ptr<object::Object> run(
+      const std::shared_ptr<const compiler::Module>& module) {
+    frames_.push_back({.module = &module,
+                       .function = &module->functions.front(),
+                       .closure = nullptr,
+                       .ip = nullptr,
+                       .base = 0,
+                       .env = nullptr});
+    return execute();
+  }
+
+ private:
+  std::shared_ptr<object::Object> execute() {
+    auto* frame = &frames_.back();
+    const auto* module = frame->module->get();
+    const auto* code = frame->function->code.data();
+    const auto* ip = code;
+    for (;;) {
+      const auto opcode = static_cast<compiler::Opcode>(*ip++);
+      switch (opcode) {
+        case compiler::Opcode::kInteger:
+          stack_.push_back(integer(module->integers[read(ip)]));
+          break;
+        case compiler::Opcode::kConstant:
+          stack_.push_back(wrap(module->constants[read(ip)]));
+          break;
+        case compiler::Opcode::kTrue:
+          stack_.push_back(boolean(true));
+          break;
+        case compiler::Opcode::kFalse:
+          stack_.push_back(boolean(false));
+          break;
+        case compiler::Opcode::kNull:
+          stack_.push_back(wrap(null_));
+          break;
+        case compiler::Opcode::kPop:
+          stack_.pop_back();
+          break;
+        case compiler::Opcode::kGetLocal:
+          stack_.push_back(stack_[frame->base + read(ip)]);
+          break;
+        case compiler::Opcode::kSetLocal:
+          stack_[frame->base + read(ip)] = stack_.back();
+          break;
+        case compiler::Opcode::kGetSlot:
+          stack_.push_back(unbox(frame->env->slot(read(ip))));
+          break;
+        case compiler::Opcode::kSetSlot:
+          frame->env->set_slot(read(ip), box(stack_.back()));
+          break;
+        case compiler::Opcode::kGetCapture:
+          stack_.push_back(unbox(frame->closure->captures()[read(ip)]));
+          break;
+        case compiler::Opcode::kGetGlobal: {
+          const auto symbol = module->names[read(ip)].symbol;
+          auto value = globals_->get(symbol);
+          if (value == nullptr) {
+            return eval::error::unknown_identifier(symbol.name());
+          }
+          stack_.push_back(unbox(std::move(value)));
+          break;
+        }
+        case compiler::Opcode::kSetGlobal:
+          globals_->set(module->names[read(ip)].symbol, box(stack_.back()));
+          break;
+        case compiler::Opcode::kGetName: {
+          const auto& name = module->names[read(ip)];
+          auto value = lookup(name, *frame);
+          if (value.kind == Value::Kind::kUnset) {
+            return eval::error::unknown_identifier(name.symbol.name());
+          }
+          stack_.push_back(std::move(value));
+          break;
+        }
+        case compiler::Opcode::kMinus:
+        case compiler::Opcode::kBang: {
+          auto result = eval::evalPrefixOperator(token(opcode),
+                                                 std::move(stack_.back()));
+          if (failed(result)) {
+            return std::move(result.object);
+          }
+          stack_.back() = std::move(result);
+          break;
+        }
+        case compiler::Opcode::kAdd:
+        case compiler::Opcode::kSubtract:
+        case compiler::Opcode::kMultiply:
+        case compiler::Opcode::kDivide:
+        case compiler::Opcode::kLessThan:
+        case compiler::Opcode::kGreaterThan:
+        case compiler::Opcode::kEqual:
+        case compiler::Opcode::kNotEqual: {
+          auto right = std::move(stack_.back());
+          stack_.pop_back();
+          auto result = eval::evalInfixOperator(
+              token(opcode), std::move(stack_.back()), std::move(right));
+          if (failed(result)) {
+            return std::move(result.object);
+          }
+          stack_.back() = std::move(result);
+          break;
+        }
+        case compiler::Opcode::kJump:
+          ip = code + read(ip);
+          break;
+        case compiler::Opcode::kJumpIfFalse: {
+          const auto target = read(ip);
+          const auto condition = eval::isTruthy(stack_.back());
+          stack_.pop_back();
+          if (!condition) {
+            ip = code + target;
+          }
+          break;
+        }
+        case compiler::Opcode::kArray: {
+          const auto size = read(ip);
+          std::vector<std::shared_ptr<object::Object>> elements;
+          elements.reserve(size);
+          for (auto it = stack_.end() - static_cast<ptrdiff_t>(size);
+               it != stack_.end(); ++it) {
+            elements.push_back(box(std::move(*it)));
+          }
+          stack_.resize(stack_.size() - size);
+          stack_.push_back(
+              wrap(std::make_shared<object::Array>(std::move(elements))));
+          break;
+        }
+        case compiler::Opcode::kHash: {
+          const auto size = size_t{read(ip)} * 2;
+          object::Hash::HashType pairs;
+          for (auto it = stack_.end() - static_cast<ptrdiff_t>(size);
+               it != stack_.end(); it += 2) {
+            pairs.insert({box(std::move(*it)), box(std::move(*(it + 1)))});
+          }
+          stack_.resize(stack_.size() - size);
+          stack_.push_back(
+              wrap(std::make_shared<object::Hash>(std::move(pairs))));
+          break;
+        }
+        case compiler::Opcode::kIndex: {
+          auto index = box(std::move(stack_.back()));
+          stack_.pop_back();
+          auto result =
+              eval::evalIndexOperator(box(std::move(stack_.back())), index);
+          if (result->type() == object::ObjectType::kError) {
+            return result;
+          }
+          stack_.back() = unbox(std::move(result));
+          break;
+        }
+        case compiler::Opcode::kCall: {
+          const auto count = read(ip);
+          const auto base = stack_.size() - count;
+          const auto& callee = stack_[base - 1];
+          const auto* closure =
+              callee.kind == Value::Kind::kObject
+                  ? dynamic_cast<const Closure*>(callee.object.get())
+                  : nullptr;
+          if (closure == nullptr) {
+            auto result = call(base);
+            if (result->type() == object::ObjectType::kError) {
+              return result;
+            }
+            stack_.resize(base - 1);
+            stack_.push_back(unbox(std::move(result)));
+            break;
+          }
+          const auto& function = closure->function();
+          if (count != function.parameters.size()) {
+            return eval::error::wrong_number_of_arguments(
+                closure->to_string(), function.parameters.size(), count);
+          }
+          frame->ip = ip;
+          std::shared_ptr<object::Env> env;
+          if (function.frame_escapes) {
+            env = std::make_shared<object::Env>(globals_, function.frame_size);
+            for (uint32_t i = 0; i < count; ++i) {
+              env->set_slot(i, box(std::move(stack_[base + i])));
+            }
+            stack_.resize(base);
+          } else {
+            stack_.resize(base + function.frame_size);
+          }
+          frames_.push_back({.module = &closure->module(),
+                             .function = &function,
+                             .closure = closure,
+                             .ip = nullptr,
+                             .base = base,
+                             .env = std::move(env)});
+          frame = &frames_.back();
+          module = frame->module->get();
+          code = function.code.data();
+          ip = code;
+          break;
+        }
+        case compiler::Opcode::kReturn: {
+          if (frames_.size() == 1) {
+            return box(std::move(stack_.back()));
+          }
+          auto result = std::move(stack_.back());
+          stack_.resize(frame->base - 1);
+          stack_.push_back(std::move(result));
+          frames_.pop_back();
+          frame = &frames_.back();
+          module = frame->module->get();
+          code = frame->function->code.data();
+          ip = frame->ip;
+          break;
+        }
+        case compiler::Opcode::kClosure:
+          stack_.push_back(
+              wrap(make_closure(*frame->module, read(ip), *frame)));
+          break;
+        case compiler::Opcode::kEnterBlock:
+          frame->env = std::make_shared<object::Env>(globals_, read(ip));
+          break;
+        case compiler::Opcode::kLeaveBlock:
+          frame->env = nullptr;
+          break;
+      }
+    }
+  }
+
+  // Unset if no address has the name bound yet and there is no global of
+  // that name either.
+  Value lookup(const compiler::Name& name, const Frame& frame) const {
+    for (const auto address : name.addresses) {
+      switch (address.kind) {
+        case ast::Address::Kind::kLocal:
+          if (frame.env == nullptr) {
+            if (const auto& value = stack_[frame.base + address.index];
+                value.kind != Value::Kind::kUnset) {
+              return value;
+            }
+          } else if (const auto& value = frame.env->slot(address.index)) {
+            return unbox(value);
+          }
+          break;
+        case ast::Address::Kind::kCapture:
+          if (const auto& value = frame.closure->captures()[address.index]) {
+            return unbox(value);
+          }
+          break;
+        case ast::Address::Kind::kFrame:
+          if (const auto& value = frame.closure->frames()[address.index]->slot(
+                  address.slot)) {
+            return unbox(value);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    if (auto value = globals_->get(name.symbol)) {
+      return unbox(std::move(value));
+    }
+    return {};
+  }
+
+  // Anything but a closure is called as the evaluator would, builtins
+  // included.
+  std::shared_ptr<object::Object> call(size_t base) {
+    std::vector<std::shared_ptr<object::Object>> args;
+    args.reserve(stack_.size() - base);
+    for (auto i = base; i < stack_.size(); ++i) {
+      args.push_back(box(std::move(stack_[i])));
+    }
+    return eval::applyFunction(box(std::move(stack_[base - 1])), args);
+  }
+
+  std::shared_ptr<Closure> make_closure(
+      const std::shared_ptr<const compiler::Module>& module, uint32_t index,
+      const Frame& frame) const {
+    const auto& function = module->functions[index];
+    std::vector<std::shared_ptr<object::Object>> captures;
+    captures.reserve(function.captures.size());
+    for (const auto capture : function.captures) {
+      if (capture.source != ast::Capture::Source::kSlot) {
+        captures.push_back(frame.closure->captures()[capture.index]);
+      } else if (frame.env == nullptr) {
+        captures.push_back(box(stack_[frame.base + capture.index]));
+      } else {
+        captures.push_back(frame.env->slot(capture.index));
+      }
+    }
+    std::vector<std::shared_ptr<object::Env>> frames;
+    frames.reserve(function.captured_frames.size());
+    for (const auto capture : function.captured_frames) {
+      frames.push_back(capture.source == ast::Capture::Source::kFrame
+                           ? frame.env
+                           : frame.closure->frames()[capture.index]);
+    }
+    return std::make_shared<Closure>(module, index, std::move(captures),
+                                     std::move(frames));
+  }
+
+  std::shared_ptr<object::Env> globals_;
+  std::shared_ptr<object::Object> null_;
+  std::vector<Value> stack_;
+  std::vector<Frame> frames_;
+};
+
+}  // namespace
+
+std::shared_ptr<object::Object> run(const ast::Program& program,
+                                    std::shared_ptr<object::Env>& env) {
+  const auto module = compiler::compile(program);
+  if (program.statements().empty()) {
+    return nullptr;
+  }
+  return run(module, env);
+}
+
+std::shared_ptr<object::Object> run(
+    const std::shared_ptr<const compiler::Module>& module,
+    std::shared_ptr<object::Env>& env) {
+  return Machine(env).run(module);
+}
+
+}  // namespace monkey::vm
@@ -1,15 +1,36 @@
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <monkey/ast/ast.h>
+#include <monkey/ast/binary.h>
+#include <monkey/ast/expr.h>
+#include <monkey/eval/compiled.h>
 #include <monkey/eval/eval.h>
 #include <monkey/lexer/lexer.h>
+#include <monkey/lexer/location.h>
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/stream.h>
 #include <monkey/object/env.h>
+#include <monkey/object/memo.h>
 #include <monkey/object/object.h>
+#include <monkey/opt/optimizer.h>
+#include <monkey/parser/cache.h>
+#include <monkey/parser/parallel.h>
 #include <monkey/parser/parser.h>
+#include <monkey/vm/vm.h>
 
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
 #include <exception>
+#include <functional>
 #include <iostream>
+#include <istream>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
 
 static const std::string kPrompt = ">> ";
 static const std::string kMonkey = R"(
@@ -38,36 +59,302 @@ void print_preface() {
   fmt::print("Feel free to type in commands\n");
 }
 
-int main() {
-  auto env = std::make_shared<monkey::object::Env>();
+enum class Engine {
+  // Walks the tree.
+  kAst,
+  // Compiles each program to bytecode for the stack machine.
+  kVm,
+  // Compiles each program to a tree of closures and calls the root.
+  kClosure,
+};
+
+struct Options {
+  // Empty runs the REPL and "-" reads the program from stdin.
+  std::string path;
+  // Threads used to parse a file; 1 streams it statement batch by batch and
+  // 0 uses every hardware thread.
+  size_t jobs = 1;
+  // Only parse the file, listing every syntax error instead of running it.
+  bool check = false;
+  // Optimizer passes to run on each program before it is evaluated.
+  int opt_level = 0;
+  // Print the time and rewrites of each optimizer pass on exit.
+  bool opt_stats = false;
+  // Print how many infix expressions the tree-walker specialized on exit.
+  bool quicken_stats = false;
+  // Directory of parsed programs reused across runs; empty disables it.
+  std::string cache;
+  // Results cached by every pure function that captures nothing, as if each
+  // were wrapped in memo(); 0 disables it.
+  size_t memo = 0;
+  Engine engine = Engine::kAst;
+};
+
+// State shared by everything run in one invocation.
+struct Session {
+  std::shared_ptr<monkey::object::Env> env =
+      std::make_shared<monkey::object::Env>();
+  monkey::opt::Optimizer optimizer;
+  Engine engine = Engine::kAst;
+};
+
+// Optimizes and evaluates a parsed program, reporting errors. When echo is
+// set the resulting value is printed, as the REPL does.
+bool evaluate(const std::shared_ptr<monkey::ast::Program>& program,
+              Session& session, bool echo) {
+  const auto optimized = session.optimizer.run(program);
+  std::shared_ptr<monkey::object::Object> evaluated;
+  switch (session.engine) {
+    case Engine::kAst:
+      evaluated = monkey::eval::eval(*optimized, session.env);
+      break;
+    case Engine::kVm:
+      evaluated = monkey::vm::run(*optimized, session.env);
+      break;
+    case Engine::kClosure:
+      evaluated = monkey::eval::evalCompiled(*optimized, session.env);
+      break;
+  }
+  if (evaluated == nullptr) {
+    return true;
+  }
+  if (evaluated->type() == monkey::object::ObjectType::kError) {
+    print_error("RuntimeError: " +
+                dynamic_cast<monkey::object::Error&>(*evaluated).message());
+    return false;
+  }
+  if (echo) {
+    fmt::print("{}\n", evaluated->to_string());
+  }
+  return true;
+}
+
+bool execute(monkey::parser::Parser& parser, Session& session, bool echo) {
+  std::shared_ptr<monkey::ast::Program> program;
+  try {
+    program = parser.parse_program();
+  } catch (const std::exception& e) {
+    print_error(e.what());
+    return false;
+  }
+  return evaluate(program, session, echo);
+}
+
+// Runs each batch of top-level statements as soon as it has been lexed, so
+// that only the statements in flight are held in memory.
+template <typename BatchLexer>
+bool run_batches(BatchLexer& lexer, Session& session) {
+  while (auto batch = lexer.next_batch()) {
+    auto p = monkey::parser::Parser(std::move(batch->tokens));
+    if (!execute(p, session, false)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Lexes the file straight out of a read-only mapping, either streaming it or
+// parsing all of it up front on several threads. With a cache the program is
+// always parsed whole, so that it can be stored for the next run.
+int run_file(const Options& options, Session& session) {
+  std::shared_ptr<const monkey::lexer::Source> source;
+  try {
+    source = std::make_shared<monkey::lexer::MappedFileSource>(options.path);
+  } catch (const std::exception& e) {
+    print_error(e.what());
+    return 1;
+  }
+  if (options.jobs == 1 && options.cache.empty()) {
+    auto lexer = monkey::lexer::BatchedLexer(source);
+    return run_batches(lexer, session) ? 0 : 1;
+  }
+
+  const auto cache = monkey::parser::ProgramCache(options.cache);
+  const auto key = monkey::ast::source_key(source->text());
+  auto program = options.cache.empty() ? nullptr : cache.load(key);
+  if (program == nullptr) {
+    try {
+      program = monkey::parser::ParallelParser(source, options.jobs)
+                    .parse_program();
+    } catch (const std::exception& e) {
+      print_error(e.what());
+      return 1;
+    }
+    if (!options.cache.empty() && !cache.store(key, *program)) {
+      fmt::print(stderr, "could not write {}\n", cache.path(key).string());
+    }
+  }
+  return evaluate(program, session, false) ? 0 : 1;
+}
+
+int check_file(const std::string& path) {
+  std::shared_ptr<const monkey::lexer::Source> source;
+  try {
+    source = std::make_shared<monkey::lexer::MappedFileSource>(path);
+  } catch (const std::exception& e) {
+    print_error(e.what());
+    return 1;
+  }
+  auto lexer = monkey::lexer::Lexer(source);
+  const auto result = monkey::parser::Parser(lexer).parse_program_recovering();
+  const auto lines = monkey::lexer::LineTable(source);
+  for (const auto& diagnostic : result.diagnostics) {
+    const auto location = lines.locate(diagnostic.token.offset());
+    fmt::print("{}:{}:{}: {}\n", path, location.line, location.column,
+               diagnostic.message);
+  }
+  return result.ok() ? 0 : 1;
+}
+
+int run_stream(std::istream& input, Session& session) {
+  constexpr size_t kChunkSize = 1 << 16;
+  auto lexer = monkey::lexer::ChunkedLexer();
+  auto chunk = std::string(kChunkSize, '\0');
+  while (input) {
+    input.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    lexer.feed(
+        std::string_view(chunk.data(), static_cast<size_t>(input.gcount())));
+    if (!run_batches(lexer, session)) {
+      return 1;
+    }
+  }
+  lexer.finish();
+  return run_batches(lexer, session) ? 0 : 1;
+}
+
+void run_repl(Session& session) {
   print_preface();
   while (true) {
     fmt::print("{}", kPrompt);
     std::string input;
-    std::getline(std::cin, input);
-    if (input == "exit") {
+    if (!std::getline(std::cin, input) || input == "exit") {
       break;
     }
 
     auto l = monkey::lexer::Lexer(input);
     auto p = monkey::parser::Parser(l);
-    std::shared_ptr<monkey::ast::Program> program;
-    try {
-      program = p.parse_program();
-    } catch (const std::exception& e) {
-      print_error(e.what());
-      continue;
-    }
+    execute(p, session, true);
+  }
+}
 
-    auto evaluated = monkey::eval::eval(*program, env);
-    if (evaluated != nullptr) {
-      if (evaluated->type() == monkey::object::ObjectType::kError) {
-        print_error("RuntimeError: " +
-                    dynamic_cast<monkey::object::Error&>(*evaluated).message());
-        continue;
+bool parse_options(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    const auto arg = std::string_view(argv[i]);
+    if (arg.starts_with("--jobs=")) {
+      const auto value = arg.substr(std::string_view("--jobs=").size());
+      const auto [end, error] = std::from_chars(
+          value.data(), value.data() + value.size(), options.jobs);
+      if (error != std::errc() || end != value.data() + value.size()) {
+        print_error(fmt::format("invalid job count: {}", value));
+        return false;
       }
-      fmt::print("{}\n", evaluated->to_string());
+    } else if (arg.starts_with("--opt-level=")) {
+      const auto value = arg.substr(std::string_view("--opt-level=").size());
+      const auto [end, error] = std::from_chars(
+          value.data(), value.data() + value.size(), options.opt_level);
+      if (error != std::errc() || end != value.data() + value.size() ||
+          options.opt_level < 0 ||
+          options.opt_level > monkey::opt::Optimizer::kMaxLevel) {
+        print_error(fmt::format("invalid optimization level: {}", value));
+        return false;
+      }
+    } else if (arg == "--memo") {
+      options.memo = monkey::object::MemoTable::kDefaultCapacity;
+    } else if (arg.starts_with("--memo=")) {
+      const auto value = arg.substr(std::string_view("--memo=").size());
+      const auto [end, error] = std::from_chars(
+          value.data(), value.data() + value.size(), options.memo);
+      if (error != std::errc() || end != value.data() + value.size()) {
+        print_error(fmt::format("invalid memo capacity: {}", value));
+        return false;
+      }
+    } else if (arg == "--engine=ast") {
+      options.engine = Engine::kAst;
+    } else if (arg == "--engine=vm") {
+      options.engine = Engine::kVm;
+    } else if (arg == "--engine=closure") {
+      options.engine = Engine::kClosure;
+    } else if (arg.starts_with("--engine=")) {
+      const auto value = arg.substr(std::string_view("--engine=").size());
+      print_error(fmt::format("unknown engine: {}", value));
+      return false;
+    } else if (arg.starts_with("--cache=")) {
+      options.cache = arg.substr(std::string_view("--cache=").size());
+    } else if (arg == "--opt-stats") {
+      options.opt_stats = true;
+    } else if (arg == "--quicken-stats") {
+      options.quicken_stats = true;
+    } else if (arg == "--check") {
+      options.check = true;
+    } else if (arg.starts_with("--")) {
+      print_error(fmt::format("unknown option: {}", arg));
+      return false;
+    } else {
+      options.path = arg;
     }
   }
+  if (options.check && (options.path.empty() || options.path == "-")) {
+    print_error("--check needs a script file");
+    return false;
+  }
+  return true;
+}
+
+void print_opt_stats(const monkey::opt::Optimizer& optimizer) {
+  std::fflush(stdout);
+  for (const auto& stats : optimizer.stats()) {
+    fmt::print(stderr, "{:<16} {:>10} rewrites {:>10.3f} ms\n", stats.name,
+               stats.rewrites,
+               std::chrono::duration<double, std::milli>(stats.time).count());
+  }
+}
+
+void print_quicken_stats() {
+  std::fflush(stdout);
+  const auto& stats = monkey::eval::quickening_stats();
+  for (size_t i = 1; i < stats.sites.size(); ++i) {
+    fmt::print(
+        stderr, "{:<16} {:>10} sites\n",
+        monkey::ast::to_string(
+            static_cast<monkey::ast::InfixExpression::Specialization>(i)),
+        stats.sites[i]);
+  }
+  fmt::print(stderr, "{:<16} {:>10}\n", "deoptimizations",
+             stats.deoptimizations);
+}
+
+int run(const Options& options, Session& session) {
+  if (options.path == "-") {
+    return run_stream(std::cin, session);
+  }
+  if (options.check) {
+    return check_file(options.path);
+  }
+  if (!options.path.empty()) {
+    return run_file(options, session);
+  }
+  run_repl(session);
   return 0;
 }
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    fmt::print(
+        "usage: Monkey [--jobs=N] [--cache=DIR] [--opt-level=0-2] "
+        "[--opt-stats] [--quicken-stats] [--memo[=N]] "
+        "[--engine=ast|vm|closure] [--check] [script | -]\n");
+    return 2;
+  }
+  auto session = Session{.optimizer = monkey::opt::Optimizer(options.opt_level),
+                         .engine = options.engine};
+  session.env->set_memo_capacity(options.memo);
+  const auto status = run(options, session);
+  if (options.opt_stats) {
+    print_opt_stats(session.optimizer);
+  }
+  if (options.quicken_stats) {
+    print_quicken_stats();
+  }
+  return status;
+}
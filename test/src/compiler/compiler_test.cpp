@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <monkey/compiler/bytecode.h>
+#include <monkey/compiler/compiler.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/object/env.h>
+#include <monkey/parser/parser.h>
+#include <monkey/vm/vm.h>
+
+#include <memory>
+#include <string>
+
+namespace monkey::compiler {
+
+std::string compile(const std::string& input) {
+  auto lexer = lexer::Lexer(input);
+  return disassemble(*compile(*parser::Parser(lexer).parse_program()));
+}
+
+TEST(MonkeyCompilerTest, Functions) {
+  // Locals of a frame nothing keeps are stack slots; y is copied.
+  ASSERT_EQ(compile("let f = fn(x) { if (x < 1) { 0 } else { let y = x; "
+                    "fn() { y } } }; f(2)"),
+            "function 0 (0 slots)\n"
+            "0000 closure 1\n"
+            "0005 set_global 0\n"
+            "0010 pop\n"
+            "0011 get_global 0\n"
+            "0016 integer 2\n"
+            "0021 call 1\n"
+            "0026 return\n"
+            "function 1 (2 slots)\n"
+            "0000 get_local 0\n"
+            "0005 integer 0\n"
+            "0010 less_than\n"
+            "0011 jump_if_false 26\n"
+            "0016 integer 1\n"
+            "0021 jump 42\n"
+            "0026 get_local 0\n"
+            "0031 set_local 1\n"
+            "0036 pop\n"
+            "0037 closure 2\n"
+            "0042 return\n"
+            "function 2 (0 slots)\n"
+            "0000 get_capture 0\n"
+            "0005 return\n");
+}
+
+TEST(MonkeyCompilerTest, Frames) {
+  // g keeps mk's frame to find y, which is looked up by name.
+  ASSERT_EQ(compile("let mk = fn(x) { let g = fn() { y }; let y = x; g }; "
+                    "mk(1)()"),
+            "function 0 (0 slots)\n"
+            "0000 closure 1\n"
+            "0005 set_global 1\n"
+            "0010 pop\n"
+            "0011 get_global 1\n"
+            "0016 integer 0\n"
+            "0021 call 1\n"
+            "0026 call 0\n"
+            "0031 return\n"
+            "function 1 (3 slots, escapes)\n"
+            "0000 closure 2\n"
+            "0005 set_slot 1\n"
+            "0010 pop\n"
+            "0011 get_slot 0\n"
+            "0016 set_slot 2\n"
+            "0021 pop\n"
+            "0022 get_slot 1\n"
+            "0027 return\n"
+            "function 2 (0 slots)\n"
+            "0000 get_name 0\n"
+            "0005 return\n");
+  ASSERT_EQ(compile("if (true) { let a = 1; a }"),
+            "function 0 (0 slots)\n"
+            "0000 true\n"
+            "0001 jump_if_false 33\n"
+            "0006 enter_block 1\n"
+            "0011 integer 0\n"
+            "0016 set_slot 0\n"
+            "0021 pop\n"
+            "0022 get_slot 0\n"
+            "0027 leave_block\n"
+            "0028 jump 34\n"
+            "0033 null\n"
+            "0034 return\n");
+}
+
+TEST(MonkeyCompilerTest, DeepRecursion) {
+  // Calls do not recurse in the machine, so depth is only bounded by memory.
+  auto lexer = lexer::Lexer(
+      "let sum = fn(n) { if (n == 0) { 0 } else { n + sum(n - 1) } }; "
+      "sum(100000)");
+  auto env = std::make_shared<object::Env>();
+  ASSERT_EQ(vm::run(*parser::Parser(lexer).parse_program(), env)->to_string(),
+            "5000050000");
+}
+
+}  // namespace monkey::compiler
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,18 +1,60 @@
 #include <gtest/gtest.h>
+#include <monkey/ast/expr.h>
+#include <monkey/ast/stmt.h>
+#include <monkey/eval/compiled.h>
 #include <monkey/eval/eval.h>
+#include <monkey/eval/flat.h>
 #include <monkey/lexer/lexer.h>
 #include <monkey/object/env.h>
 #include <monkey/parser/parser.h>
+#include <monkey/vm/vm.h>
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace monkey::eval {
 
-TEST(MonkeyEvalTest, IntegerLiteral) {
+enum class Engine { kAst, kVm, kClosure };
+
+// Runs every program on the engine under test, which must agree with the
+// tree-walking evaluator on values and errors alike.
+class MonkeyEvalTest : public ::testing::TestWithParam<Engine> {
+ protected:
+  std::shared_ptr<object::Object> run(const ast::Program& program,
+                                      std::shared_ptr<object::Env>& env) {
+    switch (GetParam()) {
+      case Engine::kVm:
+        return vm::run(program, env);
+      case Engine::kClosure:
+        return evalCompiled(program, env);
+      default:
+        return eval(program, env);
+    }
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(Engines, MonkeyEvalTest,
+                         ::testing::Values(Engine::kAst, Engine::kVm,
+                                           Engine::kClosure),
+                         [](const auto& engine) {
+                           switch (engine.param) {
+                             case Engine::kVm:
+                               return "vm";
+                             case Engine::kClosure:
+                               return "closure";
+                             default:
+                               return "ast";
+                           }
+                         });
+
+TEST_P(MonkeyEvalTest, IntegerLiteral) {
   auto inputs = std::vector<std::string>{"5",
                                          "10",
                                          "-5",
@@ -31,34 +73,34 @@ TEST(MonkeyEvalTest, IntegerLiteral) {
   auto expecteds = std::vector<int64_t>{5,  10, -5, -10, 10, 32, 0, 20,
                                         25, 0,  60, 30,  37, 37, 50};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == std::to_string(expected);
+        return run(*program, env)->to_string() == std::to_string(expected);
       }));
 }
 
-TEST(MonkeyEvalTest, BooleanLiteral) {
+TEST_P(MonkeyEvalTest, BooleanLiteral) {
   auto inputs = std::vector<std::string>{
       "true",  "false",  "1 < 2",  "1 > 2",  "1 < 1",
       "1 > 1", "1 == 1", "1 != 1", "1 == 2", "1 != 2",
   };
   auto expecteds = std::vector<bool>{true,  false, true,  false, false,
                                      false, true,  false, false, true};
-  ASSERT_TRUE(std::ranges::equal(inputs, expecteds,
-                                 [](const auto& input, const auto& expected) {
-                                   auto l = lexer::Lexer(input);
-                                   auto p = parser::Parser(l);
-                                   auto program = p.parse_program();
-                                   auto env = std::make_shared<object::Env>();
-                                   return eval(*program, env)->to_string() ==
-                                          (expected ? "true" : "false");
-                                 }));
+  ASSERT_TRUE(std::ranges::equal(
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
+        auto l = lexer::Lexer(input);
+        auto p = parser::Parser(l);
+        auto program = p.parse_program();
+        auto env = std::make_shared<object::Env>();
+        return run(*program, env)->to_string() ==
+               (expected ? "true" : "false");
+      }));
 }
 
-TEST(MonkeyEvalTest, PrefixExpression) {
+TEST_P(MonkeyEvalTest, PrefixExpression) {
   auto inputs = std::vector<std::string>{
       "!true", "!false", "!!true", "!!false",   "!5",          "!!5",
       "-5",    "-10",    "--10",   "-(-(-10))", "-(-(-(-10)))"};
@@ -66,16 +108,16 @@ TEST(MonkeyEvalTest, PrefixExpression) {
                                             "false", "true", "-5",   "-10",
                                             "10",    "-10",  "10"};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == expected;
+        return run(*program, env)->to_string() == expected;
       }));
 }
 
-TEST(MonkeyEvalTest, IfExpression) {
+TEST_P(MonkeyEvalTest, IfExpression) {
   auto inputs = std::vector<std::string>{"if (true) { 10 }",
                                          "if (false) { 10 }",
                                          "if (1) { 10 }",
@@ -86,16 +128,16 @@ TEST(MonkeyEvalTest, IfExpression) {
   auto expecteds =
       std::vector<std::string>{"10", "null", "10", "10", "null", "20", "10"};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == expected;
+        return run(*program, env)->to_string() == expected;
       }));
 }
 
-TEST(MonkeyEvalTest, ReturnStatement) {
+TEST_P(MonkeyEvalTest, ReturnStatement) {
   auto inputs = std::vector<std::string>{
       "return 10;", "return 10; 9;", "return 2 * 5; 9;", "9; return 2 * 5; 9;",
       R"(
@@ -109,16 +151,16 @@ TEST(MonkeyEvalTest, ReturnStatement) {
   };
   auto expecteds = std::vector<int64_t>{10, 10, 10, 10, 10};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == std::to_string(expected);
+        return run(*program, env)->to_string() == std::to_string(expected);
       }));
 }
 
-TEST(MonkeyEvalTest, ErrorHandling) {
+TEST_P(MonkeyEvalTest, ErrorHandling) {
   auto inputs = std::vector<std::string>{"5 + true;",
                                          "5 + true; 5;",
                                          "-true",
@@ -157,31 +199,31 @@ TEST(MonkeyEvalTest, ErrorHandling) {
       "ERROR: wrong index types for []: HASH[FUNCTION]",
   };
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == expected;
+        return run(*program, env)->to_string() == expected;
       }));
 }
 
-TEST(MonkeyEvalTest, LetStatement) {
+TEST_P(MonkeyEvalTest, LetStatement) {
   auto inputs = std::vector<std::string>{
       "let a = 5; a;", "let a = 5 * 5; a;", "let a = 5; let b = a; b;",
       "let a = 5; let b = a; let c = a + b + 5; c;"};
   auto expecteds = std::vector<int64_t>{5, 25, 5, 15};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == std::to_string(expected);
+        return run(*program, env)->to_string() == std::to_string(expected);
       }));
 }
 
-TEST(MonkeyEvalTest, CallExpression) {
+TEST_P(MonkeyEvalTest, CallExpression) {
   auto inputs = std::vector<std::string>{
       "let identity = fn(x) { x; }; identity(5);",
       "let identity = fn(x) { return x; }; identity(5);",
@@ -199,32 +241,32 @@ TEST(MonkeyEvalTest, CallExpression) {
   };
   auto expecteds = std::vector<int64_t>{5, 5, 10, 10, 20, 5, 4};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == std::to_string(expected);
+        return run(*program, env)->to_string() == std::to_string(expected);
       }));
 }
 
-TEST(MonkeyEvalTest, StringLiteral) {
+TEST_P(MonkeyEvalTest, StringLiteral) {
   auto inputs = std::vector<std::string>{
       R"("Hello World!")",
       R"("Hello" + " " + "World!")",
   };
   auto expecteds = std::vector<std::string>{"Hello World!", "Hello World!"};
   ASSERT_TRUE(std::ranges::equal(
-      inputs, expecteds, [](const auto& input, const auto& expected) {
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
         auto l = lexer::Lexer(input);
         auto p = parser::Parser(l);
         auto program = p.parse_program();
         auto env = std::make_shared<object::Env>();
-        return eval(*program, env)->to_string() == expected;
+        return run(*program, env)->to_string() == expected;
       }));
 }
 
-TEST(MonkeyEvalTest, ArrayLiteral) {
+TEST_P(MonkeyEvalTest, ArrayLiteral) {
   auto inputs =
       std::vector<std::string>{"[]", "[1, 2, 3]", "[1 + 2, 3 * 4, 5 + 6]"};
   auto expecteds = std::vector<std::string>{
@@ -232,18 +274,18 @@ TEST(MonkeyEvalTest, ArrayLiteral) {
       "[1, 2, 3, ]",
       "[3, 12, 11, ]",
   };
-  ASSERT_TRUE(std::ranges::equal(inputs, expecteds,
-                                 [](const auto& input, const auto& expected) {
-                                   auto l = lexer::Lexer(input);
-                                   auto p = parser::Parser(l);
-                                   auto program = p.parse_program();
-                                   auto env = std::make_shared<object::Env>();
-                                   auto result = eval(*program, env);
-                                   return result->to_string() == expected;
-                                 }));
+  ASSERT_TRUE(std::ranges::equal(
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
+        auto l = lexer::Lexer(input);
+        auto p = parser::Parser(l);
+        auto program = p.parse_program();
+        auto env = std::make_shared<object::Env>();
+        auto result = run(*program, env);
+        return result->to_string() == expected;
+      }));
 }
 
-TEST(MonkeyEvalTest, IndexExpression) {
+TEST_P(MonkeyEvalTest, IndexExpression) {
   auto inputs = std::vector<std::string>{
       "[1, 2, 3][0]",
       "[1, 2, 3][1]",
@@ -275,18 +317,18 @@ TEST(MonkeyEvalTest, IndexExpression) {
       "1",    "2", "3",    "1", "3",    "3", "6", "2", "null",
       "null", "5", "null", "5", "null", "5", "5", "5",
   };
-  ASSERT_TRUE(std::ranges::equal(inputs, expecteds,
-                                 [](const auto& input, const auto& expected) {
-                                   auto l = lexer::Lexer(input);
-                                   auto p = parser::Parser(l);
-                                   auto program = p.parse_program();
-                                   auto env = std::make_shared<object::Env>();
-                                   auto result = eval(*program, env);
-                                   return result->to_string() == expected;
-                                 }));
+  ASSERT_TRUE(std::ranges::equal(
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
+        auto l = lexer::Lexer(input);
+        auto p = parser::Parser(l);
+        auto program = p.parse_program();
+        auto env = std::make_shared<object::Env>();
+        auto result = run(*program, env);
+        return result->to_string() == expected;
+      }));
 }
 
-TEST(MonkeyEvalTest, HashLiteral) {
+TEST_P(MonkeyEvalTest, HashLiteral) {
   auto inputs = std::vector<std::string>{
       "{}",
       "{1: 2, 2: 3}",
@@ -297,18 +339,18 @@ TEST(MonkeyEvalTest, HashLiteral) {
       "{1: 2, 2: 3, }",
       "{2: 4, 6: 16, }",
   };
-  ASSERT_TRUE(std::ranges::equal(inputs, expecteds,
-                                 [](const auto& input, const auto& expected) {
-                                   auto l = lexer::Lexer(input);
-                                   auto p = parser::Parser(l);
-                                   auto program = p.parse_program();
-                                   auto env = std::make_shared<object::Env>();
-                                   auto result = eval(*program, env);
-                                   return result->to_string() == expected;
-                                 }));
+  ASSERT_TRUE(std::ranges::equal(
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
+        auto l = lexer::Lexer(input);
+        auto p = parser::Parser(l);
+        auto program = p.parse_program();
+        auto env = std::make_shared<object::Env>();
+        auto result = run(*program, env);
+        return result->to_string() == expected;
+      }));
 }
 
-TEST(MonkeyEvalTest, Builtins) {
+TEST_P(MonkeyEvalTest, Builtins) {
   auto inputs = std::vector<std::string>{
       "len(\"\")",      "len(\"four\")", "len(\"hello world\")",
       "len([1, 2, 3])", "len(1)",        R"(len("one", "two"))",
@@ -321,15 +363,468 @@ TEST(MonkeyEvalTest, Builtins) {
       "ERROR: wrong argument type for len: expected STRING, got INTEGER",
       "ERROR: wrong number of arguments for len: expected 1, got 2",
   };
-  ASSERT_TRUE(std::ranges::equal(inputs, expecteds,
-                                 [](const auto& input, const auto& expected) {
-                                   auto l = lexer::Lexer(input);
-                                   auto p = parser::Parser(l);
-                                   auto program = p.parse_program();
-                                   auto env = std::make_shared<object::Env>();
-                                   auto result = eval(*program, env);
-                                   return result->to_string() == expected;
-                                 }));
+  ASSERT_TRUE(std::ranges::equal(
+      inputs, expecteds, [this](const auto& input, const auto& expected) {
+        auto l = lexer::Lexer(input);
+        auto p = parser::Parser(l);
+        auto program = p.parse_program();
+        auto env = std::make_shared<object::Env>();
+        auto result = run(*program, env);
+        return result->to_string() == expected;
+      }));
+}
+
+TEST_P(MonkeyEvalTest, Memo) {
+  // Only the tree-walker knows which functions are pure.
+  auto l = lexer::Lexer("let f = memo(fn(n) { n }); f(3)");
+  const auto program = parser::Parser(l).parse_program();
+  auto env = std::make_shared<object::Env>();
+  ASSERT_EQ(run(*program, env)->to_string(),
+            GetParam() == Engine::kAst
+                ? "3"
+                : "ERROR: memo() is not supported on this engine");
+}
+
+TEST_P(MonkeyEvalTest, FunctionOutlivesProgram) {
+  auto env = std::make_shared<object::Env>();
+  {
+    auto l = lexer::Lexer("let add = fn(x) { fn(y) { x + y } };");
+    auto program = parser::Parser(l).parse_program();
+    run(*program, env);
+  }
+  {
+    auto l = lexer::Lexer("let addTwo = add(2);");
+    auto program = parser::Parser(l).parse_program();
+    run(*program, env);
+  }
+  auto l = lexer::Lexer("addTwo(3)");
+  auto program = parser::Parser(l).parse_program();
+  ASSERT_EQ(run(*program, env)->to_string(), "5");
+
+  // The function keeps its nodes alive by itself, wherever it ends up.
+  auto other = std::make_shared<object::Env>();
+  other->set("addTwo", env->get("addTwo"));
+  env.reset();
+  program.reset();
+  auto call = lexer::Lexer("addTwo(4)");
+  ASSERT_EQ(run(*parser::Parser(call).parse_program(), other)->to_string(),
+            "6");
+}
+
+// Each run has its own Env; the nodes are only read once resolved.
+TEST_P(MonkeyEvalTest, ConcurrentRuns) {
+  auto l = lexer::Lexer(
+      "let fib = fn(n) { if (n < 2) { n } else { fib(n - 1) + fib(n - 2) } }; "
+      "let at = fn(a, i) { a[i] }; "
+      "[fib(15), at([1, 2, 3], 1), at({\"k\": \"v\"}, \"k\")]");
+  const auto program = parser::Parser(l).parse_program();
+  std::vector<std::string> results(2);
+  std::vector<std::thread> threads;
+  for (auto& result : results) {
+    threads.emplace_back([&] {
+      auto env = std::make_shared<object::Env>();
+      result = run(*program, env)->to_string();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(results[0], "[610, 2, v, ]");
+  ASSERT_EQ(results[1], results[0]);
+}
+
+TEST_P(MonkeyEvalTest, LexicalScoping) {
+  // Each must find what looking the name up scope by scope at run time does.
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"let f = fn(x) { let g = fn() { x }; let x = 5; g() }; f(1)", "5"},
+      {"let f = fn(x) { if (true) { let y = x; let x = 5; y + x } }; f(1)",
+       "6"},
+      {"let f = fn(x) { let x = x * 10; x }; f(2)", "20"},
+      {"let f = fn() { let g = fn() { h() }; let h = fn() { 7 }; g() }; f()",
+       "7"},
+      {"let x = 1; let f = fn() { let g = fn() { x }; let a = g(); "
+       "let x = 5; [a, g()] }; f()",
+       "[1, 5, ]"},
+      {"let f = fn(x, x) { x }; f(1, 2)", "2"},
+      {"if (true) { let a = 1; let b = fn() { a + c }; let c = 2; b() }", "3"},
+      {"let a = 1; if (true) { let b = a + 1; let a = 10; [a, b] }",
+       "[10, 2, ]"},
+      {"let x = 1; let f = fn() { let h = fn() { x }; "
+       "if (true) { let x = 2; h() } }; f()",
+       "1"},
+      {"let f = fn(a) { fn(b) { fn(c) { a + b + c } } }; f(1)(2)(3)", "6"},
+      {"let f = fn() { let g = fn() { k }; g() }; let k = 9; f()", "9"},
+      {"if (true) { let y = 1; }; y", "ERROR: identifier not found: y"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto l = lexer::Lexer(input);
+    auto env = std::make_shared<object::Env>();
+    ASSERT_EQ(run(*parser::Parser(l).parse_program(), env)->to_string(),
+              expected)
+        << input;
+  }
+}
+
+TEST(MonkeyTreeEvalTest, ClosureCaptures) {
+  auto l = lexer::Lexer(
+      "let make = fn(x, unused) { let y = x * 2; let g = fn() { y + h() }; "
+      "let h = fn() { x }; g }; make(1, [1, 2, 3])");
+  auto env = std::make_shared<object::Env>();
+  const auto result = eval(*parser::Parser(l).parse_program(), env);
+  const auto& closure = dynamic_cast<const object::Function&>(*result);
+  // y is copied; h is not set yet, so g keeps make's frame to find it.
+  ASSERT_EQ(closure.captures().size(), 1);
+  ASSERT_EQ(closure.captures()[0]->to_string(), "2");
+  ASSERT_EQ(closure.frames().size(), 1);
+  ASSERT_EQ(closure.env(), env);
+  auto call = lexer::Lexer("make(5, 0)()");
+  ASSERT_EQ(eval(*parser::Parser(call).parse_program(), env)->to_string(),
+            "15");
+}
+
+TEST_P(MonkeyEvalTest, StackFrames) {
+  // Frames no closure keeps are reused, so nothing may point into them.
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"let mk = fn(x) { fn() { x } }; let a = mk(1); let b = mk(2); "
+       "[a(), b()]",
+       "[1, 2, ]"},
+      {"let mk = fn(x) { let g = fn() { y }; let y = x; g }; "
+       "let a = mk(1); let b = mk(2); [a(), b()]",
+       "[1, 2, ]"},
+      {"let sum = fn(n) { if (n == 0) { 0 } else { n + sum(n - 1) } }; "
+       "[sum(100), sum(3)]",
+       "[5050, 6, ]"},
+      {"if (true) { let a = 1; let f = fn() { a }; f() + 1 }", "2"},
+      {"if (true) { let a = 1; let f = fn() { b }; let b = a; f }()", "1"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto l = lexer::Lexer(input);
+    auto env = std::make_shared<object::Env>();
+    ASSERT_EQ(run(*parser::Parser(l).parse_program(), env)->to_string(),
+              expected)
+        << input;
+  }
+}
+
+TEST_P(MonkeyEvalTest, UnboxedArithmetic) {
+  // Proven subtrees must give the same values and errors as boxed ones.
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"let f = fn(x) { let y = x * 2; let y = y + 1; y == 7 }; f(3)", "true"},
+      {"let f = fn(x) { let y = 1 + 2; if (y > x) { y * 2 } else { -y } }; "
+       "[f(1), f(5)]",
+       "[6, -3, ]"},
+      {"let f = fn(a) { let b = 5; let g = fn() { b * a + 1 }; g() }; f(3)",
+       "16"},
+      {"let f = fn(x) { !x == !!x }; [f(0), f(true), f(false)]",
+       "[false, false, false, ]"},
+      {"if (1 < 2 == true) { 10 } else { 20 }", "10"},
+      {"let f = fn(x) { 1 / (x - x) }; f(3)", "ERROR: division by zero"},
+      {"let f = fn(x) { -x + 1 }; f(true)",
+       "ERROR: wrong operand type for -: -BOOLEAN"},
+      {"let f = fn(x) { x * 2 + true }; f(1)",
+       "ERROR: wrong operand types for +: INTEGER + BOOLEAN"},
+      {"let f = fn(x) { (x + 1) * 2 }; f(\"a\")",
+       "ERROR: wrong operand types for +: STRING + INTEGER"},
+      {"let f = fn(x) { (x < y) == true }; f(1)",
+       "ERROR: identifier not found: y"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto l = lexer::Lexer(input);
+    auto env = std::make_shared<object::Env>();
+    ASSERT_EQ(run(*parser::Parser(l).parse_program(), env)->to_string(),
+              expected)
+        << input;
+  }
+}
+
+TEST(MonkeyTreeEvalTest, Memoization) {
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"let fib = memo(fn(n) { if (n < 2) { return n; } "
+       "fib(n - 1) + fib(n - 2) }); let r = fib(60); "
+       "[r, memo_stats(fib)[\"hits\"], memo_stats(fib)[\"misses\"]]",
+       "[1548008755920, 58, 61, ]"},
+      // Rebinding a global the function reads drops what it cached.
+      {"let k = 1; let f = memo(fn(x) { x + k }); let a = f(1); let k = 2; "
+       "[a, f(1)]",
+       "[2, 3, ]"},
+      // Arrays are compared by value, functions are not cached.
+      {"let f = memo(fn(a) { a }); f([1, [2]]); f([1, [2]]); "
+       "f(fn() { 1 }); f(fn() { 1 }); "
+       "[memo_stats(f)[\"hits\"], memo_stats(f)[\"misses\"]]",
+       "[1, 1, ]"},
+      {"let f = memo(fn(x) { x }, 2); f(1); f(2); f(3); f(1); "
+       "[memo_stats(f)[\"size\"], memo_stats(f)[\"misses\"]]",
+       "[2, 4, ]"},
+      {"let mk = fn(x) { let g = fn() { y }; let y = x; g }; memo(mk(1))",
+       "ERROR: impure function for memo"},
+      {"memo_stats(fn(x) { x })", "null"},
+      {"memo(1)", "ERROR: wrong argument type for memo: expected FUNCTION, "
+                  "got INTEGER"},
+      {"memo()",
+       "ERROR: wrong number of arguments for memo: expected 1 to 2, got 0"},
+      {"memo(fn(x) { x }, 1, 2)",
+       "ERROR: wrong number of arguments for memo: expected 1 to 2, got 3"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto l = lexer::Lexer(input);
+    auto env = std::make_shared<object::Env>();
+    ASSERT_EQ(eval(*parser::Parser(l).parse_program(), env)->to_string(),
+              expected)
+        << input;
+  }
+
+  // Calls with side effects are never answered from the cache.
+  auto env = std::make_shared<object::Env>();
+  env->set_memo_capacity(16);
+  auto l = lexer::Lexer(
+      "let f = fn(x) { puts(x); x }; let g = fn(x) { x * 2 }; "
+      "f(1); f(1); g(1); g(1); "
+      "[memo_stats(f)[\"misses\"], memo_stats(f)[\"size\"], "
+      "memo_stats(g)[\"hits\"]]");
+  ::testing::internal::CaptureStdout();
+  const auto result = eval(*parser::Parser(l).parse_program(), env);
+  ASSERT_EQ(::testing::internal::GetCapturedStdout(), "1\n1\n");
+  ASSERT_EQ(result->to_string(), "[2, 0, 1, ]");
+
+  // Nor are errors.
+  auto failing = lexer::Lexer("let h = memo(fn(x) { 1 / x }); h(0)");
+  eval(*parser::Parser(failing).parse_program(), env);
+  auto stats = lexer::Lexer("memo_stats(h)[\"size\"]");
+  ASSERT_EQ(eval(*parser::Parser(stats).parse_program(), env)->to_string(),
+            "0");
+}
+
+TEST(MonkeyTreeEvalTest, InlineCaches) {
+  using Target = ast::CallExpression::Target;
+  auto l = lexer::Lexer("let call = fn(h, x) { h(x) }; let id = fn(x) { x }");
+  const auto program = parser::Parser(l).parse_program();
+  const auto& body = *dynamic_cast<const ast::FunctionLiteral&>(
+                          *dynamic_cast<const ast::LetStatement&>(
+                               *program->statements()[0])
+                               .value())
+                          .body();
+  const auto& site = dynamic_cast<const ast::CallExpression&>(
+      *dynamic_cast<const ast::ExpressionStatement&>(*body.statements()[0])
+           .expression());
+  auto env = std::make_shared<object::Env>();
+  eval(*program, env);
+
+  // Each callee is checked once, then called directly until another comes.
+  const auto cases = std::vector<std::tuple<std::string, std::string, Target>>{
+      {"call(id, 1)", "1", Target::kFunction},
+      {"call(id, 2)", "2", Target::kFunction},
+      {"call(len, \"ab\")", "2", Target::kBuiltin},
+      {"call(fn(x, y) { x }, 1)",
+       "ERROR: wrong number of arguments for fn(x, y, ) {\n\nx\n}: expected 2, "
+       "got 1",
+       Target::kUnknown},
+      {"call(fn(x) { x * 2 }, 3)", "6", Target::kFunction},
+  };
+  for (const auto& [input, expected, target] : cases) {
+    auto call = lexer::Lexer(input);
+    ASSERT_EQ(eval(*parser::Parser(call).parse_program(), env)->to_string(),
+              expected)
+        << input;
+    ASSERT_EQ(site.cache()->target, target) << input;
+  }
+
+  // Another thread replaces the entry with its own callee as a whole.
+  std::string other;
+  std::thread([&] {
+    auto call = lexer::Lexer("call(len, \"abc\")");
+    auto own = std::make_shared<object::Env>(env);
+    other = eval(*parser::Parser(call).parse_program(), own)->to_string();
+  }).join();
+  ASSERT_EQ(other, "3");
+  ASSERT_EQ(site.cache()->target, Target::kBuiltin);
+  auto again = lexer::Lexer("call(id, 7)");
+  ASSERT_EQ(eval(*parser::Parser(again).parse_program(), env)->to_string(),
+            "7");
+  ASSERT_EQ(site.cache()->target, Target::kFunction);
+
+  // Index sites switch between receivers the same way.
+  auto index = lexer::Lexer(
+      "let at = fn(c, k) { c[k] }; [at([1, 2], 1), at({\"a\": 3}, \"a\"), "
+      "at([4], 0), at({\"a\": 3}, \"b\"), at([1], 5), at([1], -1)]");
+  ASSERT_EQ(eval(*parser::Parser(index).parse_program(), env)->to_string(),
+            "[2, 3, 4, null, null, null, ]");
+  auto mismatch = lexer::Lexer("at([1], \"a\")");
+  ASSERT_EQ(eval(*parser::Parser(mismatch).parse_program(), env)->to_string(),
+            "ERROR: wrong index types for []: ARRAY[STRING]");
+}
+
+TEST(MonkeyTreeEvalTest, TailCalls) {
+  auto l = lexer::Lexer(
+      "let count = fn(n, acc) { if (n == 0) { return acc; } "
+      "return count(n - 1, acc + 1); }; "
+      "let even = fn(n) { if (n == 0) { true } else { odd(n - 1) } }; "
+      "let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } }; "
+      "let sum = fn(n) { if (n == 0) { 0 } else { n + sum(n - 1) } }");
+  const auto program = parser::Parser(l).parse_program();
+  auto env = std::make_shared<object::Env>();
+  eval(*program, env);
+
+  // Only calls whose value the function returns as is are made after it.
+  const auto call = [&](size_t index) -> const ast::CallExpression& {
+    const auto& body = *dynamic_cast<const ast::FunctionLiteral&>(
+                            *dynamic_cast<const ast::LetStatement&>(
+                                 *program->statements()[index])
+                                 .value())
+                            .body();
+    const auto& branch = dynamic_cast<const ast::IfExpression&>(
+        *dynamic_cast<const ast::ExpressionStatement&>(*body.statements()[0])
+             .expression());
+    const auto& last = *branch.alternative()->statements().back();
+    const auto& value =
+        dynamic_cast<const ast::ExpressionStatement&>(last).expression();
+    if (value->type() == ast::NodeType::kCallExpression) {
+      return dynamic_cast<const ast::CallExpression&>(*value);
+    }
+    return dynamic_cast<const ast::CallExpression&>(
+        *dynamic_cast<const ast::InfixExpression&>(*value).right());
+  };
+  ASSERT_TRUE(call(1).tail());
+  ASSERT_TRUE(call(2).tail());
+  ASSERT_FALSE(call(3).tail());
+
+  // Deep enough to overflow the native stack if each call took a frame.
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"count(1000000, 0)", "1000000"},
+      {"even(1000001)", "false"},
+      {"odd(1000001)", "true"},
+      {"sum(100)", "5050"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto run = lexer::Lexer(input);
+    ASSERT_EQ(eval(*parser::Parser(run).parse_program(), env)->to_string(),
+              expected)
+        << input;
+  }
+}
+
+// Deep enough to overflow the native stack if each tail call took a frame.
+TEST_P(MonkeyEvalTest, TailCalls) {
+  auto l = lexer::Lexer(
+      "let count = fn(n, a) { if (n == 0) { a } else { count(n - 1, a + 1) } "
+      "}; let even = fn(n) { if (n == 0) { return true; } return odd(n - 1); "
+      "}; let odd = fn(n) { if (n == 0) { false } else { even(n - 1) } }; "
+      "[count(100000, 0), even(100001), odd(100001)]");
+  auto env = std::make_shared<object::Env>();
+  ASSERT_EQ(run(*parser::Parser(l).parse_program(), env)->to_string(),
+            "[100000, false, true, ]");
+}
+
+TEST(MonkeyClosureEvalTest, CallDepth) {
+  auto l = lexer::Lexer(
+      "let sum = fn(n) { if (n == 0) { 0 } else { n + sum(n - 1) } }; "
+      "sum(1000)");
+  auto env = std::make_shared<object::Env>();
+  ASSERT_EQ(evalCompiled(*parser::Parser(l).parse_program(), env)->to_string(),
+            "500500");
+
+  // Recursion the native stack could not hold fails like any other error.
+  auto deep = lexer::Lexer("let total = sum(1000000); total");
+  ASSERT_EQ(
+      evalCompiled(*parser::Parser(deep).parse_program(), env)->to_string(),
+      "ERROR: call depth exceeded");
+  auto after = lexer::Lexer("sum(10)");
+  ASSERT_EQ(
+      evalCompiled(*parser::Parser(after).parse_program(), env)->to_string(),
+      "55");
+}
+
+TEST(MonkeyTreeEvalTest, Quickening) {
+  using Specialization = ast::InfixExpression::Specialization;
+  auto l = lexer::Lexer("let add = fn(a, b) { a + b }; add(1, 2)");
+  const auto program = parser::Parser(l).parse_program();
+  const auto& body = *dynamic_cast<const ast::FunctionLiteral&>(
+                          *dynamic_cast<const ast::LetStatement&>(
+                               *program->statements()[0])
+                               .value())
+                          .body();
+  const auto& sum = dynamic_cast<const ast::InfixExpression&>(
+      *dynamic_cast<const ast::ExpressionStatement&>(*body.statements()[0])
+           .expression());
+  ASSERT_EQ(sum.specialization(), Specialization::kUninitialized);
+
+  auto env = std::make_shared<object::Env>();
+  const auto before = quickening_stats();
+  ASSERT_EQ(eval(*program, env)->to_string(), "3");
+  ASSERT_EQ(sum.specialization(), Specialization::kIntegerAdd);
+
+  // Strings fail the guard, and the site stays generic from then on.
+  auto strings = lexer::Lexer("[add(\"a\", \"b\"), add(3, 4)]");
+  ASSERT_EQ(eval(*parser::Parser(strings).parse_program(), env)->to_string(),
+            "[ab, 7, ]");
+  ASSERT_EQ(sum.specialization(), Specialization::kGeneric);
+  const auto& after = quickening_stats();
+  ASSERT_EQ(after.deoptimizations, before.deoptimizations + 1);
+  ASSERT_EQ(after.sites[static_cast<size_t>(Specialization::kGeneric)],
+            before.sites[static_cast<size_t>(Specialization::kGeneric)] + 1);
+}
+
+TEST(MonkeyTreeEvalTest, ConcurrentQuickening) {
+  using Specialization = ast::InfixExpression::Specialization;
+  auto l = lexer::Lexer("let add = fn(a, b) { a + b }");
+  const auto program = parser::Parser(l).parse_program();
+  const auto& body = *dynamic_cast<const ast::FunctionLiteral&>(
+                          *dynamic_cast<const ast::LetStatement&>(
+                               *program->statements()[0])
+                               .value())
+                          .body();
+  const auto& sum = dynamic_cast<const ast::InfixExpression&>(
+      *dynamic_cast<const ast::ExpressionStatement&>(*body.statements()[0])
+           .expression());
+  auto env = std::make_shared<object::Env>();
+  eval(*program, env);
+
+  // One thread specializes the site to integers while the other turns it
+  // generic; the guards keep both sums right whichever rewrite wins.
+  const auto inputs = std::vector<std::pair<std::string, std::string>>{
+      {"add(1, 2)", "3"}, {"add(\"a\", \"b\")", "ab"}};
+  std::vector<size_t> wrong(inputs.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    threads.emplace_back([&, i] {
+      const auto& [input, expected] = inputs[i];
+      auto own = std::make_shared<object::Env>(env);
+      for (int run = 0; run < 200; ++run) {
+        auto call = lexer::Lexer(input);
+        if (eval(*parser::Parser(call).parse_program(), own)->to_string() !=
+            expected) {
+          ++wrong[i];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(wrong, std::vector<size_t>(inputs.size()));
+  ASSERT_NE(sum.specialization(), Specialization::kUninitialized);
+}
+
+TEST(MonkeyTreeEvalTest, FlatProgram) {
+  auto inputs = std::vector<std::string>{
+      "(5 + 10 * 2 + 15 / 3) * 2 + -10",
+      "if (1 > 2) { 10 } else { !!5 }",
+      "if (10 > 1) { if (10 > 1) { return 10; } return 1; }",
+      "let newAdder = fn(x) { fn(y) { x + y } }; newAdder(2)(3);",
+      "let a = [1, 2 * 2, \"three\"]; a[1] + len(a) + len(rest(a))",
+      "{\"one\": 1, true: 2, 3: fn(x) { x }}[3](7)",
+      "let f = fn(x) { x }; f(1, 2)",
+      "foobar",
+      "5 + true; 5;",
+  };
+  for (const auto& input : inputs) {
+    auto l = lexer::Lexer(input);
+    auto tree_env = std::make_shared<object::Env>();
+    auto expected = eval(*parser::Parser(l).parse_program(), tree_env);
+    auto flat_env = std::make_shared<object::Env>();
+    auto actual =
+        evalFlatProgram(parser::Parser(l).parse_flat_program(), flat_env);
+    ASSERT_EQ(actual->to_string(), expected->to_string()) << input;
+  }
 }
 
 }  // namespace monkey::eval
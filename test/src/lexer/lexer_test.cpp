@@ -1,8 +1,18 @@
 #include <gtest/gtest.h>
 #include <monkey/lexer/lexer.h>
+#include <monkey/lexer/location.h>
+#include <monkey/lexer/source.h>
+#include <monkey/lexer/stream.h>
 #include <monkey/lexer/token.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace monkey::lexer {
@@ -13,6 +23,14 @@ static_assert(std::ranges::forward_range<Lexer &>);
 static_assert(std::ranges::forward_range<const Lexer>);
 static_assert(std::ranges::forward_range<const Lexer &>);
 
+std::vector<uint32_t> offsets(const std::vector<Token> &tokens) {
+  auto result = std::vector<uint32_t>();
+  for (const auto &token : tokens) {
+    result.push_back(token.offset());
+  }
+  return result;
+}
+
 TEST(MonkeyLexerTest, SingleCharTokens) {
   auto lexer = Lexer("=+(){},;");
   auto expected = std::vector<Token>{
@@ -141,6 +159,149 @@ TEST(MonkeyLexerTest, Expressions) {
   ASSERT_TRUE(std::ranges::equal(lexer, expected));
 }
 
+TEST(MonkeyLexerTest, Tokenize) {
+  auto lexer = Lexer("let add = fn(x, y) { x + y; }; \"unterminated");
+  auto tokens = lexer.tokenize();
+  ASSERT_FALSE(tokens.empty());
+  ASSERT_EQ(tokens.back().type(), TokenType::kEOF);
+  tokens.pop_back();
+  ASSERT_TRUE(std::ranges::equal(lexer, tokens));
+}
+
+TEST(MonkeyLexerTest, LiteralsViewIntoSource) {
+  const auto input = std::string("let answer = \"forty\" == 42;");
+  auto lexer = Lexer(input);
+  auto tokens = lexer.tokenize();
+  tokens.pop_back();
+  const auto *base = tokens.front().literal().data();
+  for (const auto &token : tokens) {
+    const auto offset = static_cast<size_t>(token.literal().data() - base);
+    ASSERT_EQ(input.substr(offset, token.literal().size()), token.literal());
+  }
+}
+
+TEST(MonkeyLexerTest, LongRuns) {
+  const auto identifier = std::string(100, 'a') + "_" + std::string(40, 'Z');
+  const auto integer = std::string(70, '7');
+  const auto text = std::string(90, 'x') + " {}[] " + std::string(33, 'y');
+  auto lexer = Lexer(std::string(50, ' ') + identifier + "\n\t\r " + integer +
+                     "\"" + text + "\"" + std::string(37, '\n') + "return");
+  auto expected = std::vector<Token>{
+      Token(TokenType::kIdentifer, identifier),
+      Token(TokenType::kInteger, integer),
+      Token(TokenType::kString, text),
+      Token(TokenType::kReturn, "return"),
+  };
+  ASSERT_TRUE(std::ranges::equal(lexer, expected));
+}
+
+TEST(MonkeyLexerTest, KeywordLookalikes) {
+  auto lexer = Lexer("fn fun if iff els else lets let returns truex false");
+  auto expected = std::vector<Token>{
+      Token(TokenType::kFunction, "fn"),   Token(TokenType::kIdentifer, "fun"),
+      Token(TokenType::kIf, "if"),         Token(TokenType::kIdentifer, "iff"),
+      Token(TokenType::kIdentifer, "els"), Token(TokenType::kElse, "else"),
+      Token(TokenType::kIdentifer, "lets"), Token(TokenType::kLet, "let"),
+      Token(TokenType::kIdentifer, "returns"),
+      Token(TokenType::kIdentifer, "truex"),
+      Token(TokenType::kFalse, "false"),
+  };
+  ASSERT_TRUE(std::ranges::equal(lexer, expected));
+}
+
+TEST(MonkeyLexerTest, MappedFileSource) {
+  const auto input = std::string("let greeting = \"hello\"; greeting == 42;");
+  const auto path = testing::TempDir() + "monkey_lexer_test.mk";
+  std::ofstream(path) << input;
+  auto mapped = Lexer(std::make_shared<MappedFileSource>(path));
+  auto copied = Lexer(input);
+  ASSERT_EQ(mapped.tokenize(), copied.tokenize());
+  std::remove(path.c_str());
+
+  ASSERT_THROW(MappedFileSource{path}, SourceError);
+}
+
+TEST(MonkeyLexerTest, ChunkedLexer) {
+  const auto input = std::string(
+      "let add = fn(x, y) { x + y; };\n"
+      "let s = \"semi; colons {{ inside\";\n"
+      "if (add(1, 2) == 3) { puts(s); } else { 0 };\n"
+      "let unfinished = [1, 2");
+  const auto whole = Lexer(input);
+  const auto expected = whole.tokenize();
+  for (size_t chunk_size = 1; chunk_size <= input.size(); ++chunk_size) {
+    auto lexer = ChunkedLexer();
+    for (size_t offset = 0; offset < input.size(); offset += chunk_size) {
+      lexer.feed(std::string_view(input).substr(offset, chunk_size));
+    }
+    lexer.finish();
+
+    std::vector<TokenBatch> batches;
+    auto tokens = std::vector<Token>();
+    while (auto batch = lexer.next_batch()) {
+      ASSERT_EQ(batch->tokens.back().type(), TokenType::kEOF);
+      tokens.insert(tokens.end(), batch->tokens.begin(),
+                    batch->tokens.end() - 1);
+      batches.push_back(std::move(*batch));
+    }
+    tokens.push_back(expected.back());
+    ASSERT_EQ(tokens, expected) << "chunk size " << chunk_size;
+    ASSERT_EQ(offsets(tokens), offsets(expected))
+        << "chunk size " << chunk_size;
+    if (chunk_size == 1) {
+      ASSERT_EQ(batches.size(), 4);
+    }
+  }
+}
+
+TEST(MonkeyLexerTest, BatchedLexer) {
+  const auto input = std::string(
+      "let a = \"x; y\"; let b = fn() { a; };\n"
+      "let c = [1, 2];\n"
+      "c[0]");
+  const auto whole = Lexer(input);
+  const auto expected = whole.tokenize();
+  for (size_t batch_size = 1; batch_size <= input.size(); ++batch_size) {
+    auto lexer = BatchedLexer(std::make_shared<StringSource>(input), batch_size);
+    auto tokens = std::vector<Token>();
+    while (auto batch = lexer.next_batch()) {
+      tokens.insert(tokens.end(), batch->tokens.begin(),
+                    batch->tokens.end() - 1);
+    }
+    tokens.push_back(expected.back());
+    ASSERT_EQ(tokens, expected) << "batch size " << batch_size;
+    ASSERT_EQ(offsets(tokens), offsets(expected))
+        << "batch size " << batch_size;
+  }
+}
+
+TEST(MonkeyLexerTest, Locations) {
+  const auto input = std::string("let x = 5;\n\n  x + \"a\nb\";\n");
+  const auto source = std::make_shared<StringSource>(input);
+  const auto tokens = Lexer(source).tokenize();
+  ASSERT_EQ(offsets(tokens),
+            (std::vector<uint32_t>{0, 4, 6, 8, 9, 14, 16, 18, 23, 25}));
+  // Offsets only locate a token; they play no part in equality.
+  ASSERT_EQ(Token(TokenType::kIdentifer, "x", 4),
+            Token(TokenType::kIdentifer, "x"));
+
+  // A slice reports offsets into the whole file.
+  const auto slice = std::make_shared<SourceSlice>(
+      source, source->text().substr(13));
+  ASSERT_EQ(Lexer(slice).tokenize().front().offset(), 14);
+
+  const auto lines = LineTable(source);
+  ASSERT_EQ(lines.line_count(), 5);
+  ASSERT_EQ(lines.locate(0), (Location{1, 1}));
+  ASSERT_EQ(lines.locate(9), (Location{1, 10}));
+  ASSERT_EQ(lines.locate(10), (Location{1, 11}));
+  ASSERT_EQ(lines.locate(11), (Location{2, 1}));
+  ASSERT_EQ(lines.locate(14), (Location{3, 3}));
+  ASSERT_EQ(lines.locate(20), (Location{3, 9}));
+  ASSERT_EQ(lines.locate(21), (Location{4, 1}));
+  ASSERT_EQ(lines.locate(1000), (Location{5, 1}));
+}
+
 }  // namespace monkey::lexer
 
 int main(int argc, char **argv) {
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include <monkey/eval/eval.h>
+#include <monkey/lexer/lexer.h>
+#include <monkey/object/env.h>
+#include <monkey/opt/optimizer.h>
+#include <monkey/parser/parser.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace monkey::opt {
+
+std::shared_ptr<ast::Program> parse(const std::string& input) {
+  auto lexer = lexer::Lexer(input);
+  return parser::Parser(lexer).parse_program();
+}
+
+std::string run(const std::shared_ptr<ast::Program>& program) {
+  auto env = std::make_shared<object::Env>();
+  return eval::eval(*program, env)->to_string();
+}
+
+TEST(MonkeyOptTest, FoldConstants) {
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"60 * 60 * 24", "86400"},
+      {"-(2 + 3) * 4 == -20", "true"},
+      {"!(1 < 2)", "false"},
+      {"\"a\" + \"b\"", "ab"},
+      {"let x = 2 * 3; x + 1 + 2", "let x = 6;\n((x + 1) + 2)"},
+      {"1 / 0", "(1 / 0)"},
+      {"1 + true", "(1 + true)"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto optimizer = Optimizer(1);
+    ASSERT_EQ(optimizer.run(parse(input))->to_string(), expected) << input;
+  }
+}
+
+TEST(MonkeyOptTest, PruneBranches) {
+  const auto cases = std::vector<std::pair<std::string, std::string>>{
+      {"if (true) { 1 } else { 2 }", "1"},
+      {"if (1 > 2) { 1 } else { let a = 2; a }",
+       "if (true) {\nlet a = 2;\na}"},
+      {"if (\"\") { 1 }", "1"},
+      {"if (false) { 1 }", "if (false) {}"},
+  };
+  for (const auto& [input, expected] : cases) {
+    auto optimizer = Optimizer(1);
+    auto program = optimizer.run(parse(input));
+    ASSERT_EQ(program->to_string(), expected) << input;
+    ASSERT_EQ(run(program), run(parse(input))) << input;
+  }
+
+  // Nothing to prune leaves the tree shared with the input.
+  auto optimizer = Optimizer(1);
+  const auto input = parse("let f = fn(x) { if (x) { 1 } };");
+  ASSERT_EQ(optimizer.run(input)->statements(), input->statements());
+}
+
+TEST(MonkeyOptTest, DropUnused) {
+  auto optimizer = Optimizer(2);
+  auto program = optimizer.run(parse(
+      "1; \"s\"; [1, fn() { 2 }]; x; let f = fn() { 3; return 4; 5 }; f()"));
+  ASSERT_EQ(program->to_string(), "x\nlet f = fn() {\nreturn 4;};\nf()");
+
+  // The last statement is the program's value and stays.
+  program = optimizer.run(parse("let a = 1; 2"));
+  ASSERT_EQ(program->to_string(), "let a = 1;\n2");
+}
+
+TEST(MonkeyOptTest, KeepsOffsetShifts) {
+  // As an incremental reparse hands over statements moved in the text.
+  const auto parsed = parse("let a = 1; 2; let b = a; 3; b");
+  const auto input = std::make_shared<ast::Program>(
+      parsed->statements(), parsed->arena(),
+      std::vector<uint32_t>{1, 2, 3, 4, 5});
+  auto optimizer = Optimizer(2);
+  const auto program = optimizer.run(input);
+  ASSERT_EQ(program->to_string(), "let a = 1;\nlet b = a;\nb");
+  const auto expected = std::vector<uint32_t>{1, 3, 5};
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(program->offset_shift(i), expected[i]) << i;
+  }
+}
+
+TEST(MonkeyOptTest, PipelineKeepsResults) {
+  const auto inputs = std::vector<std::string>{
+      "let day = 60 * 60 * 24; day / (6 * 4)",
+      "let f = fn(n) { if (n < 2 * 1) { return n; } 1; f(n - 1) + n }; f(10)",
+      "let a = [1 + 1, 2 * 2]; a[3 - 2]",
+      "let h = {\"a\" + \"b\": !false}; h[\"ab\"]",
+      "if (10 > 1) { if (10 > 1) { return 10; } return 1; }",
+      "let g = fn() { if (false) { 1 } }; g()",
+  };
+  for (const auto& input : inputs) {
+    auto optimizer = Optimizer(Optimizer::kMaxLevel);
+    ASSERT_EQ(run(optimizer.run(parse(input))), run(parse(input))) << input;
+  }
+}
+
+TEST(MonkeyOptTest, Stats) {
+  auto optimizer = Optimizer(2);
+  const auto input = parse("let a = 1 + 2 * 3; if (true) { 5 }; 7; a");
+  const auto program = optimizer.run(input);
+  ASSERT_EQ(program->to_string(), "let a = 7;\na");
+  ASSERT_EQ(optimizer.stats().size(), 3);
+  ASSERT_EQ(optimizer.stats()[0].name, "fold-constants");
+  ASSERT_EQ(optimizer.stats()[0].rewrites, 2);
+  ASSERT_EQ(optimizer.stats()[1].rewrites, 1);
+  ASSERT_EQ(optimizer.stats()[2].rewrites, 2);
+
+  // The input is left as it was, and level 0 hands it back untouched.
+  ASSERT_EQ(input->to_string(),
+            "let a = (1 + (2 * 3));\nif (true) {\n5}\n7\na");
+  ASSERT_EQ(Optimizer().run(input), input);
+}
+
+}  // namespace monkey::opt
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,14 +1,28 @@
+#include <fmt/core.h>
 #include <gtest/gtest.h>
 #include <monkey/ast/ast.h>
+#include <monkey/ast/binary.h>
 #include <monkey/ast/expr.h>
+#include <monkey/ast/flat.h>
+#include <monkey/ast/resolver.h>
 #include <monkey/ast/stmt.h>
+#include <monkey/ast/symbol.h>
 #include <monkey/lexer/lexer.h>
+#include <monkey/lexer/source.h>
 #include <monkey/lexer/token.h>
+#include <monkey/parser/cache.h>
+#include <monkey/parser/error.h>
+#include <monkey/parser/incremental.h>
+#include <monkey/parser/parallel.h>
 #include <monkey/parser/parser.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
 #include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <utility>
@@ -386,6 +400,407 @@ TEST(MonkeyParserTest, IfExpression) {
       }));
 }
 
+TEST(MonkeyParserTest, Symbols) {
+  const auto name = std::string("symbol_test_name");
+  const auto symbol = ast::Symbol::intern(name);
+  ASSERT_EQ(symbol, ast::Symbol::intern("symbol_test_name"));
+  ASSERT_NE(symbol, ast::Symbol::intern("symbol_test_other"));
+  ASSERT_EQ(symbol.name(), name);
+  ASSERT_EQ(ast::Symbol().name(), "");
+
+  // Concurrent interning agrees on one id per name.
+  std::vector<std::vector<ast::Symbol>> interned(4);
+  {
+    std::vector<std::jthread> threads;
+    for (auto& symbols : interned) {
+      threads.emplace_back([&symbols] {
+        for (int i = 0; i < 2000; ++i) {
+          symbols.push_back(ast::Symbol::intern(fmt::format("t{}", i)));
+        }
+      });
+    }
+  }
+  for (const auto& symbols : interned) {
+    ASSERT_EQ(symbols, interned.front());
+  }
+  ASSERT_EQ(interned.front()[42].name(), "t42");
+
+  auto lexer = lexer::Lexer(std::string("let x = fn(x) { x };"));
+  const auto program = Parser(lexer).parse_program();
+  const auto& let = dynamic_cast<const ast::LetStatement&>(
+      *program->statements().front());
+  const auto& function =
+      dynamic_cast<const ast::FunctionLiteral&>(*let.value());
+  ASSERT_EQ(let.name()->symbol(), function.parameters().front()->symbol());
+}
+
+TEST(MonkeyParserTest, FlatProgram) {
+  auto inputs = std::vector<std::string>{
+      "let x = 5; let y = x; return x + y * -2;",
+      "if (x < y) { x } else { y }; if (true) { [1, \"two\", x[0]] }",
+      "let add = fn(a, b) { a + b }; add(1, add(2, 3)); {\"k\": fn() {}}",
+  };
+  for (const auto& input : inputs) {
+    auto lexer = lexer::Lexer(input);
+    auto program = Parser(lexer).parse_program();
+    auto flat = Parser(lexer).parse_flat_program();
+    ASSERT_EQ(flat->to_string(), program->to_string());
+  }
+
+  auto lexer = lexer::Lexer("let x = 1; x + x; let x = x * x;");
+  auto flat = Parser(lexer).parse_flat_program();
+  ASSERT_EQ(flat->statements().size(), 3);
+  const auto& let = flat->node(flat->statements()[0]);
+  const auto& sum = flat->node(flat->node(flat->statements()[1]).a);
+  ASSERT_EQ(let.type, ast::NodeType::kLetStatement);
+  ASSERT_EQ(sum.type, ast::NodeType::kInfixExpression);
+  ASSERT_EQ(flat->node(sum.a).a, let.a);
+  ASSERT_EQ(flat->node(sum.b).a, let.a);
+}
+
+TEST(MonkeyParserTest, ParallelParser) {
+  std::string input;
+  for (int i = 0; i < 200; ++i) {
+    input += "let f = fn(x) { if (x < 1) { \"a;b\" } else { let y = x; [y, 2] } };\n";
+    input += "f(1) + {\"k\": (1 + 2) * 3}[\"k\"];\n";
+  }
+  auto source = std::make_shared<lexer::StringSource>(input);
+  auto lexer = lexer::Lexer(source);
+  auto expected = Parser(lexer).parse_program();
+  for (const size_t chunk_size : {size_t{1}, size_t{64}, size_t{4096}}) {
+    auto program = ParallelParser(source, 4, chunk_size).parse_program();
+    ASSERT_EQ(*program, *expected);
+  }
+
+  auto broken = std::make_shared<lexer::StringSource>(
+      input + "let = 1;\n" + input + "let x 2;\n");
+  std::string expected_error;
+  try {
+    Parser(lexer::Lexer(broken)).parse_program();
+  } catch (const ParserError& e) {
+    expected_error = e.what();
+  }
+  ASSERT_FALSE(expected_error.empty());
+  try {
+    ParallelParser(broken, 4, 64).parse_program();
+    FAIL();
+  } catch (const ParserError& e) {
+    ASSERT_EQ(std::string(e.what()), expected_error);
+  }
+}
+
+TEST(MonkeyParserTest, IncrementalParser) {
+  const auto parse = [](std::string_view text) {
+    auto lexer = lexer::Lexer(std::string(text));
+    return Parser(lexer).parse_program();
+  };
+  auto parser = IncrementalParser(
+      "let a = 1;\nlet b = fn(x) { x; };\nlet c = \"s;t\";\nc + a");
+  ASSERT_EQ(*parser.program(), *parse(parser.text()));
+
+  // Editing one statement reparses only that statement.
+  auto previous = parser.program();
+  auto result = parser.apply({.offset = 8, .removed = 1, .inserted = "42"});
+  ASSERT_EQ(parser.text().substr(0, 12), "let a = 42;\n");
+  ASSERT_EQ(*result.program, *parse(parser.text()));
+  ASSERT_EQ(result.changed, std::vector<size_t>{0});
+  for (size_t i = 1; i < 4; ++i) {
+    ASSERT_EQ(result.program->statements()[i], previous->statements()[i]);
+  }
+
+  // Statements after an edit that changes the length are where they moved to,
+  // while the previous program keeps its offsets.
+  const auto offsets = [](const ast::Program& program) {
+    std::vector<uint32_t> moved;
+    for (size_t i = 0; i < program.statements().size(); ++i) {
+      moved.push_back(program.offset(*program.statements()[i], i));
+    }
+    return moved;
+  };
+  const auto before = offsets(*parser.program());
+  const auto& let = dynamic_cast<const ast::LetStatement&>(
+      *parser.program()->statements()[1]);
+  const auto& function =
+      dynamic_cast<const ast::FunctionLiteral&>(*let.value());
+  const auto parameter = function.parameters()[0]->offset();
+  previous = parser.program();
+  result =
+      parser.apply({.offset = 0, .removed = 0, .inserted = "let z = 0;\n"});
+  ASSERT_EQ(offsets(*result.program),
+            (std::vector<uint32_t>{0, before[0] + 11, before[1] + 11,
+                                   before[2] + 11, before[3] + 11}));
+  ASSERT_EQ(function.parameters()[0]->offset(), parameter);
+  ASSERT_EQ(result.program->offset(*function.parameters()[0], 2),
+            previous->offset(*function.parameters()[0], 1) + 11);
+  ASSERT_EQ(offsets(*previous), before);
+  ASSERT_EQ(offsets(*result.program), offsets(*parse(parser.text())));
+  result = parser.apply({.offset = 0, .removed = 11, .inserted = ""});
+  ASSERT_EQ(offsets(*result.program), before);
+
+  // Edits that move statement boundaries still match a full parse.
+  const auto replacements = std::vector<std::pair<std::string, std::string>>{
+      {"let a = 42;", "let a = 42; let d = 2; let e = 3;"},
+      {"let d = 2; ", ""},
+      {"x; }", "x }"},
+      {"\"s;t\";", "\"s\" + \"t\";"},
+      {"c + a", "let f = [1, 2]; c + len(f)"},
+      {"let a = 42;", ""},
+      {";\nlet b", "\nlet b"},
+      {"let e = 3", "let e = \"e;\" + b(\";\")"},
+  };
+  for (const auto& [from, to] : replacements) {
+    const auto offset = parser.text().find(from);
+    ASSERT_NE(offset, std::string_view::npos) << from;
+    result = parser.apply(
+        {.offset = offset, .removed = from.size(), .inserted = to});
+    ASSERT_EQ(*result.program, *parse(parser.text())) << parser.text();
+    ASSERT_EQ(offsets(*result.program), offsets(*parse(parser.text())))
+        << parser.text();
+    ASSERT_LE(result.changed.size(), 3);
+  }
+
+  // A failed edit leaves the parser untouched.
+  const auto text = std::string(parser.text());
+  ASSERT_THROW(parser.apply({.offset = 0, .removed = 0, .inserted = "let ;"}),
+               ParserError);
+  ASSERT_THROW(
+      parser.apply({.offset = text.size() + 1, .removed = 0, .inserted = ""}),
+      InvalidEditError);
+  ASSERT_EQ(parser.text(), text);
+  ASSERT_EQ(*parser.program(), *parse(text));
+}
+
+TEST(MonkeyParserTest, RecoveringParse) {
+  // Diagnostics view the source, so the caller keeps it alive.
+  const auto parse = [](const std::shared_ptr<const lexer::Source>& source) {
+    return Parser(lexer::Lexer(source)).parse_program_recovering();
+  };
+  const auto valid = std::string(
+      "let a = 1;\nlet f = fn(x) { if (x) { [x, {\"k\": x}] } };\nf(a);");
+  auto result = parse(std::make_shared<lexer::StringSource>(valid));
+  ASSERT_TRUE(result.ok());
+  ASSERT_EQ(*result.program, *Parser(lexer::Lexer(valid)).parse_program());
+
+  // Every broken statement is reported once and the rest are kept.
+  const auto broken = std::make_shared<lexer::StringSource>(
+      "let = 1;\n"
+      "let g = fn(x) { let y x; x + };\n"
+      "let b = 2;\n"
+      "let h = {1 2};\n"
+      "99999999999999999999;\n"
+      "b * 3");
+  result = parse(broken);
+  ASSERT_FALSE(result.ok());
+  const auto messages = std::vector<std::string>{
+      PeekTokenError::message(lexer::TokenType::kIdentifer,
+                              lexer::TokenType::kAssign),
+      PeekTokenError::message(lexer::TokenType::kAssign,
+                              lexer::TokenType::kIdentifer),
+      PeekTokenError::message(lexer::TokenType::kColon,
+                              lexer::TokenType::kInteger),
+      InvalidIntegerError::message("99999999999999999999"),
+  };
+  ASSERT_EQ(result.diagnostics.size(), messages.size());
+  for (size_t i = 0; i < messages.size(); ++i) {
+    ASSERT_EQ(result.diagnostics[i].message, messages[i]);
+  }
+  ASSERT_EQ(result.diagnostics[1].token.literal(), "x");
+  ASSERT_EQ(result.program->to_string(), "let b = 2;\n(b * 3)");
+
+  ASSERT_THROW(Parser(lexer::Lexer(std::string("let = 1;"))).parse_program(),
+               PeekTokenError);
+}
+
+TEST(MonkeyParserTest, BinaryProgram) {
+  const auto input = std::string(
+      "let a = 9223372036854775807; let b = -a - 1; return !true == false;\n"
+      "let f = fn(x, y) { if (x < y) { [x, \"s;\\0\", {}] } };\n"
+      "if (f(1, 2)[0]) { {\"k\": fn() { a }, 2: b} } else { let a = a; a }");
+  const auto key = ast::source_key(input);
+  const auto program = Parser(lexer::Lexer(input)).parse_program();
+  const auto bytes = ast::encode(*program, key);
+  ASSERT_EQ(*ast::decode(bytes, key), *program);
+
+  // Anything short of the whole encoding, or for another source, is refused.
+  for (size_t size = 0; size < bytes.size(); ++size) {
+    ASSERT_THROW(ast::decode(std::string_view(bytes).substr(0, size), key),
+                 ast::FormatError);
+  }
+  ASSERT_THROW(ast::decode(bytes + '\0', key), ast::FormatError);
+  ASSERT_THROW(ast::decode(bytes, ast::source_key(input + " ")),
+               ast::FormatError);
+  auto future = bytes;
+  future[4] = static_cast<char>(ast::kBinaryVersion + 1);
+  ASSERT_THROW(ast::decode(future, key), ast::FormatError);
+  ASSERT_NE(ast::source_key("let a = 1;").hash,
+            ast::source_key("let a = 2;").hash);
+}
+
+TEST(MonkeyParserTest, Locations) {
+  const auto input = std::string("let x = 1;\nx + f(2)[0];");
+  const auto lexer = lexer::Lexer(input);
+  const auto program = Parser(lexer).parse_program();
+  const auto check = [](const ast::Program& tree) {
+    const auto& let =
+        dynamic_cast<const ast::LetStatement&>(*tree.statements()[0]);
+    ASSERT_EQ(let.offset(), 0);
+    ASSERT_EQ(let.name()->offset(), 4);
+    ASSERT_EQ(let.value()->offset(), 8);
+    const auto& statement =
+        dynamic_cast<const ast::ExpressionStatement&>(*tree.statements()[1]);
+    ASSERT_EQ(statement.offset(), 11);
+    // Operators locate their expression, so a chain points at each link.
+    const auto& sum =
+        dynamic_cast<const ast::InfixExpression&>(*statement.expression());
+    ASSERT_EQ(sum.offset(), 13);
+    const auto& index = dynamic_cast<const ast::IndexExpression&>(*sum.right());
+    ASSERT_EQ(index.offset(), 19);
+    ASSERT_EQ(index.left()->offset(), 16);
+  };
+  check(*program);
+
+  const auto key = ast::source_key(input);
+  check(*ast::decode(ast::encode(*program, key), key));
+
+  const auto flat = ast::flatten(*program);
+  ASSERT_EQ(flat->offset(flat->statements()[1]), 11);
+  ASSERT_EQ(flat->offset(flat->node(flat->statements()[1]).a), 13);
+}
+
+TEST(MonkeyParserTest, Resolve) {
+  const auto program =
+      Parser(lexer::Lexer(std::string(
+                 "let g = 1; let f = fn(a) { let h = fn() { a + b + g }; "
+                 "let b = 2; if (a) { let c = a; c } }; "
+                 "if (g) { let d = 3; d }")))
+          .parse_program();
+  ast::resolve(*program);
+
+  const auto& let_f =
+      dynamic_cast<const ast::LetStatement&>(*program->statements()[1]);
+  ASSERT_TRUE(let_f.name()->address().global());
+  const auto& f = dynamic_cast<const ast::FunctionLiteral&>(*let_f.value());
+  // a and b, then h, then c in the nested block.
+  ASSERT_EQ(f.frame_size(), 4);
+  ASSERT_TRUE(f.captures().empty());
+  ASSERT_EQ(f.parameters()[0]->address(),
+            (ast::Address{ast::Address::Kind::kLocal, 0}));
+
+  const auto& let_h =
+      dynamic_cast<const ast::LetStatement&>(*f.body()->statements()[0]);
+  ASSERT_EQ(let_h.name()->address(),
+            (ast::Address{ast::Address::Kind::kLocal, 1}));
+  const auto& h = dynamic_cast<const ast::FunctionLiteral&>(*let_h.value());
+  const auto& sum = dynamic_cast<const ast::InfixExpression&>(
+      *dynamic_cast<const ast::ExpressionStatement&>(*h.body()->statements()[0])
+           .expression());
+  const auto& a_plus_b = dynamic_cast<const ast::InfixExpression&>(*sum.left());
+  const auto& a = dynamic_cast<const ast::Identifier&>(*a_plus_b.left());
+  const auto& b = dynamic_cast<const ast::Identifier&>(*a_plus_b.right());
+  const auto& g = dynamic_cast<const ast::Identifier&>(*sum.right());
+  // h copies a, but keeps the frame for b: it may run before b is set.
+  ASSERT_EQ(a.address(), (ast::Address{ast::Address::Kind::kCapture, 0}));
+  ASSERT_TRUE(a.fallbacks().empty());
+  ASSERT_EQ(b.address(), (ast::Address{ast::Address::Kind::kFrame, 0, 2}));
+  ASSERT_TRUE(g.address().global());
+  ASSERT_EQ(h.captures(), (std::vector<ast::Capture>{
+                              {ast::Capture::Source::kSlot, 0}}));
+  ASSERT_EQ(h.captured_frames(), (std::vector<ast::Capture>{
+                                     {ast::Capture::Source::kFrame, 0}}));
+  // h keeps f's frame, which must then outlive the call; h's own does not.
+  ASSERT_TRUE(f.frame_escapes());
+  ASSERT_FALSE(h.frame_escapes());
+
+  const auto& branch = dynamic_cast<const ast::IfExpression&>(
+      *dynamic_cast<const ast::ExpressionStatement&>(*f.body()->statements()[2])
+           .expression());
+  ASSERT_EQ(branch.consequence()->frame_size(), 0);
+  const auto& top = dynamic_cast<const ast::IfExpression&>(
+      *dynamic_cast<const ast::ExpressionStatement&>(*program->statements()[2])
+           .expression());
+  ASSERT_EQ(top.consequence()->frame_size(), 1);
+  ASSERT_FALSE(top.consequence()->frame_escapes());
+
+  // Functions in between capture a variable to pass it on.
+  const auto nested =
+      Parser(lexer::Lexer(std::string("fn(x) { fn() { fn() { x } } }")))
+          .parse_program();
+  ast::resolve(*nested);
+  const auto* outer = dynamic_cast<const ast::FunctionLiteral*>(
+      dynamic_cast<const ast::ExpressionStatement&>(*nested->statements()[0])
+          .expression()
+          .get());
+  const auto inner = [](const ast::FunctionLiteral& function) {
+    return dynamic_cast<const ast::FunctionLiteral*>(
+        dynamic_cast<const ast::ExpressionStatement&>(
+            *function.body()->statements()[0])
+            .expression()
+            .get());
+  };
+  ASSERT_EQ(inner(*outer)->captures(), (std::vector<ast::Capture>{
+                                           {ast::Capture::Source::kSlot, 0}}));
+  ASSERT_EQ(inner(*inner(*outer))->captures(),
+            (std::vector<ast::Capture>{{ast::Capture::Source::kCapture, 0}}));
+}
+
+TEST(MonkeyParserTest, StaticTypes) {
+  const auto types = [](const std::string& input) {
+    const auto program = Parser(lexer::Lexer(input)).parse_program();
+    ast::resolve(*program);
+    const auto& f = dynamic_cast<const ast::FunctionLiteral&>(
+        *dynamic_cast<const ast::ExpressionStatement&>(
+             *program->statements()[0])
+             .expression());
+    std::vector<ast::StaticType> result;
+    for (const auto& statement : f.body()->statements()) {
+      if (statement->type() == ast::NodeType::kExpressionStatement) {
+        result.push_back(
+            dynamic_cast<const ast::ExpressionStatement&>(*statement)
+                .expression()
+                ->static_type());
+      }
+    }
+    return result;
+  };
+  using enum ast::StaticType;
+
+  ASSERT_EQ(types("fn(x) { 1 + 2; x + 1; x - 1; -x; x < 1; x == \"a\"; !x; "
+                  "x; f(1) }"),
+            (std::vector{kInteger, kUnknown, kInteger, kInteger, kBoolean,
+                         kBoolean, kBoolean, kUnknown, kUnknown}));
+  // A local has the type of its last let; a frame captured whole does not.
+  ASSERT_EQ(types("fn(x) { let y = x * 2; y + 1; let y = true; y; "
+                  "let x = 3; x + 1; fn() { y }; let z = 1; z + 1 }"),
+            (std::vector{kInteger, kBoolean, kInteger, kUnknown, kInteger}));
+}
+
+TEST(MonkeyParserTest, ProgramCache) {
+  const auto directory =
+      std::filesystem::temp_directory_path() /
+      fmt::format("monkey-cache-test-{}", ::testing::UnitTest::GetInstance()
+                                              ->random_seed());
+  std::filesystem::remove_all(directory);
+  const auto cache = ProgramCache(directory / "nested");
+  const auto input = std::string("let x = fn(n) { n * 2 }; x(21)");
+  const auto key = ast::source_key(input);
+  ASSERT_EQ(cache.load(key), nullptr);
+
+  const auto program = Parser(lexer::Lexer(input)).parse_program();
+  ASSERT_TRUE(cache.store(key, *program));
+  const auto loaded = cache.load(key);
+  ASSERT_NE(loaded, nullptr);
+  ASSERT_EQ(*loaded, *program);
+  ASSERT_EQ(cache.load(ast::source_key(input + ";")), nullptr);
+
+  // A damaged entry is a miss until it is stored again.
+  std::ofstream(cache.path(key), std::ios::binary | std::ios::trunc)
+      << "MKC\n garbage";
+  ASSERT_EQ(cache.load(key), nullptr);
+  ASSERT_TRUE(cache.store(key, *program));
+  ASSERT_EQ(*cache.load(key), *program);
+  std::filesystem::remove_all(directory);
+}
+
 }  // namespace monkey::parser
 
 int main(int argc, char** argv) {